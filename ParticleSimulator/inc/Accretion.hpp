@@ -0,0 +1,83 @@
+/**
+  ******************************************************************************
+  * @file    Accretion.hpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    17 OCT 2026
+  * @brief   Header for Accretion.cpp
+  ******************************************************************************
+  * @attention
+  *
+  * Merge mode: touching particles coalesce into one instead of bouncing, so N
+  * shrinks as a scene clumps together. A touching pair merges when the heavier
+  * particle is at least the mass ratio times the lighter one, or when their
+  * relative speed is below the speed threshold. The heavier particle keeps the
+  * combined mass, momentum and center of mass; the lighter one is marked, and
+  * every marked particle is removed in one ParticleData::RemoveMarked pass.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion ------------------------------------ */
+#ifndef __ACCRETION_HPP
+#define __ACCRETION_HPP
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "CollisionGrid.hpp"
+#include "ParticleData.hpp"
+
+/* Exported types ----------------------------------------------------------- */
+/* Exported constants ------------------------------------------------------- */
+
+constexpr double MERGE_MASS_RATIO     = 10.0;   // Touching particles merge when one is at least this many times heavier (0 disables)
+constexpr double MERGE_RELATIVE_SPEED = 0.5;    // Touching particles merge when their relative speed is below this (0 disables)
+
+/* Exported macro ----------------------------------------------------------- */
+/* Exported variables ------------------------------------------------------- */
+/* Exported functions ------------------------------------------------------- */
+/* Forward declarations ----------------------------------------------------- */
+/* Class definition --------------------------------------------------------- */
+
+class AccretionSolver
+{
+public:
+    /* Public member variables -------------------------------------------------- */
+    /* Public member functions -------------------------------------------------- */
+
+    AccretionSolver();
+
+    size_t Merge(ParticleData& particles, double massRatio, double relativeSpeed);
+
+    /* Getters ------------------------------------------------------------------ */
+
+    size_t GetMergeCount() const;
+    size_t GetTotalMergeCount() const;
+
+    /* Setters ------------------------------------------------------------------ */
+private:
+    /* Private member variables ------------------------------------------------- */
+
+    size_t               mergeCount;        // Particles absorbed by the last Merge
+    size_t               totalMergeCount;   // Particles absorbed since construction
+    CollisionGrid        grid;              // Cell list over the current positions
+    ContactBuffer        contacts;          // Touching pairs, each once, in index order
+    std::vector<uint8_t> removed;           // 1 for particles absorbed this pass
+    std::vector<size_t>  neighbors;         // Reusable neighbor query buffer
+
+    /* Private member functions ------------------------------------------------- */
+
+    static bool IsMerging(const ParticleData& particles, size_t i, size_t j, double massRatio, double relativeSpeed);
+    static void Absorb(ParticleData& particles, size_t survivor, size_t absorbed);
+
+    /* Getters ------------------------------------------------------------------ */
+    /* Setters ------------------------------------------------------------------ */
+};
+
+
+
+#endif /* __ACCRETION_HPP */
+
+/******************************** END OF FILE *********************************/
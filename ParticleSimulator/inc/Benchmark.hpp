@@ -0,0 +1,43 @@
+/**
+  ******************************************************************************
+  * @file    Benchmark.hpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   Header for Benchmark.cpp
+  ******************************************************************************
+  * @attention
+  *
+  * Headless timing runs, started with the --benchmark command-line flag.
+  * Results are written to the console.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion ------------------------------------ */
+#ifndef __BENCHMARK_HPP
+#define __BENCHMARK_HPP
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+/* Exported types ----------------------------------------------------------- */
+/* Exported constants ------------------------------------------------------- */
+
+constexpr int BENCHMARK_REPETITIONS = 10;   // Timed runs per measurement (best run is reported)
+
+/* Exported macro ----------------------------------------------------------- */
+/* Exported variables ------------------------------------------------------- */
+/* Exported functions ------------------------------------------------------- */
+
+void RunBenchmarks(size_t particleCount);
+
+/* Forward declarations ----------------------------------------------------- */
+/* Class definition --------------------------------------------------------- */
+
+
+
+#endif /* __BENCHMARK_HPP */
+
+/******************************** END OF FILE *********************************/
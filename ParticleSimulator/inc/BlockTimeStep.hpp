@@ -0,0 +1,89 @@
+/**
+  ******************************************************************************
+  * @file    BlockTimeStep.hpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   Header for BlockTimeStep.cpp
+  ******************************************************************************
+  * @attention
+  *
+  * Hierarchical (power-of-two) block timesteps. A frame of length timeStep is
+  * split into 2^BLOCK_MAX_LEVEL ticks. A particle on level L steps every
+  * 2^(BLOCK_MAX_LEVEL - L) ticks, so it takes timeStep / 2^L per step. Only the
+  * particles starting a step on a tick need new forces, while every particle
+  * drifts on every tick, so the tree always holds current positions.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion ------------------------------------ */
+#ifndef __BLOCK_TIME_STEP_HPP
+#define __BLOCK_TIME_STEP_HPP
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "ParticleData.hpp"
+
+/* Exported types ----------------------------------------------------------- */
+/* Exported constants ------------------------------------------------------- */
+
+constexpr int    BLOCK_MAX_LEVEL        = 6;        // Finest step is timeStep / 2^6
+constexpr double BLOCK_ETA_ACCELERATION = 0.025;    // dt <= sqrt(2 eta SOFTENING / |a|) (Gadget's acceleration criterion)
+constexpr double BLOCK_ETA_VELOCITY     = 0.5;      // dt <= eta PARTICLE_RADIUS / |v| (at most half a radius per step)
+
+/* Exported macro ----------------------------------------------------------- */
+/* Exported variables ------------------------------------------------------- */
+/* Exported functions ------------------------------------------------------- */
+/* Forward declarations ----------------------------------------------------- */
+/* Class definition --------------------------------------------------------- */
+
+class BlockTimeStepper
+{
+public:
+    /* Public member variables -------------------------------------------------- */
+    /* Public member functions -------------------------------------------------- */
+
+    BlockTimeStepper();
+
+    void   BeginFrame(const ParticleData& particles, double timeStep);
+    bool   IsFrameDone() const;
+    size_t CollectActive(const ParticleData& particles);
+    void   Kick(ParticleData& particles);
+    double Drift(ParticleData& particles);
+
+    static int ChooseLevel(double timeStep, const glm::dvec2& acceleration, const glm::dvec2& velocity);
+
+    /* Getters ------------------------------------------------------------------ */
+
+    const std::vector<uint32_t>& GetActiveParticles() const;
+    const uint8_t* GetActiveMask() const;
+    size_t GetForceEvaluations() const;
+    int GetDeepestLevel() const;
+    double GetSharedStepRatio() const;
+
+    /* Setters ------------------------------------------------------------------ */
+private:
+    /* Private member variables ------------------------------------------------- */
+
+    int                   tick;                             // Position in the frame, in units of the finest step
+    int                   deepestLevel;                     // Finest level used during the frame
+    double                timeStep;                         // Frame length (the level 0 step)
+    size_t                numParticles;                     // Particles at the start of the frame
+    size_t                forceEvaluations;                 // Particles that got new forces during the frame
+    size_t                levelCounts[BLOCK_MAX_LEVEL + 1]; // Particles per level
+    std::vector<uint32_t> activeParticles;                  // Particles starting a step on this tick
+    std::vector<uint8_t>  activeMask;                       // 1 for active particles, per particle
+
+    /* Private member functions ------------------------------------------------- */
+    /* Getters ------------------------------------------------------------------ */
+    /* Setters ------------------------------------------------------------------ */
+};
+
+
+
+#endif /* __BLOCK_TIME_STEP_HPP */
+
+/******************************** END OF FILE *********************************/
@@ -0,0 +1,187 @@
+/**
+  ******************************************************************************
+  * @file    CollisionGrid.hpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   Header for CollisionGrid.cpp
+  ******************************************************************************
+  * @attention
+  *
+  * Uniform-grid cell list for the collision broadphase. Every particle has the
+  * same radius, so with cells at least 2 * PARTICLE_RADIUS wide all possible
+  * contacts of a particle lie in the 3x3 cells around it. The list is rebuilt
+  * every step by a counting sort on the cell index (O(N + cells)).
+  *
+  * Contacts are generated once per touching pair into a ContactBuffer, then
+  * resolved in a separate pass. Square blocks of COLLISION_BLOCK_CELLS cells
+  * are colored in a 2x2 checkerboard. A contact only reaches one cell past its
+  * block, so blocks of the same color share nothing and each color is
+  * resolved as one parallel pass, in a fixed order independent of threads.
+  *
+  * Verlet lists keep the pairs within 2 * PARTICLE_RADIUS + skin, so most
+  * steps only filter those pairs instead of rebinning and searching cells.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion ------------------------------------ */
+#ifndef __COLLISION_GRID_HPP
+#define __COLLISION_GRID_HPP
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "ParticleData.hpp"
+#include "Simulation.hpp"
+
+/* Exported types ----------------------------------------------------------- */
+
+/* Touching pairs (SoA), each pair once                                     */
+struct ContactBuffer
+{
+    std::vector<uint32_t> first;    // First particle of each pair
+    std::vector<uint32_t> second;   // Second particle of each pair
+
+    void Clear();
+};
+
+/* Exported constants ------------------------------------------------------- */
+
+constexpr size_t COLLISION_GRID_CELL_BUDGET = 4;        // Cells allowed per particle (cells widen past 2R when particles spread out)
+constexpr size_t COLLISION_GRID_MIN_CELLS   = 1 << 16;  // Cell budget for small scenes (the boxed viewport needs ~33k at 2R)
+constexpr int    COLLISION_BLOCK_CELLS      = 4;        // Cells per side of a parallel block (at least 2, so same-colored blocks never share a cell)
+constexpr double COLLISION_VERLET_SKIN      = 0.5 * PARTICLE_RADIUS;    // Default Verlet list reach beyond contact distance
+
+static_assert(COLLISION_BLOCK_CELLS >= 2, "Same-colored blocks must be at least two cells apart");
+
+/* Exported macro ----------------------------------------------------------- */
+/* Exported variables ------------------------------------------------------- */
+/* Exported functions ------------------------------------------------------- */
+
+/**
+ * @brief Collision impulse along the contact normal, if the pair is approaching
+ * @param particles       Reference to particle data (SoA)
+ * @param i               First particle
+ * @param j               Second particle
+ * @param collisionNormal Unit vector from i to j
+ * @retval bool True if the pair was approaching (and the impulse was applied)
+ */
+inline bool ApplyCollisionImpulse(ParticleData& particles, size_t i, size_t j, const glm::dvec2& collisionNormal)
+{
+    double separatingVelocity = glm::dot(particles.velocities[j] - particles.velocities[i], collisionNormal);
+
+    if (separatingVelocity >= 0)
+        return false;
+
+    double impulse = -(1 + COLLISION_DAMPING) * separatingVelocity /
+        ((1 / particles.masses[i]) + (1 / particles.masses[j]));
+
+    particles.velocities[i] -= (impulse / particles.masses[i]) * collisionNormal * REPULSION_FACTOR;
+    particles.velocities[j] += (impulse / particles.masses[j]) * collisionNormal * REPULSION_FACTOR;
+
+    return true;
+}
+
+/**
+ * @brief Impulse and separation for one pair of particles, if they overlap and approach
+ * @param particles Reference to particle data (SoA)
+ * @param i         First particle
+ * @param j         Second particle
+ * @retval None
+ */
+inline void ResolveCollisionPair(ParticleData& particles, size_t i, size_t j)
+{
+    glm::dvec2 direction = particles.positions[j] - particles.positions[i];
+    double distance = glm::length(direction);
+    if (distance < 2.0 * PARTICLE_RADIUS)
+    {
+        glm::dvec2 collisionNormal = glm::normalize(direction);
+
+        if (ApplyCollisionImpulse(particles, i, j, collisionNormal))
+        {
+            // Separate overlapping particles
+            double overlap = 2 * PARTICLE_RADIUS - distance;
+            glm::dvec2 separationVector = overlap * 0.5 * collisionNormal;
+
+            particles.positions[i] -= separationVector;
+            particles.positions[j] += separationVector;
+        }
+    }
+}
+
+/* Forward declarations ----------------------------------------------------- */
+/* Class definition --------------------------------------------------------- */
+
+class CollisionGrid
+{
+public:
+    /* Public member variables -------------------------------------------------- */
+    /* Public member functions -------------------------------------------------- */
+
+    CollisionGrid();
+
+    void Build(const ParticleData& particles, double skin = 0.0);
+    void QueryNeighbors(const glm::dvec2& position, std::vector<size_t>& neighbors) const;
+    void QueryRange(double xMin, double yMin, double xMax, double yMax, std::vector<size_t>& neighbors) const;
+    size_t FindContacts(const ParticleData& particles);
+    size_t UpdateVerletContacts(const ParticleData& particles, double skin);
+    void ResetVerletStatistics();
+    void ResolveContacts(ParticleData& particles) const;
+    void ResolveContactsColored(ParticleData& particles) const;
+
+    /* Getters ------------------------------------------------------------------ */
+
+    size_t GetContactCount() const;
+    size_t GetCandidateCount() const;
+    size_t GetVerletRebuildCount() const;
+    size_t GetVerletStepCount() const;
+    size_t GetCellCount() const;
+    double GetCellSize() const;
+
+    /* Setters ------------------------------------------------------------------ */
+private:
+    /* Private member variables ------------------------------------------------- */
+
+    int                   cellsX;           // Cells per row
+    int                   cellsY;           // Rows
+    double                cellSize;         // Cell width (at least 2 * PARTICLE_RADIUS)
+    double                inverseCellSize;
+    double                originX;          // Lower-left corner of cell (0, 0)
+    double                originY;
+    std::vector<uint32_t> cellStart;        // First entry of each cell in cellParticles (cells + 1 entries)
+    std::vector<uint32_t> cellParticles;    // Particle indices sorted by cell
+    std::vector<uint32_t> particleCells;    // Cell of each particle at build time
+    int                   blocksX;          // Parallel blocks per row (at the last FindContacts)
+    int                   blocksY;
+    size_t                contactCount;     // Contacts found by the last FindContacts
+    std::vector<ContactBuffer> rowContacts;     // Contacts of each row of blocks, block by block
+    std::vector<uint32_t>      blockContactEnd; // End of each block's contacts in its row's buffer
+
+    // Verlet lists
+    bool                       isVerletValid;     // Lists match the current grid and blocks
+    double                     verletSkin;        // Skin of the lists
+    size_t                     verletLayout;      // ParticleData::layoutVersion at the list build
+    size_t                     verletRebuilds;    // List builds since the statistics were reset
+    size_t                     verletSteps;       // Updates since the statistics were reset
+    size_t                     candidateCount;    // Pairs in the lists
+    std::vector<glm::dvec2>    verletPositions;   // Positions at the list build
+    std::vector<ContactBuffer> rowCandidates;     // Pairs within contact distance + skin, laid out like rowContacts
+    std::vector<uint32_t>      blockCandidateEnd; // End of each block's pairs in its row's buffer
+
+    /* Private member functions ------------------------------------------------- */
+
+    size_t FindPairs(const ParticleData& particles, double distance, std::vector<ContactBuffer>& rows, std::vector<uint32_t>& blockEnd);
+    int CellX(double x) const;
+    int CellY(double y) const;
+
+    /* Getters ------------------------------------------------------------------ */
+    /* Setters ------------------------------------------------------------------ */
+};
+
+
+
+#endif /* __COLLISION_GRID_HPP */
+
+/******************************** END OF FILE *********************************/
@@ -0,0 +1,72 @@
+/**
+  ******************************************************************************
+  * @file    DirectSum.hpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   Header for DirectSum.cpp
+  ******************************************************************************
+  * @attention
+  *
+  * Exact all-pairs gravity. The simulation switches to it automatically below
+  * DIRECT_SUM_MAX_PARTICLES, where it beats building and walking a tree. The
+  * scalar single-particle version is the reference for audits and benchmarks,
+  * and ComputeTotalEnergy / ComputeTotalAngularMomentum are the matching
+  * conserved quantities for drift checks.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion ------------------------------------ */
+#ifndef __DIRECT_SUM_HPP
+#define __DIRECT_SUM_HPP
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "ParticleData.hpp"
+
+/* Exported types ----------------------------------------------------------- */
+/* Exported constants ------------------------------------------------------- */
+
+constexpr size_t DIRECT_SUM_MAX_PARTICLES = 128;   // Gravity uses all-pairs summation at or below this particle count (measured crossover)
+
+/* Exported macro ----------------------------------------------------------- */
+/* Exported variables ------------------------------------------------------- */
+/* Exported functions ------------------------------------------------------- */
+
+glm::dvec2 ComputeAccelerationDirect(size_t particleIndex, const ParticleData& particles);
+double     ComputeTotalEnergy(const ParticleData& particles);
+double     ComputeTotalAngularMomentum(const ParticleData& particles);
+
+/* Forward declarations ----------------------------------------------------- */
+/* Class definition --------------------------------------------------------- */
+
+class DirectSolver
+{
+public:
+    /* Public member variables -------------------------------------------------- */
+    /* Public member functions -------------------------------------------------- */
+
+    void ComputeAccelerations(ParticleData& particles, const std::vector<uint32_t>* targets = nullptr);
+
+    /* Getters ------------------------------------------------------------------ */
+    /* Setters ------------------------------------------------------------------ */
+private:
+    /* Private member variables ------------------------------------------------- */
+
+    std::vector<double> x;      // SoA copy of particle x positions (streamed by the SIMD kernel)
+    std::vector<double> y;      // SoA copy of particle y positions
+    std::vector<double> mass;   // SoA copy of particle masses
+
+    /* Private member functions ------------------------------------------------- */
+    /* Getters ------------------------------------------------------------------ */
+    /* Setters ------------------------------------------------------------------ */
+};
+
+
+
+#endif /* __DIRECT_SUM_HPP */
+
+/******************************** END OF FILE *********************************/
@@ -67,6 +67,7 @@ public:
     int Init();
     int InitFreeType();
     void InitParticleBuffers(GLuint& VAO, GLuint& VBO_positions, GLuint& VBO_colors, size_t maxParticles);
+    bool ResizeParticleBuffers(size_t maxParticles);
     void InitTextBuffers(GLuint& VAO, GLuint& VBO_positions);
     GLFWwindow* InitOpenGL();
 
@@ -0,0 +1,90 @@
+/**
+  ******************************************************************************
+  * @file    Fmm.hpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   Header for Fmm.cpp
+  ******************************************************************************
+  * @attention
+  *
+  * Fast multipole gravity on the Barnes-Hut quadtree. Expansions are Cartesian
+  * Taylor series of the simulation's own softened potential. The force falls
+  * off as 1/r^2, so the complex (logarithmic) 2D FMM does not apply. Near-field
+  * leaf pairs use the same direct formula as ComputeForceBarnesHut.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion ------------------------------------ */
+#ifndef __FMM_HPP
+#define __FMM_HPP
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "ParticleData.hpp"
+#include "Quadtree.hpp"
+
+/* Exported types ----------------------------------------------------------- */
+/* Exported constants ------------------------------------------------------- */
+
+constexpr int    FMM_MAX_ORDER     = 8;                     // Highest supported expansion order
+constexpr int    FMM_DEFAULT_ORDER = 4;                     // Expansion order used by the simulation unless changed
+constexpr int    FMM_MAX_TERMS     = (FMM_MAX_ORDER + 1) * (FMM_MAX_ORDER + 2) / 2; // Coefficients per expansion at FMM_MAX_ORDER
+constexpr double FMM_THETA         = 0.7;                   // Cells interact by M2L when (rA + rB) < FMM_THETA * distance
+
+/* Exported macro ----------------------------------------------------------- */
+/* Exported variables ------------------------------------------------------- */
+/* Exported functions ------------------------------------------------------- */
+/* Forward declarations ----------------------------------------------------- */
+/* Class definition --------------------------------------------------------- */
+
+class FmmSolver
+{
+public:
+    /* Public member variables -------------------------------------------------- */
+    /* Public member functions -------------------------------------------------- */
+
+    FmmSolver();
+
+    void ComputeAccelerations(ParticleData& particles, QuadtreeNode* root, QuadtreeNodePool& pool, int order);
+
+    /* Getters ------------------------------------------------------------------ */
+    /* Setters ------------------------------------------------------------------ */
+private:
+    /* Private member variables ------------------------------------------------- */
+
+    int                        order;       // Expansion order of the current evaluation
+    size_t                     numTerms;    // Coefficients per expansion at this order
+    std::vector<double>        multipoles;  // Multipole expansion per node, indexed by poolIndex (about the node's geometric center)
+    std::vector<double>        locals;      // Local expansion per node (about the node's geometric center)
+    std::vector<QuadtreeNode*> targets;     // Subtrees evaluated as independent parallel tasks
+
+    /* Private member functions ------------------------------------------------- */
+
+    double* Multipole(const QuadtreeNode* node);
+    double* Local(const QuadtreeNode* node);
+
+    void Upward(const QuadtreeNode* node, const ParticleData& particles);
+    void UpwardTop(const QuadtreeNode* node, int level);
+    void Interact(const QuadtreeNode* target, const QuadtreeNode* source, ParticleData& particles);
+    void Downward(const QuadtreeNode* node, ParticleData& particles);
+
+    void ParticleToMultipole(const QuadtreeNode* leaf, const ParticleData& particles);
+    void MultipoleToMultipole(const QuadtreeNode* child, const QuadtreeNode* parent);
+    void MultipoleToLocal(const QuadtreeNode* target, const QuadtreeNode* source);
+    void LocalToLocal(const QuadtreeNode* parent, const QuadtreeNode* child);
+    void LocalToParticle(const QuadtreeNode* leaf, ParticleData& particles);
+    void ParticleToParticle(const QuadtreeNode* target, const QuadtreeNode* source, ParticleData& particles);
+
+    /* Getters ------------------------------------------------------------------ */
+    /* Setters ------------------------------------------------------------------ */
+};
+
+
+
+#endif /* __FMM_HPP */
+
+/******************************** END OF FILE *********************************/
@@ -0,0 +1,86 @@
+/**
+  ******************************************************************************
+  * @file    ForceAudit.hpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   Header for ForceAudit.cpp
+  ******************************************************************************
+  * @attention
+  *
+  * Compares the accelerations produced by the active gravity solver against
+  * exact direct summation for a random sample of particles. Enabled at runtime
+  * (every FORCE_AUDIT_INTERVAL frames); results are logged and shown in the UI.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion ------------------------------------ */
+#ifndef __FORCE_AUDIT_HPP
+#define __FORCE_AUDIT_HPP
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "ParticleData.hpp"
+
+/* Exported types ----------------------------------------------------------- */
+
+/* Result of one audit                                                       */
+struct ForceAuditReport
+{
+    size_t samples;         // Particles compared (0 until the first audit)
+    double medianError;     // Median of |a - a_direct| / |a_direct| over the sample
+    double p99Error;        // 99th percentile (nearest rank)
+    double maxError;        // Largest relative error in the sample
+    double solverMs;        // Time the gravity solver took for all particles in the audited frame
+    double directMs;        // Direct summation time for all particles (scaled up from the sample)
+    double costRatio;       // directMs / solverMs
+};
+
+/* Exported constants ------------------------------------------------------- */
+
+constexpr size_t FORCE_AUDIT_INTERVAL = 60;     // Frames between audits while auditing is enabled
+constexpr size_t FORCE_AUDIT_SAMPLES  = 256;    // Particles compared against direct summation per audit
+
+/* Exported macro ----------------------------------------------------------- */
+/* Exported variables ------------------------------------------------------- */
+/* Exported functions ------------------------------------------------------- */
+
+/* Forward declarations ----------------------------------------------------- */
+/* Class definition --------------------------------------------------------- */
+
+class ForceAudit
+{
+public:
+    /* Public member variables -------------------------------------------------- */
+    /* Public member functions -------------------------------------------------- */
+
+    ForceAudit();
+
+    void Run(const ParticleData& particles, double solverMs);
+
+    /* Getters ------------------------------------------------------------------ */
+
+    const ForceAuditReport& GetReport() const;
+
+    /* Setters ------------------------------------------------------------------ */
+private:
+    /* Private member variables ------------------------------------------------- */
+
+    std::mt19937          generator;    // Chooses the sampled particles
+    std::vector<size_t>   samples;      // Particle indices of the current audit
+    std::vector<double>   errors;       // Relative error per sample (sorted after each audit)
+    ForceAuditReport      report;       // Result of the latest audit
+
+    /* Private member functions ------------------------------------------------- */
+    /* Getters ------------------------------------------------------------------ */
+    /* Setters ------------------------------------------------------------------ */
+};
+
+
+
+#endif /* __FORCE_AUDIT_HPP */
+
+/******************************** END OF FILE *********************************/
@@ -21,6 +21,8 @@
 #include <Windows.h>
 
 #include <vector>
+#include <algorithm>
+#include <cstdint>
 #include <random>
 #include <cmath>
 #include <iostream>
@@ -37,6 +39,10 @@
 #include <string>
 #include <stdexcept>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include <GL/glew.h>
 
 #include <GLFW/glfw3.h>
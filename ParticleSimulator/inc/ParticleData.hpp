@@ -56,10 +56,16 @@ public:
     std::vector<glm::dvec2> velocities;
     std::vector<glm::vec3>  colors;
 
+    // Block timestep level: the particle steps by timeStep / 2^level (0 without block timesteps)
+    std::vector<uint8_t> timeLevels;
+
     // Color update caching (optimization)
     std::vector<int> framesSinceColorUpdate;
     static constexpr int COLOR_UPDATE_INTERVAL = 5;
 
+    // Incremented whenever particles are added, removed or reordered (stored indices become stale)
+    size_t layoutVersion = 0;
+
     /* Public member functions -------------------------------------------------- */
 
     ParticleData();
@@ -81,6 +87,22 @@ public:
      */
     void RemoveParticle(size_t index);
 
+    /**
+     * @brief Remove every marked particle in one compaction pass
+     * @param removed Per-particle flags, 1 for particles to remove
+     * @retval size_t Number of particles removed
+     * @note Survivors keep their relative order; bumps layoutVersion if anything was removed
+     */
+    size_t RemoveMarked(const std::vector<uint8_t>& removed);
+
+    /**
+     * @brief Permute every particle array (e.g. into space-filling-curve order)
+     * @param order New-to-old index map: particle order[i] moves to index i
+     * @retval None
+     * @note Bumps layoutVersion; anything holding particle indices must remap or rebuild
+     */
+    void Reorder(const std::vector<uint32_t>& order);
+
     /**
      * @brief Clear all particles
      * @param None
@@ -129,6 +151,13 @@ public:
 
 private:
     /* Private member variables ------------------------------------------------- */
+
+    // Reorder scratch, one per element type, kept across reorders (no allocation once grown)
+    std::vector<double>     scratchDouble;
+    std::vector<glm::dvec2> scratchVec2;
+    std::vector<glm::vec3>  scratchColor;
+    std::vector<uint8_t>    scratchByte;
+    std::vector<int>        scratchInt;
     /* Private member functions ------------------------------------------------- */
     /* Getters ------------------------------------------------------------------ */
     /* Setters ------------------------------------------------------------------ */
@@ -29,43 +29,171 @@
 
 constexpr double THETA = 2.0;                               // Threshold distance to calculate long-range force (lower = more accurate, higher = faster)
 constexpr size_t BUCKET_CAPACITY = 8;                       // Maximum particles per leaf node before subdivision
-constexpr size_t POOL_MAX_NODES = MAX_NUM_PARTICLES * 4;    // Pre-allocated node pool size (generous upper bound)
+constexpr double MIN_NODE_HALF_SIZE = 1e-12;                // Full leaves this small are not split (extra coincident particles go to overflow buckets)
+constexpr int    MORTON_BITS     = 16;                      // Bits per axis in a Morton key (tree levels resolved by the linear build)
+constexpr int    PARALLEL_SPLIT_LEVEL = 3;                  // Level whose subtrees are built/aggregated as parallel tasks (up to 4^3 = 64)
+constexpr int    POOL_MAX_THREADS     = 64;                 // Upper bound on threads allocating from one pool
+constexpr size_t POOL_SLICE_NODES     = 256;                // Nodes a thread claims from the pool at a time
+constexpr size_t POOL_CHUNK_NODES     = 16'384;             // Nodes per arena block (multiple of POOL_SLICE_NODES, 1 MB hot + 1.1 MB cold)
+constexpr size_t CACHE_LINE_SIZE      = 64;                 // Bytes per cache line (one hot node each)
+constexpr double PERSISTENT_REBUILD_FRACTION = 0.05;        // Rebuild a persistent tree when this fraction of particles migrates in one step
+constexpr double PERSISTENT_MAX_DRIFT        = 1.0;         // ...or once total migrations since the last rebuild reach this fraction
+constexpr double PERSISTENT_MAX_POOL_GROWTH  = 0.5;         // ...or once refits have grown the pool by this fraction of the rebuilt tree
+constexpr size_t FORCE_GROUP_SIZE            = 16;          // Max particles sharing one interaction list in the grouped force walk
+constexpr int    FLAT_TREE_MAX_DEPTH         = 64;          // Deepest tree the stackless walk handles (deeper trees use the recursive walk)
+constexpr double FORCE_TOLERANCE             = 0.005;       // Allowed error fraction for the SalmonWarren / RelativeForce criteria
+constexpr size_t DOMAIN_BOUNDS_BLOCK         = 4096;        // Particles per parallel block of the open-domain bounds reduction
+constexpr double DOMAIN_PADDING              = 1e-3;        // Open-domain root margin as a fraction of the particle extent
+constexpr double OUTLIER_RADIUS_FACTOR       = 8.0;         // Outliers lie this many RMS radii or more from the center of mass
+constexpr size_t OUTLIER_MAX_COUNT           = 64;          // More candidates than this are not outliers (the root covers them all)
 
 /* Exported macro ----------------------------------------------------------- */
 /* Exported variables ------------------------------------------------------- */
 /* Exported functions ------------------------------------------------------- */
 /* Forward declarations ----------------------------------------------------- */
 
+struct QuadtreeNode;
 struct QuadtreeNodePool;
 
+/* Multipole acceptance criterion and its parameters for the Barnes-Hut walks */
+struct OpeningTest
+{
+    OpeningCriterion criterion;     // Test deciding whether a node is accepted
+    double           theta;         // Geometric / MinDistance threshold (also the fallback while the others lack data)
+    double           tolerance;     // SalmonWarren / RelativeForce: allowed error as a fraction of an acceleration
+    double           errorBound;    // SalmonWarren: allowed acceleration error per node divided by G (set by Prepare)
+
+    OpeningTest(double theta = THETA);
+    OpeningTest(OpeningCriterion criterion, double theta, double tolerance);
+
+    void Prepare(const QuadtreeNode* root);
+};
+
+/* Thread-local window into the node pool                                   */
+struct QuadtreeNodeSlice
+{
+    QuadtreeNode* next;         // Next free node in this slice
+    QuadtreeNode* end;          // One past the last node in this slice
+    uint32_t      nextIndex;    // Pool index of next
+    char          pad[44];      // Keep each thread's slice on its own cache line
+};
+
+/* Open-domain root square and the particles left outside it               */
+struct DomainBounds
+{
+    glm::dvec2            minP;         // Smallest x and y over all particles
+    glm::dvec2            maxP;         // Largest x and y over all particles
+    glm::dvec2            centerOfMass; // Mass-weighted center of all particles
+    double                rmsRadius;    // Mass-weighted RMS distance from centerOfMass
+    double                centerX;      // Root center x
+    double                centerY;      // Root center y
+    double                halfSize;     // Root half-size
+    std::vector<uint32_t> outliers;     // Particles outside the root (OutlierPolicy::Track / Drop only)
+
+    // Per-block partial results of the parallel reduction, reused every frame
+    std::vector<glm::dvec2> blockMin;
+    std::vector<glm::dvec2> blockMax;
+    std::vector<glm::dvec4> blockMoments;
+};
+
+/* Deferred Morton subtree (built by a worker thread)                        */
+struct MortonTask
+{
+    QuadtreeNode* node;     // Subtree root at PARALLEL_SPLIT_LEVEL
+    size_t        first;    // First sorted index in range
+    size_t        last;     // One past the last sorted index in range
+};
+
+/* Interaction list shared by a group of nearby particles (SoA for the inner loop) */
+/* Positions and masses are stored as double or as float offsets, per ForcePrecision */
+struct InteractionList
+{
+    std::vector<double> nodeX;      // Center of mass x of each accepted node
+    std::vector<double> nodeY;      // Center of mass y of each accepted node
+    std::vector<double> nodeMass;   // Total mass of each accepted node
+    std::vector<double> nodeQxx;    // Quadrupole xx of each accepted node (MultipoleOrder::Quadrupole only)
+    std::vector<double> nodeQxy;    // Quadrupole xy of each accepted node
+    std::vector<double> nodeQyy;    // Quadrupole yy of each accepted node
+    std::vector<double> bodyX;      // Position x of each particle from an opened leaf
+    std::vector<double> bodyY;      // Position y of each particle from an opened leaf
+    std::vector<double> bodyMass;   // Mass of each particle from an opened leaf
+    std::vector<size_t> bodyIndex;  // Particle index (used to skip self-interaction)
+    std::vector<float>  nodeOffsetX;    // ForcePrecision::Mixed: node x relative to the group's node center
+    std::vector<float>  nodeOffsetY;
+    std::vector<float>  nodeGm;         // ForcePrecision::Mixed: G * node mass
+    std::vector<float>  bodyOffsetX;    // ForcePrecision::Mixed: particle x relative to the group's node center
+    std::vector<float>  bodyOffsetY;
+    std::vector<float>  bodyGm;         // ForcePrecision::Mixed: G * particle mass
+
+    void Clear();
+};
+
+/* Hot node of the depth-first flattened tree (48 bytes, no pointers)       */
+struct FlatQuadtreeNode
+{
+    glm::dvec2 centerOfMass;    // Copied from the tree node
+    double     totalMass;       // Copied from the tree node
+    double     halfSize;        // Copied from the tree node
+    uint32_t   skip;            // Index of the first node after this subtree
+    uint32_t   firstBody;       // Leaf only: first entry of its particles in the body arrays
+    uint16_t   bodyCount;       // Leaf only: number of particles (0 for internal nodes)
+    uint16_t   depth;           // Tree depth (root = 0)
+    uint32_t   pad;             // Keep the size a multiple of 16 bytes
+};
+
+/* Compact copy of a quadtree for the stackless walk                        */
+/* Hot node data, cold quadrupoles and leaf particles live in separate arrays */
+/* Only ForceWalkMode::Stackless reads it (skip links instead of children)   */
+struct FlatQuadtree
+{
+    std::vector<FlatQuadtreeNode> nodes;        // Non-empty nodes in depth-first (nw, ne, sw, se) order
+    std::vector<double>           quadrupoles;  // Cold: 3 per node (xx, xy, yy), read by MultipoleOrder::Quadrupole and SalmonWarren
+    std::vector<glm::dvec2>       centers;      // Cold: geometric center per node, read only by box-based opening criteria
+    std::vector<double>           bodyX;        // Leaf particles in depth-first order (positions/masses copied)
+    std::vector<double>           bodyY;
+    std::vector<double>           bodyMass;
+    std::vector<uint32_t>         bodyIndex;    // Particle index of each body (used to skip self-interaction)
+
+    bool Build(const QuadtreeNode* root, const ParticleData& particles);
+};
+
+/* Cold half of a pool node: leaf bucket, quadrupole and bookkeeping        */
+/* Read at leaves, by quadrupole terms and by per-node arrays only           */
+struct QuadtreeNodeCold
+{
+    double        quadrupole[3];                    // Traceless quadrupole about the center of mass (xx, xy, yy)
+    uint32_t      particleIndices[BUCKET_CAPACITY]; // Fixed-size bucket (no heap allocation per node)
+    uint32_t      particleCount;                    // Number of particles currently in bucket
+    uint32_t      poolIndex;                        // Allocation order since the last pool reset (dense index for per-node arrays)
+    QuadtreeNode* overflow;                         // Depth-capped leaf only: next bucket of the same square (not a child)
+};
+
 /* Class definition --------------------------------------------------------- */
 
+/* Hot half of a pool node, one cache line: everything an opening test reads */
+/* Built, refit and queried in place by every tree walk, FMM and TreePM      */
 struct QuadtreeNode
 {
     /* Public member variables -------------------------------------------------- */
 
-    double     centerX;                         // Center x coordinate of the node
-    double     centerY;                         // Center y coordinate of the node
-    double     halfSize;                        // Half the width/height of the node
-    double     totalMass;                       // Total mass of particles in this node
-    glm::dvec2 centerOfMass;                    // Center of mass for all particles in this node
-    size_t     particleIndices[BUCKET_CAPACITY];// Fixed-size bucket (no heap allocation per node)
-    size_t     particleCount;                   // Number of particles currently in bucket
-
-    // Children nodes (raw pointers into pool — no ownership, no heap alloc)
-    QuadtreeNode* nw;   // north west
-    QuadtreeNode* ne;   // north east
-    QuadtreeNode* sw;   // south west
-    QuadtreeNode* se;   // south east
+    double            centerX;      // Center x coordinate of the node
+    double            centerY;      // Center y coordinate of the node
+    double            halfSize;     // Half the width/height of the node
+    double            totalMass;    // Total mass of particles in this node
+    glm::dvec2        centerOfMass; // Center of mass for all particles in this node
+    QuadtreeNode*     children;     // Four consecutive children (nw, ne, sw, se), nullptr for a leaf
+    QuadtreeNodeCold* cold;         // Cold half, fixed to this pool slot (never changes)
 
 
     /* Public member functions -------------------------------------------------- */
 
     void Init(double centerX, double centerY, double halfSize);
 
+    void CombineChildMass();
     void ComputeMassDistribution(const ParticleData& particles);
     void Insert(size_t particleIndex, const ParticleData& particles, QuadtreeNodePool& pool);
     void InsertIntoChild(size_t particleIndex, const ParticleData& particles, QuadtreeNodePool& pool);
+    void InsertOverflow(size_t particleIndex, QuadtreeNodePool& pool);
     void QueryRange(double xMin, double yMin, double xMax, double yMax, std::vector<size_t>& results);
     void Subdivide(QuadtreeNodePool& pool);
     bool Contains(double px, double py) const;
@@ -74,21 +202,92 @@ struct QuadtreeNode
     /* Setters ------------------------------------------------------------------ */
 };
 
+static_assert(sizeof(QuadtreeNode) == CACHE_LINE_SIZE, "Hot quadtree node must fill exactly one cache line");
+
+/* One arena block: hot nodes on cache-line boundaries, cold halves alongside */
+struct QuadtreeNodeChunk
+{
+    std::vector<unsigned char>    storage;  // Raw bytes for the hot nodes (one line of slack for alignment)
+    QuadtreeNode*                 nodes;    // POOL_CHUNK_NODES hot nodes, the first on a cache-line boundary
+    std::vector<QuadtreeNodeCold> cold;     // Cold half of each node (nodes[k].cold == &cold[k])
+
+    QuadtreeNodeChunk();
+};
+
 
-/* Pool allocator for QuadtreeNodes — pre-allocated, reset each frame       */
+/* Arena allocator for QuadtreeNodes — grows by fixed blocks, reset each frame */
+/* Each thread allocates from its own slice; only slice refills are locked   */
 struct QuadtreeNodePool
 {
-    std::vector<QuadtreeNode> nodes;    // Contiguous block, never resized after init
-    size_t                    nextIndex; // Index of next free node
+    std::vector<QuadtreeNodeChunk> chunks;   // POOL_CHUNK_NODES each; kept across resets, nodes never move
+    size_t                    nextIndex;     // Index of first node not yet handed to a slice (nodes in use, rounded up to slices)
+    size_t                    highWaterMark; // Largest nextIndex reached since construction
+    QuadtreeNodeSlice         slices[POOL_MAX_THREADS];
+
+    // Scratch buffers for the Morton (linear) build, reused every frame
+    std::vector<uint32_t>     mortonKeys;
+    std::vector<uint32_t>     mortonKeysTemp;
+    std::vector<uint32_t>     sortedIndices;
+    std::vector<uint32_t>     sortedIndicesTemp;
+
+    // Work lists for the parallel build, reused every frame
+    std::vector<size_t>        radixHistograms;
+    std::vector<MortonTask>    mortonTasks;
+    std::vector<QuadtreeNode*> subtreeRoots;
+
+    // Particle groups for the grouped force walk, reused every frame
+    std::vector<const QuadtreeNode*> forceGroups;
+
+    // Depth-first compact copy of the tree for the stackless walk, reused every frame
+    FlatQuadtree                     flatTree;
+
+    // Open-domain root and outliers, recomputed every frame
+    DomainBounds                     domain;
 
     QuadtreeNodePool();
 
     QuadtreeNode* Allocate(double cx, double cy, double hs);
+    QuadtreeNode* AllocateChildren(double cx, double cy, double hs);
     void          Reset();
+    size_t        Capacity() const;
+    size_t        HighWaterMark() const;
+    void          ClaimSlice(QuadtreeNodeSlice& slice);
+};
+
+
+/* Quadtree kept across frames — only particles that leave their leaf move  */
+struct PersistentQuadtree
+{
+    QuadtreeNode*              root;                    // Root of the retained tree (nullptr until attached)
+    std::vector<QuadtreeNode*> particleLeaves;          // Leaf currently holding each particle
+    std::vector<size_t>        migrants;                // Particles that left their leaf this step
+    std::vector<uint32_t>      newIndexOf;              // Old-to-new index map used by Remap
+    size_t                     layoutVersion;           // ParticleData::layoutVersion the tree was built for
+    size_t                     migrationsSinceRebuild;  // Migrations applied since the last full rebuild
+    size_t                     rebuildCount;            // Number of full rebuilds
+    size_t                     refitCount;              // Number of steps that reused the tree
+    size_t                     nodesAtRebuild;          // Pool nodes in use right after the last full rebuild
+
+    PersistentQuadtree();
+
+    void Attach(QuadtreeNode* root, const ParticleData& particles, const QuadtreeNodePool& pool);
+    void Invalidate();
+    bool Refit(const ParticleData& particles, QuadtreeNodePool& pool);
+    void Remap(const std::vector<uint32_t>& order, size_t previousLayoutVersion, const ParticleData& particles);
 };
 
 
-glm::dvec2 ComputeForceBarnesHut(size_t particleIndex, const ParticleData& particles, const QuadtreeNode* node, double theta);
+void ComputeDomainBounds(const ParticleData& particles, OutlierPolicy policy, DomainBounds& bounds);
+size_t ComputeMortonOrder(const ParticleData& particles, QuadtreeNodePool& pool, double centerX, double centerY, double halfSize);
+QuadtreeNode* BuildQuadtreeRecursive(const ParticleData& particles, QuadtreeNodePool& pool, double centerX, double centerY, double halfSize);
+QuadtreeNode* BuildQuadtreeMorton(const ParticleData& particles, QuadtreeNodePool& pool, double centerX, double centerY, double halfSize);
+QuadtreeNode* BuildQuadtreeMortonParallel(const ParticleData& particles, QuadtreeNodePool& pool, double centerX, double centerY, double halfSize);
+void ComputeMassDistributionParallel(QuadtreeNode* root, const ParticleData& particles, QuadtreeNodePool& pool);
+glm::dvec2 ComputeForceBarnesHut(size_t particleIndex, const ParticleData& particles, const QuadtreeNode* node, const OpeningTest& test, MultipoleOrder order = MultipoleOrder::Monopole, size_t* interactions = nullptr, ForcePrecision precision = ForcePrecision::Double);
+glm::dvec2 ComputeForceBarnesHutStackless(size_t particleIndex, const ParticleData& particles, const FlatQuadtree& tree, const OpeningTest& test, MultipoleOrder order = MultipoleOrder::Monopole, size_t* interactions = nullptr, ForcePrecision precision = ForcePrecision::Double);
+void ComputeAccelerationsGrouped(ParticleData& particles, const QuadtreeNode* root, const OpeningTest& test, QuadtreeNodePool& pool, MultipoleOrder order = MultipoleOrder::Monopole, size_t* interactions = nullptr, ForcePrecision precision = ForcePrecision::Double, const uint8_t* activeMask = nullptr);
+size_t CollectForceGroups(const QuadtreeNode* node, std::vector<const QuadtreeNode*>& groups);
+void CollectGroupMembers(const QuadtreeNode* node, std::vector<size_t>& members);
 
 
 
@@ -46,10 +46,83 @@ enum SimulationTemplate
     BinaryStar
 };
 
+enum class TreeBuildMode
+{
+    Recursive,      // Insert particles one at a time from the root
+    Morton,         // Radix-sort Morton keys and emit the tree linearly
+    MortonParallel  // Morton build and mass aggregation split across threads
+};
+
+enum class GravitySolver
+{
+    BarnesHut,      // Tree walk per particle or group (ForceWalkMode)
+    Fmm,            // Fast multipole method on the same quadtree
+    TreePm          // FFT mesh for long range, cut-off tree walk for short range
+};
+
+enum class MultipoleOrder
+{
+    Monopole,       // Far-field nodes act as a point mass at their center of mass
+    Quadrupole      // Point mass plus second-moment correction
+};
+
+enum class ForcePrecision
+{
+    Double,         // All force arithmetic in double
+    Mixed           // Pair and node terms in float32 on offsets from a node center, sums in double
+};
+
+enum class OpeningCriterion
+{
+    Geometric,      // Node size / distance to its center of mass < theta
+    MinDistance,    // Node size / distance to the nearest point of its box < theta
+    SalmonWarren,   // Error bound from the node's second moment below a fixed acceleration
+    RelativeForce   // Estimated error below a fraction of the particle's last acceleration (Gadget)
+};
+
+enum class OutlierPolicy
+{
+    Include,        // Open domain: the root covers every particle
+    Track,          // Far outliers stay out of the tree; they feel the tree and act on everyone by direct summation
+    Drop            // Far outliers stay out of the tree and out of gravity (they coast until they return)
+};
+
+enum class CollisionBroadphase
+{
+    Quadtree,       // One range query on the gravity tree per particle
+    Grid            // Uniform cell list rebuilt every step, 3x3 cell stencil per particle
+};
+
+enum class Integrator
+{
+    SymplecticEuler,    // Kick then drift with the new velocity (first order)
+    Leapfrog,           // Kick-drift-kick, one force evaluation per step (second order, time reversible)
+    Yoshida4            // Three leapfrog steps of w1, w0, w1 times the step (fourth order, three force evaluations)
+};
+
+struct ConservationReport
+{
+    size_t particles;               // Particle count of the baseline (a new baseline is taken when it changes)
+    double startTime;               // Simulation time of the baseline
+    double elapsed;                 // Simulated time since the baseline
+    double initialEnergy;
+    double initialAngularMomentum;
+    double energyDrift;             // |E - E0| / |E0|
+    double angularMomentumDrift;    // |L - L0| / |L0| (absolute when L0 is zero)
+};
+
+enum class ForceWalkMode
+{
+    PerParticle,    // One tree walk per particle
+    Stackless,      // One walk per particle as a single loop over the depth-first flattened tree
+    Grouped         // One tree walk per group of nearby particles, shared interaction list
+};
+
 /* Exported constants ------------------------------------------------------- */
 
-constexpr bool   ENABLE_BOUNDING_BOX      = true;           // Flag to toggle whether or not to keep particles within viewport
-constexpr int    MAX_NUM_PARTICLES        = 50'000;         // Max number of particles that can be in the simulation
+constexpr bool   ENABLE_BOUNDING_BOX      = true;           // Flag to toggle whether or not to keep particles within viewport (open domain ignores it)
+constexpr int    MAX_NUM_PARTICLES        = 50'000;         // Default particle capacity (--particles N or the N key change it at runtime)
+constexpr size_t PARTICLE_CAPACITY_LIMIT  = 4'000'000;      // Largest capacity accepted (arrays and GPU buffers are reserved up front)
 constexpr int    NUM_TEMPLATE_PARTICLES   = 2'000;          // Number of particles to create for templates
 constexpr double COLLISION_DAMPING        = 0.0;            // Collision response damping
 constexpr double DAMPING_FACTOR           = 1.0;            // Velocity damping factor
@@ -61,13 +134,31 @@ constexpr double PARTICLE_RADIUS          = 0.0055;         // Radius of each pa
 constexpr double REPULSION_FACTOR         = 1.00;           // Basic repulsion force to apply when particles collide
 constexpr double SOFTENING                = 0.01;           // Softening factor to prevent extreme forces
 constexpr double TIME_STEP                = 1e-3;           // Time in seconds to step through the simulation
+constexpr size_t REORDER_INTERVAL         = 32;             // Frames between Morton-order reorders of particle data (0 disables)
+constexpr double YOSHIDA_W1               = 1.35120719196;  // 1 / (2 - 2^(1/3)), outer substeps of the 4th-order composition
+constexpr double YOSHIDA_W0               = -1.70241438392; // -2^(1/3) / (2 - 2^(1/3)), middle substep (runs backwards)
+constexpr size_t CONSERVATION_INTERVAL    = 100;            // Frames between energy / angular momentum drift reports
+constexpr size_t CONSERVATION_MAX_COUNT   = 4'096;          // Drift reports skip larger scenes (the energy is an O(N^2) sum)
 
 /* Exported macro ----------------------------------------------------------- */
 /* Exported variables ------------------------------------------------------- */
 /* Exported functions ------------------------------------------------------- */
 /* Forward declarations ----------------------------------------------------- */
 
+struct QuadtreeNode;
 struct QuadtreeNodePool;
+struct PersistentQuadtree;
+struct OpeningTest;
+class  FmmSolver;
+class  TreePmSolver;
+class  DirectSolver;
+class  ForceAudit;
+class  BlockTimeStepper;
+class  CollisionGrid;
+struct ContactBuffer;
+class  SweptCollisionSolver;
+class  AccretionSolver;
+struct ForceAuditReport;
 
 /* Class definition --------------------------------------------------------- */
 
@@ -101,6 +192,52 @@ public:
     double GetTotalMass() const;
     glm::vec2 GetNewParticleVelocity() const;
     SimulationTemplate GetSimulationTemplate() const;
+    TreeBuildMode GetTreeBuildMode() const;
+    ForceWalkMode GetForceWalkMode() const;
+    Integrator GetIntegrator() const;
+    CollisionBroadphase GetCollisionBroadphase() const;
+    MultipoleOrder GetMultipoleOrder() const;
+    ForcePrecision GetForcePrecision() const;
+    GravitySolver GetGravitySolver() const;
+    int GetFmmOrder() const;
+    int GetTreePmMeshSize() const;
+    OpeningCriterion GetOpeningCriterion() const;
+    double GetTheta() const;
+    double GetForceTolerance() const;
+    double GetAverageInteractions() const;
+    size_t GetForceAuditInterval() const;
+    bool IsDirectSummationActive() const;
+    bool IsBlockTimeStepEnabled() const;
+    bool IsParallelCollisionsEnabled() const;
+    size_t GetContactCount() const;
+    double GetNeighborListSkin() const;
+    double GetNeighborListStepsPerRebuild() const;
+    double GetNeighborListLength() const;
+    bool IsSweptCollisionEnabled() const;
+    double GetSweptSpeedThreshold() const;
+    size_t GetSweptParticleCount() const;
+    size_t GetSweptHitCount() const;
+    bool IsMergeModeEnabled() const;
+    double GetMergeMassRatio() const;
+    double GetMergeRelativeSpeed() const;
+    size_t GetMergeCount() const;
+    size_t GetTotalMergeCount() const;
+    size_t GetForceEvaluations() const;
+    int GetDeepestTimeLevel() const;
+    double GetBlockStepSaving() const;
+    const ForceAuditReport& GetForceAuditReport() const;
+    size_t GetConservationInterval() const;
+    const ConservationReport& GetConservationReport() const;
+    bool IsPersistentTreeEnabled() const;
+    size_t GetTreeRebuildCount() const;
+    size_t GetTreeRefitCount() const;
+    size_t GetTreeNodeCount() const;
+    size_t GetTreeNodeHighWaterMark() const;
+    size_t GetTreeNodeMemory() const;
+    size_t GetReorderInterval() const;
+    bool IsOpenDomainEnabled() const;
+    OutlierPolicy GetOutlierPolicy() const;
+    size_t GetOutlierCount() const;
     ParticleData* GetParticleData() const;
     Engine* GetEngine() const;
 
@@ -113,22 +250,103 @@ public:
     void SetParticleBrushSize(int size);
     void SetSimulationTemplate(SimulationTemplate simulationTemplate = SimulationTemplate::Empty);
     void SetTimeStep(double timeStep);
+    void SetTreeBuildMode(TreeBuildMode mode);
+    void SetForceWalkMode(ForceWalkMode mode);
+    void SetIntegrator(Integrator integrator);
+    void SetCollisionBroadphase(CollisionBroadphase broadphase);
+    void SetMultipoleOrder(MultipoleOrder order);
+    void SetForcePrecision(ForcePrecision precision);
+    void SetGravitySolver(GravitySolver solver);
+    void SetFmmOrder(int order);
+    void SetTreePmMeshSize(int meshSize);
+    void SetOpeningCriterion(OpeningCriterion criterion);
+    void SetTheta(double theta);
+    void SetForceTolerance(double tolerance);
+    void SetForceAuditInterval(size_t interval);
+    void SetConservationInterval(size_t interval);
+    void SetBlockTimeStepEnabled(bool enabled);
+    void SetParallelCollisionsEnabled(bool enabled);
+    void SetNeighborListSkin(double skin);
+    void SetSweptCollisionEnabled(bool enabled);
+    void SetSweptSpeedThreshold(double threshold);
+    void SetMergeModeEnabled(bool enabled);
+    void SetMergeMassRatio(double ratio);
+    void SetMergeRelativeSpeed(double speed);
+    void SetPersistentTreeEnabled(bool enabled);
+    void SetReorderInterval(size_t interval);
+    void SetOpenDomainEnabled(bool enabled);
+    void SetOutlierPolicy(OutlierPolicy policy);
 private:
     /* Private member variables ------------------------------------------------- */
 
-    int                particleBrushSize;
-    size_t             maxParticleCount;
-    double             newParticleMass;
-    double             simulationTime;
-    double             timeStep;
-    double             totalMass;
-    glm::vec2          newParticleVelocity;
-    SimulationTemplate simulationTemplate;
-    ParticleData*      particleData;
-    Engine*            engine;
-    QuadtreeNodePool*  nodePool;
+    bool                isAccelerationCurrent;
+    bool                isBlockTimeStep;
+    bool                isDirectSummation;
+    bool                isOpenDomain;
+    bool                isParallelCollisions;
+    bool                isSweptCollision;
+    bool                isMergeMode;
+    bool                isPersistentTree;
+    int                 fmmOrder;
+    int                 treePmMeshSize;
+    int                 particleBrushSize;
+    size_t              forceAuditInterval;
+    size_t              framesSinceAudit;
+    size_t              conservationInterval;
+    size_t              framesSinceConservation;
+    size_t              framesSinceReorder;
+    size_t              maxParticleCount;
+    size_t              contactCount;
+    size_t              reorderInterval;
+    double              averageInteractions;
+    double              forceTolerance;
+    double              neighborListSkin;
+    double              sweptSpeedThreshold;
+    double              mergeMassRatio;
+    double              mergeRelativeSpeed;
+    double              newParticleMass;
+    double              simulationTime;
+    double              timeStep;
+    double              theta;
+    double              totalMass;
+    glm::vec2           newParticleVelocity;
+    SimulationTemplate  simulationTemplate;
+    TreeBuildMode       treeBuildMode;
+    ForceWalkMode       forceWalkMode;
+    Integrator          integrator;
+    CollisionBroadphase collisionBroadphase;
+    ConservationReport  conservation;
+    MultipoleOrder      multipoleOrder;
+    ForcePrecision      forcePrecision;
+    OpeningCriterion    openingCriterion;
+    GravitySolver       gravitySolver;
+    OutlierPolicy       outlierPolicy;
+    ParticleData*       particleData;
+    Engine*             engine;
+    QuadtreeNodePool*   nodePool;
+    PersistentQuadtree* persistentTree;
+    FmmSolver*          fmmSolver;
+    TreePmSolver*       treePmSolver;
+    DirectSolver*       directSolver;
+    ForceAudit*         forceAudit;
+    BlockTimeStepper*   blockStepper;
+    CollisionGrid*      collisionGrid;
+    ContactBuffer*      contacts;
+    SweptCollisionSolver* sweptSolver;
+    AccretionSolver*    accretionSolver;
 
     /* Private member functions ------------------------------------------------- */
+
+    void UpdateParticlesBlockStep();
+    void UpdateParticlesSplit();
+    void UpdateConservationReport();
+    QuadtreeNode* PrepareQuadtree(bool allowReorder);
+    void ComputeGravity(QuadtreeNode* root, const std::vector<uint32_t>* active, const uint8_t* activeMask);
+    void ResolveCollisions(QuadtreeNode* root, const std::vector<uint32_t>* active, const uint8_t* activeMask);
+    QuadtreeNode* BuildQuadtree(double centerX, double centerY, double halfSize);
+    void ReorderParticles(double centerX, double centerY, double halfSize);
+    void ApplyOutlierGravity(const QuadtreeNode* root, const OpeningTest& test, const uint8_t* activeMask);
+
     /* Getters ------------------------------------------------------------------ */
     /* Setters ------------------------------------------------------------------ */
 };
@@ -0,0 +1,90 @@
+/**
+  ******************************************************************************
+  * @file    SweptCollision.hpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   Header for SweptCollision.cpp
+  ******************************************************************************
+  * @attention
+  *
+  * Continuous (swept-sphere) collisions for fast movers. Runs after the drift:
+  * every particle moved in a straight line from positions - velocities * dt, so
+  * a particle that moved more than the speed threshold in the step is swept
+  * against everything its path passed near, and against the other fast movers.
+  * Impacts are resolved in time order: both particles get the usual impulse
+  * and continue with their new velocities for the rest of the step, which is
+  * swept again. Slow particles keep the discrete overlap test only.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion ------------------------------------ */
+#ifndef __SWEPT_COLLISION_HPP
+#define __SWEPT_COLLISION_HPP
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "CollisionGrid.hpp"
+#include "ParticleData.hpp"
+
+/* Exported types ----------------------------------------------------------- */
+/* Exported constants ------------------------------------------------------- */
+
+constexpr double SWEPT_SPEED_THRESHOLD = 1.0;   // Particles moving more than this many radii per step are swept
+constexpr int    SWEPT_MAX_IMPACTS     = 4;     // Impacts resolved per fast mover per step
+
+/* Exported macro ----------------------------------------------------------- */
+/* Exported variables ------------------------------------------------------- */
+/* Exported functions ------------------------------------------------------- */
+/* Forward declarations ----------------------------------------------------- */
+/* Class definition --------------------------------------------------------- */
+
+class SweptCollisionSolver
+{
+public:
+    /* Public member variables -------------------------------------------------- */
+    /* Public member functions -------------------------------------------------- */
+
+    SweptCollisionSolver();
+
+    size_t Resolve(ParticleData& particles, double timeStep, double speedThreshold);
+
+    /* Getters ------------------------------------------------------------------ */
+
+    size_t GetFastCount() const;
+    size_t GetHitCount() const;
+
+    /* Setters ------------------------------------------------------------------ */
+private:
+    /* Private member variables ------------------------------------------------- */
+
+    size_t                fastCount;        // Particles swept in the last step
+    size_t                hitCount;         // Impacts resolved in the last step
+    CollisionGrid         grid;             // Cell list over the end-of-step positions
+    std::vector<uint32_t> fastParticles;    // Fast movers, in index order
+    std::vector<double>   nextTimes;        // Earliest impact time of each fast mover
+    std::vector<size_t>   nextHits;         // Particle it hits then (SIZE_MAX for none)
+    std::vector<int>      impactCounts;     // Impacts taken by each fast mover this step
+    std::vector<size_t>   candidates;       // Particles near the current sweep
+    std::vector<uint32_t> movedParticles;   // Particles an impact moved this step (stale in the cell list)
+    std::vector<uint8_t>  movedMask;        // 1 for particles in movedParticles
+
+    /* Private member functions ------------------------------------------------- */
+
+    void   FindFirstImpact(const ParticleData& particles, size_t slot, double fromTime, double timeStep, double margin);
+
+    static double TimeOfImpact(const ParticleData& particles, size_t i, size_t j, double fromTime, double timeStep);
+    static void   ResolveImpact(ParticleData& particles, size_t i, size_t j, double time, double timeStep);
+
+    /* Getters ------------------------------------------------------------------ */
+    /* Setters ------------------------------------------------------------------ */
+};
+
+
+
+#endif /* __SWEPT_COLLISION_HPP */
+
+/******************************** END OF FILE *********************************/
@@ -0,0 +1,119 @@
+/**
+  ******************************************************************************
+  * @file    TreePm.hpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   Header for TreePm.cpp
+  ******************************************************************************
+  * @attention
+  *
+  * TreePM gravity: the pair force is split as f(r) = f(r) g(r/rs) + f(r) (1 - g(r/rs))
+  * with Gadget's smooth split factor g. The long-range part is a convolution of
+  * the mesh mass with the tabulated (1 - g) kernel, done with zero-padded FFTs.
+  * The force falls off as 1/r^2 in the plane, so it is not a 2D Poisson
+  * solution and the kernel is tabulated in real space rather than taken as
+  * -1/k^2. The short-range part is a Barnes-Hut walk that skips anything
+  * beyond TREEPM_CUTOFF split radii, one source list per particle group.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion ------------------------------------ */
+#ifndef __TREE_PM_HPP
+#define __TREE_PM_HPP
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include <complex>
+
+#include "ParticleData.hpp"
+#include "Quadtree.hpp"
+
+/* Exported types ----------------------------------------------------------- */
+
+enum class MeshAssignment
+{
+    Cic,            // Cloud-in-cell: bilinear weights over 2x2 cells
+    Tsc             // Triangular-shaped cloud: quadratic weights over 3x3 cells
+};
+
+/* Exported constants ------------------------------------------------------- */
+
+constexpr int    TREEPM_MIN_MESH         = 32;      // Smallest mesh (cells per side, power of two)
+constexpr int    TREEPM_MAX_MESH         = 1024;    // Largest mesh (the padded FFT grid is twice this per side)
+constexpr int    TREEPM_DEFAULT_MESH     = 256;     // Mesh used by the simulation unless changed
+constexpr double TREEPM_SPLIT_CELLS      = 1.25;    // Split radius rs in mesh cells
+constexpr double TREEPM_CUTOFF           = 5.0;     // Short-range walk ignores everything beyond this many rs (g = 5e-3 there)
+constexpr int    TREEPM_FFT_COLUMN_BLOCK = 8;       // Columns transformed together (one 128-byte read per row)
+constexpr size_t TREEPM_TABLE_SIZE       = 1024;    // Samples of the split factor between r = 0 and the cutoff
+
+/* Exported macro ----------------------------------------------------------- */
+/* Exported variables ------------------------------------------------------- */
+/* Exported functions ------------------------------------------------------- */
+/* Forward declarations ----------------------------------------------------- */
+/* Class definition --------------------------------------------------------- */
+
+class TreePmSolver
+{
+public:
+    /* Public member variables -------------------------------------------------- */
+    /* Public member functions -------------------------------------------------- */
+
+    TreePmSolver();
+
+    void ComputeAccelerations(ParticleData& particles, const QuadtreeNode* root, int meshSize, double theta, size_t* interactions);
+
+    /* Getters ------------------------------------------------------------------ */
+
+    MeshAssignment GetAssignment() const;
+
+    /* Setters ------------------------------------------------------------------ */
+
+    void SetAssignment(MeshAssignment assignment);
+
+private:
+    /* Private member variables ------------------------------------------------- */
+
+    MeshAssignment                    assignment;       // Mass deposit / force interpolation stencil
+    int                               meshSize;         // Cells per side over the root (at least one guard cell on each edge)
+    int                               fftSize;          // Cells per side of the zero-padded FFT grid (2 * meshSize)
+    double                            cellSize;         // Mesh spacing
+    double                            originX;          // Lower-left corner of cell (0, 0)
+    double                            originY;
+    double                            splitRadius;      // rs
+    double                            splitTableScale;  // splitTable entries per unit of r^2
+    std::vector<double>               splitTable;       // g(r / rs) sampled uniformly in r^2 up to the cutoff, then two zeros
+    std::vector<std::complex<double>> kernel;           // Transform of the long-range kernel, x in the real part and y in the imaginary
+    std::vector<std::complex<double>> grid;             // Padded mass grid, then its transform, then the long-range field
+    std::vector<double>               threadMass;       // Per-thread mass grids (meshSize^2 each), summed after the deposit
+    std::vector<glm::dvec2>           field;            // Long-range acceleration per cell (meshSize^2)
+    std::vector<std::complex<double>> twiddles;         // exp(-2 pi i k / fftSize) for k < fftSize / 2
+    std::vector<uint32_t>             bitReverse;       // Bit-reversal permutation of fftSize
+    std::vector<const QuadtreeNode*>  groups;           // Short-range groups (see CollectForceGroups)
+
+    /* Private member functions ------------------------------------------------- */
+
+    void   PrepareMesh(const QuadtreeNode* root, int meshSize);
+    void   BuildKernel();
+    void   Deposit(const ParticleData& particles, const QuadtreeNode* root);
+    void   SolveLongRange();
+    void   Interpolate(ParticleData& particles, const QuadtreeNode* root);
+
+    void   BuildShortRangeList(const QuadtreeNode* node, double xMin, double yMin, double xMax, double yMax, double theta, const ParticleData& particles,
+                               std::vector<double>& sourceX, std::vector<double>& sourceY, std::vector<double>& sourceMass) const;
+
+    void Fft(std::complex<double>* data, bool inverse) const;
+    void Fft2D(std::vector<std::complex<double>>& data, bool inverse, int activeRows);
+
+    /* Getters ------------------------------------------------------------------ */
+    /* Setters ------------------------------------------------------------------ */
+};
+
+
+
+#endif /* __TREE_PM_HPP */
+
+/******************************** END OF FILE *********************************/
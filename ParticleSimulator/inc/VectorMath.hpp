@@ -39,6 +39,20 @@
 // Processes 4 particles per iteration (2 particles per 256-bit AVX2 register)
 constexpr size_t SIMD_WIDTH = 4;
 
+// Source particles per iteration of the force kernel (one double per lane)
+#if defined(__AVX512F__)
+constexpr size_t FORCE_SIMD_WIDTH       = 8;
+constexpr size_t FORCE_SIMD_WIDTH_MIXED = 16;    // ForcePrecision::Mixed (one float per lane)
+#elif defined(__AVX2__)
+constexpr size_t FORCE_SIMD_WIDTH       = 4;
+constexpr size_t FORCE_SIMD_WIDTH_MIXED = 8;
+#else
+constexpr size_t FORCE_SIMD_WIDTH       = 1;
+constexpr size_t FORCE_SIMD_WIDTH_MIXED = 1;
+#endif
+
+constexpr double RSQRT_MIN_DIST2 = 1e-30;   // Floor for the squared distance fed to rsqrt (coincident particles give a zero direction)
+
 /* Exported macro ----------------------------------------------------------- */
 /* Exported variables ------------------------------------------------------- */
 /* Exported functions ------------------------------------------------------- */
@@ -59,13 +73,14 @@ constexpr size_t SIMD_WIDTH = 4;
  *   vel += acc * dt    (fmadd x2)
  *   vel *= damping     (mul   x2)
  *   pos += vel * dt    (fmadd x2)
- *   acc  = 0           (store x2)
+ *
+ * Accelerations are kept: every force solver overwrites them, and the
+ * RelativeForce opening criterion reads them as the previous step's values.
  */
 inline void UpdateParticlesSimd(ParticleData& particleData, size_t startIdx, size_t count, double timeStep)
 {
     const __m256d dt   = _mm256_set1_pd(timeStep);
     const __m256d damp = _mm256_set1_pd(DAMPING_FACTOR);
-    const __m256d zero = _mm256_setzero_pd();
 
     for (size_t i = startIdx; i < startIdx + count; i += SIMD_WIDTH)
     {
@@ -100,11 +115,433 @@ inline void UpdateParticlesSimd(ParticleData& particleData, size_t startIdx, siz
         // Store updated positions
         _mm256_storeu_pd(&particleData.positions[i + 0].x, pos01);
         _mm256_storeu_pd(&particleData.positions[i + 2].x, pos23);
+    }
+}
+
+/**
+ * @brief Scaled add over whole dvec2 arrays: target[i] += source[i] * scale
+ * @param target Array updated in place (velocities for a kick, positions for a drift)
+ * @param source Array read (accelerations for a kick, velocities for a drift)
+ * @param scale  Step length
+ * @param count  Number of elements
+ * @retval None
+ *
+ * The split integrators (leapfrog, Yoshida) kick and drift separately, so
+ * each half is a single fused multiply-add stream over 2 * count doubles.
+ */
+inline void ScaledAddSimd(glm::dvec2* target, const glm::dvec2* source, double scale, size_t count)
+{
+    double*       t = &target[0].x;
+    const double* s = &source[0].x;
+    size_t n = 2 * count;
+    size_t i = 0;
 
-        // Reset accelerations to zero
-        _mm256_storeu_pd(&particleData.accelerations[i + 0].x, zero);
-        _mm256_storeu_pd(&particleData.accelerations[i + 2].x, zero);
+#if defined(__AVX2__)
+    const __m256d h = _mm256_set1_pd(scale);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm256_storeu_pd(t + i, _mm256_fmadd_pd(_mm256_loadu_pd(s + i), h, _mm256_loadu_pd(t + i)));
     }
+#endif
+
+    for (; i < n; ++i)
+    {
+        t[i] += s[i] * scale;
+    }
+}
+
+#if defined(__AVX512F__)
+/**
+ * @brief 1 / sqrt(x) for 8 doubles: 14-bit estimate refined by two Newton steps (~52 bits)
+ * @param x  Positive values
+ * @retval __m512d
+ */
+inline __m512d ReciprocalSqrtAvx512(__m512d x)
+{
+    const __m512d threeHalves = _mm512_set1_pd(1.5);
+    const __m512d halfX       = _mm512_mul_pd(x, _mm512_set1_pd(0.5));
+
+    __m512d y = _mm512_rsqrt14_pd(x);
+    y = _mm512_mul_pd(y, _mm512_fnmadd_pd(halfX, _mm512_mul_pd(y, y), threeHalves));
+    y = _mm512_mul_pd(y, _mm512_fnmadd_pd(halfX, _mm512_mul_pd(y, y), threeHalves));
+    return y;
+}
+#endif
+
+#if defined(__AVX2__)
+/**
+ * @brief 1 / sqrt(x) for 4 doubles: single-precision estimate refined by two Newton steps (~46 bits)
+ * @param x  Positive values within float range
+ * @retval __m256d
+ */
+inline __m256d ReciprocalSqrtAvx2(__m256d x)
+{
+    const __m256d threeHalves = _mm256_set1_pd(1.5);
+    const __m256d halfX       = _mm256_mul_pd(x, _mm256_set1_pd(0.5));
+
+    __m256d y = _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(x)));
+    y = _mm256_mul_pd(y, _mm256_fnmadd_pd(halfX, _mm256_mul_pd(y, y), threeHalves));
+    y = _mm256_mul_pd(y, _mm256_fnmadd_pd(halfX, _mm256_mul_pd(y, y), threeHalves));
+    return y;
+}
+#endif
+
+/**
+ * @brief Gravitational acceleration at (px, py) from point masses stored as SoA arrays
+ * @param px     Target x
+ * @param py     Target y
+ * @param x      Source x coordinates
+ * @param y      Source y coordinates
+ * @param mass   Source masses
+ * @param count  Number of sources
+ * @retval glm::dvec2 Sum of G m d / ((max(|d|^2, MIN^2) + SOFTENING^2) |d|)
+ *
+ * Same force law as the scalar tree walks. A source at exactly the target's
+ * position (the target itself) contributes nothing, so callers do not need to
+ * skip it. Processes FORCE_SIMD_WIDTH sources per iteration (8 with AVX-512,
+ * 4 with AVX2); the remainder uses the scalar formula. Lanes are summed in a
+ * fixed order, so equal inputs always give bit-identical results.
+ */
+inline glm::dvec2 AccumulateAccelerationSimd(double px, double py, const double* x, const double* y, const double* mass, size_t count)
+{
+    double ax = 0.0;
+    double ay = 0.0;
+    size_t k = 0;
+
+#if defined(__AVX512F__)
+    const __m512d targetX  = _mm512_set1_pd(px);
+    const __m512d targetY  = _mm512_set1_pd(py);
+    const __m512d minDist2 = _mm512_set1_pd(MIN_INTERACTION_DISTANCE * MIN_INTERACTION_DISTANCE);
+    const __m512d soft2    = _mm512_set1_pd(SOFTENING * SOFTENING);
+    const __m512d floor2   = _mm512_set1_pd(RSQRT_MIN_DIST2);
+    __m512d sumX = _mm512_setzero_pd();
+    __m512d sumY = _mm512_setzero_pd();
+
+    for (; k + 8 <= count; k += 8)
+    {
+        __m512d dx    = _mm512_sub_pd(_mm512_loadu_pd(x + k), targetX);
+        __m512d dy    = _mm512_sub_pd(_mm512_loadu_pd(y + k), targetY);
+        __m512d dist2 = _mm512_fmadd_pd(dx, dx, _mm512_mul_pd(dy, dy));
+
+        __m512d invDist = ReciprocalSqrtAvx512(_mm512_max_pd(dist2, floor2));
+        __m512d denom   = _mm512_add_pd(_mm512_max_pd(dist2, minDist2), soft2);
+        __m512d s       = _mm512_div_pd(_mm512_mul_pd(_mm512_loadu_pd(mass + k), invDist), denom);
+
+        sumX = _mm512_fmadd_pd(s, dx, sumX);
+        sumY = _mm512_fmadd_pd(s, dy, sumY);
+    }
+
+    ax = _mm512_reduce_add_pd(sumX);
+    ay = _mm512_reduce_add_pd(sumY);
+#elif defined(__AVX2__)
+    const __m256d targetX  = _mm256_set1_pd(px);
+    const __m256d targetY  = _mm256_set1_pd(py);
+    const __m256d minDist2 = _mm256_set1_pd(MIN_INTERACTION_DISTANCE * MIN_INTERACTION_DISTANCE);
+    const __m256d soft2    = _mm256_set1_pd(SOFTENING * SOFTENING);
+    const __m256d floor2   = _mm256_set1_pd(RSQRT_MIN_DIST2);
+    __m256d sumX = _mm256_setzero_pd();
+    __m256d sumY = _mm256_setzero_pd();
+
+    for (; k + 4 <= count; k += 4)
+    {
+        __m256d dx    = _mm256_sub_pd(_mm256_loadu_pd(x + k), targetX);
+        __m256d dy    = _mm256_sub_pd(_mm256_loadu_pd(y + k), targetY);
+        __m256d dist2 = _mm256_fmadd_pd(dx, dx, _mm256_mul_pd(dy, dy));
+
+        __m256d invDist = ReciprocalSqrtAvx2(_mm256_max_pd(dist2, floor2));
+        __m256d denom   = _mm256_add_pd(_mm256_max_pd(dist2, minDist2), soft2);
+        __m256d s       = _mm256_div_pd(_mm256_mul_pd(_mm256_loadu_pd(mass + k), invDist), denom);
+
+        sumX = _mm256_fmadd_pd(s, dx, sumX);
+        sumY = _mm256_fmadd_pd(s, dy, sumY);
+    }
+
+    // [x0+x1, y0+y1, x2+x3, y2+y3] then fold the halves
+    __m256d pairs = _mm256_hadd_pd(sumX, sumY);
+    __m128d total = _mm_add_pd(_mm256_castpd256_pd128(pairs), _mm256_extractf128_pd(pairs, 1));
+    ax = _mm_cvtsd_f64(total);
+    ay = _mm_cvtsd_f64(_mm_unpackhi_pd(total, total));
+#endif
+
+    for (; k < count; ++k)
+    {
+        double dx = x[k] - px;
+        double dy = y[k] - py;
+        double dist2 = dx * dx + dy * dy;
+        double invDist = 1.0 / std::sqrt(std::max(dist2, RSQRT_MIN_DIST2));
+        double s = mass[k] * invDist / (std::max(dist2, MIN_INTERACTION_DISTANCE * MIN_INTERACTION_DISTANCE) + SOFTENING * SOFTENING);
+        ax += s * dx;
+        ay += s * dy;
+    }
+
+    return GRAVITATIONAL_CONSTANT * glm::dvec2(ax, ay);
+}
+
+/**
+ * @brief Mixed-precision version of AccumulateAccelerationSimd
+ * @param px     Target x, relative to a reference point near the sources (e.g. a node center)
+ * @param py     Target y, relative to the same reference point
+ * @param x      Source x offsets from the reference point
+ * @param y      Source y offsets from the reference point
+ * @param gm     Source masses premultiplied by G (m alone can exceed float range)
+ * @param count  Number of sources
+ * @retval glm::dvec2 Sum of G m d / ((max(|d|^2, MIN^2) + SOFTENING^2) |d|)
+ *
+ * Each term is computed in float32, twice as many per instruction as the double
+ * kernel (float rsqrt + one Newton step), then widened and summed in double.
+ * The unit direction d / |d| is formed before scaling so no intermediate can
+ * overflow, even for coincident particles.
+ */
+inline glm::dvec2 AccumulateAccelerationMixed(float px, float py, const float* x, const float* y, const float* gm, size_t count)
+{
+    const float minDist2 = (float)(MIN_INTERACTION_DISTANCE * MIN_INTERACTION_DISTANCE);
+    const float soft2    = (float)(SOFTENING * SOFTENING);
+    const float floor2   = (float)RSQRT_MIN_DIST2;
+    double ax = 0.0;
+    double ay = 0.0;
+    size_t k = 0;
+
+#if defined(__AVX512F__)
+    const __m512 targetX     = _mm512_set1_ps(px);
+    const __m512 targetY     = _mm512_set1_ps(py);
+    const __m512 minDist2V   = _mm512_set1_ps(minDist2);
+    const __m512 soft2V      = _mm512_set1_ps(soft2);
+    const __m512 floor2V     = _mm512_set1_ps(floor2);
+    const __m512 threeHalves = _mm512_set1_ps(1.5f);
+    const __m512 half        = _mm512_set1_ps(0.5f);
+    __m512d sumX = _mm512_setzero_pd();
+    __m512d sumY = _mm512_setzero_pd();
+
+    for (; k + 16 <= count; k += 16)
+    {
+        __m512 dx    = _mm512_sub_ps(_mm512_loadu_ps(x + k), targetX);
+        __m512 dy    = _mm512_sub_ps(_mm512_loadu_ps(y + k), targetY);
+        __m512 dist2 = _mm512_fmadd_ps(dx, dx, _mm512_mul_ps(dy, dy));
+
+        __m512 clamped = _mm512_max_ps(dist2, floor2V);
+        __m512 invDist = _mm512_rsqrt14_ps(clamped);
+        invDist = _mm512_mul_ps(invDist, _mm512_fnmadd_ps(_mm512_mul_ps(half, clamped), _mm512_mul_ps(invDist, invDist), threeHalves));
+
+        __m512 w  = _mm512_div_ps(_mm512_loadu_ps(gm + k), _mm512_add_ps(_mm512_max_ps(dist2, minDist2V), soft2V));
+        __m512 fx = _mm512_mul_ps(w, _mm512_mul_ps(dx, invDist));
+        __m512 fy = _mm512_mul_ps(w, _mm512_mul_ps(dy, invDist));
+
+        sumX = _mm512_add_pd(sumX, _mm512_cvtps_pd(_mm512_castps512_ps256(fx)));
+        sumX = _mm512_add_pd(sumX, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(fx), 1))));
+        sumY = _mm512_add_pd(sumY, _mm512_cvtps_pd(_mm512_castps512_ps256(fy)));
+        sumY = _mm512_add_pd(sumY, _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(fy), 1))));
+    }
+
+    ax = _mm512_reduce_add_pd(sumX);
+    ay = _mm512_reduce_add_pd(sumY);
+#elif defined(__AVX2__)
+    const __m256 targetX     = _mm256_set1_ps(px);
+    const __m256 targetY     = _mm256_set1_ps(py);
+    const __m256 minDist2V   = _mm256_set1_ps(minDist2);
+    const __m256 soft2V      = _mm256_set1_ps(soft2);
+    const __m256 floor2V     = _mm256_set1_ps(floor2);
+    const __m256 threeHalves = _mm256_set1_ps(1.5f);
+    const __m256 half        = _mm256_set1_ps(0.5f);
+    __m256d sumX = _mm256_setzero_pd();
+    __m256d sumY = _mm256_setzero_pd();
+
+    for (; k + 8 <= count; k += 8)
+    {
+        __m256 dx    = _mm256_sub_ps(_mm256_loadu_ps(x + k), targetX);
+        __m256 dy    = _mm256_sub_ps(_mm256_loadu_ps(y + k), targetY);
+        __m256 dist2 = _mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy));
+
+        __m256 clamped = _mm256_max_ps(dist2, floor2V);
+        __m256 invDist = _mm256_rsqrt_ps(clamped);
+        invDist = _mm256_mul_ps(invDist, _mm256_fnmadd_ps(_mm256_mul_ps(half, clamped), _mm256_mul_ps(invDist, invDist), threeHalves));
+
+        __m256 w  = _mm256_div_ps(_mm256_loadu_ps(gm + k), _mm256_add_ps(_mm256_max_ps(dist2, minDist2V), soft2V));
+        __m256 fx = _mm256_mul_ps(w, _mm256_mul_ps(dx, invDist));
+        __m256 fy = _mm256_mul_ps(w, _mm256_mul_ps(dy, invDist));
+
+        // Widen both halves and accumulate in double
+        sumX = _mm256_add_pd(sumX, _mm256_cvtps_pd(_mm256_castps256_ps128(fx)));
+        sumX = _mm256_add_pd(sumX, _mm256_cvtps_pd(_mm256_extractf128_ps(fx, 1)));
+        sumY = _mm256_add_pd(sumY, _mm256_cvtps_pd(_mm256_castps256_ps128(fy)));
+        sumY = _mm256_add_pd(sumY, _mm256_cvtps_pd(_mm256_extractf128_ps(fy, 1)));
+    }
+
+    __m256d pairs = _mm256_hadd_pd(sumX, sumY);
+    __m128d total = _mm_add_pd(_mm256_castpd256_pd128(pairs), _mm256_extractf128_pd(pairs, 1));
+    ax = _mm_cvtsd_f64(total);
+    ay = _mm_cvtsd_f64(_mm_unpackhi_pd(total, total));
+#endif
+
+    for (; k < count; ++k)
+    {
+        float dx = x[k] - px;
+        float dy = y[k] - py;
+        float dist2 = dx * dx + dy * dy;
+        float invDist = 1.0f / std::sqrt(std::max(dist2, floor2));
+        float w = gm[k] / (std::max(dist2, minDist2) + soft2);
+        ax += (double)(w * (dx * invDist));
+        ay += (double)(w * (dy * invDist));
+    }
+
+    return glm::dvec2(ax, ay);
+}
+
+/**
+ * @brief Short-range (TreePM) acceleration at (px, py): the AccumulateAccelerationSimd force scaled by a tabulated split factor
+ * @param px         Target x
+ * @param py         Target y
+ * @param x          Source x coordinates
+ * @param y          Source y coordinates
+ * @param mass       Source masses
+ * @param count      Number of sources
+ * @param table      Split factor sampled uniformly in |d|^2, tableSize + 2 entries, the last two zero
+ * @param tableScale Table entries per unit of |d|^2
+ * @param tableSize  Index of the first zero entry (the cutoff)
+ * @retval glm::dvec2 Sum of G m g(|d|^2) d / ((max(|d|^2, MIN^2) + SOFTENING^2) |d|)
+ *
+ * The factor is linearly interpolated in |d|^2, so no square root is needed for
+ * the lookup; sources past the cutoff clamp to the zero entries. AVX2 reads the
+ * two neighbouring entries with gathers, 4 sources per iteration.
+ */
+inline glm::dvec2 AccumulateSplitAccelerationSimd(double px, double py, const double* x, const double* y, const double* mass, size_t count,
+                                                  const double* table, double tableScale, int tableSize)
+{
+    double ax = 0.0;
+    double ay = 0.0;
+    size_t k = 0;
+
+#if defined(__AVX2__)
+    const __m256d targetX  = _mm256_set1_pd(px);
+    const __m256d targetY  = _mm256_set1_pd(py);
+    const __m256d minDist2 = _mm256_set1_pd(MIN_INTERACTION_DISTANCE * MIN_INTERACTION_DISTANCE);
+    const __m256d soft2    = _mm256_set1_pd(SOFTENING * SOFTENING);
+    const __m256d floor2   = _mm256_set1_pd(RSQRT_MIN_DIST2);
+    const __m256d scale    = _mm256_set1_pd(tableScale);
+    const __m256d last     = _mm256_set1_pd((double)tableSize);
+    __m256d sumX = _mm256_setzero_pd();
+    __m256d sumY = _mm256_setzero_pd();
+
+    for (; k + 4 <= count; k += 4)
+    {
+        __m256d dx    = _mm256_sub_pd(_mm256_loadu_pd(x + k), targetX);
+        __m256d dy    = _mm256_sub_pd(_mm256_loadu_pd(y + k), targetY);
+        __m256d dist2 = _mm256_fmadd_pd(dx, dx, _mm256_mul_pd(dy, dy));
+
+        __m256d t     = _mm256_min_pd(_mm256_mul_pd(dist2, scale), last);
+        __m128i index = _mm256_cvttpd_epi32(t);
+        __m256d frac  = _mm256_sub_pd(t, _mm256_cvtepi32_pd(index));
+        __m256d g0    = _mm256_i32gather_pd(table, index, 8);
+        __m256d g1    = _mm256_i32gather_pd(table + 1, index, 8);
+        __m256d split = _mm256_fmadd_pd(frac, _mm256_sub_pd(g1, g0), g0);
+
+        __m256d invDist = ReciprocalSqrtAvx2(_mm256_max_pd(dist2, floor2));
+        __m256d denom   = _mm256_add_pd(_mm256_max_pd(dist2, minDist2), soft2);
+        __m256d s       = _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_loadu_pd(mass + k), split), invDist), denom);
+
+        sumX = _mm256_fmadd_pd(s, dx, sumX);
+        sumY = _mm256_fmadd_pd(s, dy, sumY);
+    }
+
+    __m256d pairs = _mm256_hadd_pd(sumX, sumY);
+    __m128d total = _mm_add_pd(_mm256_castpd256_pd128(pairs), _mm256_extractf128_pd(pairs, 1));
+    ax = _mm_cvtsd_f64(total);
+    ay = _mm_cvtsd_f64(_mm_unpackhi_pd(total, total));
+#endif
+
+    for (; k < count; ++k)
+    {
+        double dx = x[k] - px;
+        double dy = y[k] - py;
+        double dist2 = dx * dx + dy * dy;
+        double t = std::min(dist2 * tableScale, (double)tableSize);
+        int index = (int)t;
+        double split = table[index] + (t - index) * (table[index + 1] - table[index]);
+        double invDist = 1.0 / std::sqrt(std::max(dist2, RSQRT_MIN_DIST2));
+        double s = mass[k] * split * invDist / (std::max(dist2, MIN_INTERACTION_DISTANCE * MIN_INTERACTION_DISTANCE) + SOFTENING * SOFTENING);
+        ax += s * dx;
+        ay += s * dy;
+    }
+
+    return GRAVITATIONAL_CONSTANT * glm::dvec2(ax, ay);
+}
+
+/**
+ * @brief Bounding box and mass moments of a range of particles using AVX2
+ * @param positions Particle positions
+ * @param masses    Particle masses
+ * @param count     Number of particles
+ * @param minP      Out: smallest x and y
+ * @param maxP      Out: largest x and y
+ * @param moments   Out: (sum m, sum m x, sum m y, sum m (x^2 + y^2))
+ * @retval None
+ *
+ * One _mm256_loadu_pd reads two particles [x0, y0, x1, y1], so the running
+ * min/max registers hold both axes side by side and fold to (x, y) at the end.
+ * The masses [m0, m1] are spread to [m0, m0, m1, m1] to weight both axes.
+ * The moments give the center of mass and the RMS radius of the range.
+ */
+inline void AccumulateBoundsSimd(const glm::dvec2* positions, const double* masses, size_t count, glm::dvec2& minP, glm::dvec2& maxP, glm::dvec4& moments)
+{
+    double minX = HUGE_VAL, minY = HUGE_VAL, maxX = -HUGE_VAL, maxY = -HUGE_VAL;
+    double sumM = 0.0, sumMX = 0.0, sumMY = 0.0, sumMR2 = 0.0;
+    size_t k = 0;
+
+#if defined(__AVX2__)
+    __m256d lo     = _mm256_set1_pd(HUGE_VAL);
+    __m256d hi     = _mm256_set1_pd(-HUGE_VAL);
+    __m256d mass   = _mm256_setzero_pd();
+    __m256d massP  = _mm256_setzero_pd();
+    __m256d massP2 = _mm256_setzero_pd();
+
+    for (; k + 2 <= count; k += 2)
+    {
+        __m256d p  = _mm256_loadu_pd(&positions[k].x);
+        __m256d m  = _mm256_permute4x64_pd(_mm256_castpd128_pd256(_mm_loadu_pd(masses + k)), 0x50);
+        __m256d mp = _mm256_mul_pd(m, p);
+
+        lo     = _mm256_min_pd(lo, p);
+        hi     = _mm256_max_pd(hi, p);
+        mass   = _mm256_add_pd(mass, m);
+        massP  = _mm256_add_pd(massP, mp);
+        massP2 = _mm256_fmadd_pd(mp, p, massP2);
+    }
+
+    // Fold the two particles of each register into (x, y)
+    __m128d lo2 = _mm_min_pd(_mm256_castpd256_pd128(lo), _mm256_extractf128_pd(lo, 1));
+    __m128d hi2 = _mm_max_pd(_mm256_castpd256_pd128(hi), _mm256_extractf128_pd(hi, 1));
+    __m128d m2  = _mm_add_pd(_mm256_castpd256_pd128(mass), _mm256_extractf128_pd(mass, 1));
+    __m128d mp2 = _mm_add_pd(_mm256_castpd256_pd128(massP), _mm256_extractf128_pd(massP, 1));
+    __m128d mr2 = _mm_add_pd(_mm256_castpd256_pd128(massP2), _mm256_extractf128_pd(massP2, 1));
+
+    minX   = _mm_cvtsd_f64(lo2);
+    minY   = _mm_cvtsd_f64(_mm_unpackhi_pd(lo2, lo2));
+    maxX   = _mm_cvtsd_f64(hi2);
+    maxY   = _mm_cvtsd_f64(_mm_unpackhi_pd(hi2, hi2));
+    sumM   = _mm_cvtsd_f64(m2);     // Both lanes hold the same mass sum
+    sumMX  = _mm_cvtsd_f64(mp2);
+    sumMY  = _mm_cvtsd_f64(_mm_unpackhi_pd(mp2, mp2));
+    sumMR2 = _mm_cvtsd_f64(mr2) + _mm_cvtsd_f64(_mm_unpackhi_pd(mr2, mr2));
+#endif
+
+    for (; k < count; ++k)
+    {
+        const glm::dvec2& p = positions[k];
+        double m = masses[k];
+
+        minX = std::min(minX, p.x);
+        minY = std::min(minY, p.y);
+        maxX = std::max(maxX, p.x);
+        maxY = std::max(maxY, p.y);
+        sumM   += m;
+        sumMX  += m * p.x;
+        sumMY  += m * p.y;
+        sumMR2 += m * (p.x * p.x + p.y * p.y);
+    }
+
+    minP    = glm::dvec2(minX, minY);
+    maxP    = glm::dvec2(maxX, maxY);
+    moments = glm::dvec4(sumM, sumMX, sumMY, sumMR2);
 }
 
 /**
@@ -0,0 +1,196 @@
+/**
+  ******************************************************************************
+  * @file    Accretion.cpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    17 OCT 2026
+  * @brief   Merge mode: touching particles coalesce, conserving mass and momentum
+  ******************************************************************************
+  * @attention
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "Accretion.hpp"
+#include "Simulation.hpp"
+
+/* Global variables --------------------------------------------------------- */
+/* Private typedef ---------------------------------------------------------- */
+/* Private define ----------------------------------------------------------- */
+/* Private macro ------------------------------------------------------------ */
+/* Private variables -------------------------------------------------------- */
+/* Private function prototypes ---------------------------------------------- */
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Public Functions                                                           */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  AccretionSolver constructor
+  * @retval None
+  */
+AccretionSolver::AccretionSolver()
+{
+    this->mergeCount      = 0;
+    this->totalMergeCount = 0;
+}
+
+
+/**
+  * @brief  Merge every touching pair that passes the mass ratio or relative speed test
+  * @param  particles     Reference to particle data (SoA)
+  * @param  massRatio     Heavier / lighter mass at or above which a pair merges (0 disables)
+  * @param  relativeSpeed Relative speed below which a pair merges (0 disables)
+  * @retval size_t Particles absorbed (N drops by this much)
+  * @note   Pairs are found once on the positions at the start of the pass and taken in index
+  *         order, so a particle can absorb several neighbors in one pass. Survivors keep their
+  *         order; the absorbed particles are compacted out in a single pass at the end.
+  */
+size_t AccretionSolver::Merge(ParticleData& particles, double massRatio, double relativeSpeed)
+{
+    size_t numParticles = particles.Size();
+
+    this->mergeCount = 0;
+
+    if (numParticles < 2 || (massRatio <= 0.0 && relativeSpeed <= 0.0))
+        return 0;
+
+    this->grid.Build(particles);
+    this->contacts.Clear();
+
+    for (size_t i = 0; i < numParticles; ++i)
+    {
+        const glm::dvec2& posI = particles.positions[i];
+
+        this->neighbors.clear();
+        this->grid.QueryNeighbors(posI, this->neighbors);
+
+        for (size_t j : this->neighbors)
+        {
+            if (j <= i)
+                continue;
+
+            glm::dvec2 d = particles.positions[j] - posI;
+            if (glm::dot(d, d) < 4.0 * PARTICLE_RADIUS * PARTICLE_RADIUS)
+            {
+                this->contacts.first.push_back((uint32_t)i);
+                this->contacts.second.push_back((uint32_t)j);
+            }
+        }
+    }
+
+    this->removed.assign(numParticles, 0);
+
+    for (size_t c = 0; c < this->contacts.first.size(); ++c)
+    {
+        size_t i = this->contacts.first[c];
+        size_t j = this->contacts.second[c];
+
+        if (this->removed[i] || this->removed[j] || !IsMerging(particles, i, j, massRatio, relativeSpeed))
+            continue;
+
+        // The heavier particle survives (the lower index on a tie)
+        size_t survivor = (particles.masses[j] > particles.masses[i]) ? j : i;
+        size_t absorbed = (survivor == i) ? j : i;
+
+        Absorb(particles, survivor, absorbed);
+        this->removed[absorbed] = 1;
+        this->mergeCount++;
+    }
+
+    if (this->mergeCount > 0)
+    {
+        particles.RemoveMarked(this->removed);
+        this->totalMergeCount += this->mergeCount;
+    }
+
+    return this->mergeCount;
+}
+
+
+/**
+  * @brief  Get the number of particles absorbed by the last merge pass
+  * @retval size_t Merges
+  */
+size_t AccretionSolver::GetMergeCount() const
+{
+    return this->mergeCount;
+}
+
+
+/**
+  * @brief  Get the number of particles absorbed since the solver was created
+  * @retval size_t Merges
+  */
+size_t AccretionSolver::GetTotalMergeCount() const
+{
+    return this->totalMergeCount;
+}
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Private Functions                                                          */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  Check whether a touching pair coalesces
+  * @param  particles     Reference to particle data (SoA)
+  * @param  i             First particle
+  * @param  j             Second particle
+  * @param  massRatio     Heavier / lighter mass at or above which a pair merges (0 disables)
+  * @param  relativeSpeed Relative speed below which a pair merges (0 disables)
+  * @retval bool True if the pair merges
+  */
+bool AccretionSolver::IsMerging(const ParticleData& particles, size_t i, size_t j, double massRatio, double relativeSpeed)
+{
+    double heavier = std::max(particles.masses[i], particles.masses[j]);
+    double lighter = std::min(particles.masses[i], particles.masses[j]);
+
+    if (massRatio > 0.0 && heavier >= massRatio * lighter)
+        return true;
+
+    glm::dvec2 relativeVelocity = particles.velocities[j] - particles.velocities[i];
+
+    return relativeSpeed > 0.0 && glm::dot(relativeVelocity, relativeVelocity) < relativeSpeed * relativeSpeed;
+}
+
+
+/**
+  * @brief  Fold one particle into another, conserving mass, momentum and center of mass
+  * @param  particles Reference to particle data (SoA)
+  * @param  survivor  Particle that keeps the combined body
+  * @param  absorbed  Particle folded in (left in place, to be removed)
+  * @retval None
+  * @note   Every particle keeps PARTICLE_RADIUS; only the mass grows. The survivor takes the
+  *         finer of the two block timestep levels.
+  */
+void AccretionSolver::Absorb(ParticleData& particles, size_t survivor, size_t absorbed)
+{
+    double massS = particles.masses[survivor];
+    double massA = particles.masses[absorbed];
+    double mass  = massS + massA;
+
+    particles.positions[survivor]     = (massS * particles.positions[survivor] + massA * particles.positions[absorbed]) / mass;
+    particles.velocities[survivor]    = (massS * particles.velocities[survivor] + massA * particles.velocities[absorbed]) / mass;
+    particles.accelerations[survivor] = (massS * particles.accelerations[survivor] + massA * particles.accelerations[absorbed]) / mass;
+    particles.masses[survivor]        = mass;
+    particles.timeLevels[survivor]    = std::max(particles.timeLevels[survivor], particles.timeLevels[absorbed]);
+}
+
+
+
+/******************************** END OF FILE *********************************/
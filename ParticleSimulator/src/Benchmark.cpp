@@ -0,0 +1,2403 @@
+/**
+  ******************************************************************************
+  * @file    Benchmark.cpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   Headless performance measurements for the simulation kernels
+  ******************************************************************************
+  * @attention
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "Benchmark.hpp"
+#include "Accretion.hpp"
+#include "BlockTimeStep.hpp"
+#include "CollisionGrid.hpp"
+#include "DirectSum.hpp"
+#include "Fmm.hpp"
+#include "ParticleData.hpp"
+#include "Quadtree.hpp"
+#include "Simulation.hpp"
+#include "SweptCollision.hpp"
+#include "TreePm.hpp"
+#include "VectorMath.hpp"
+
+/* Global variables --------------------------------------------------------- */
+/* Private typedef ---------------------------------------------------------- */
+
+typedef std::chrono::high_resolution_clock BENCH_CLOCK_T;
+
+/* Private define ----------------------------------------------------------- */
+/* Private macro ------------------------------------------------------------ */
+/* Private variables -------------------------------------------------------- */
+
+static volatile double benchmarkSink;                           // Results are written here so timed work is not optimized away
+static size_t          benchmarkParticles = MAX_NUM_PARTICLES;  // Particles in the full-size scenes (--particles)
+/* Private function prototypes ---------------------------------------------- */
+
+static void   FillUniform(ParticleData& particles, size_t count, unsigned int seed);
+static void   FillClustered(ParticleData& particles, size_t count, unsigned int seed);
+static void   FillDisk(ParticleData& particles, size_t count, unsigned int seed);
+static void   BenchmarkTreeBuild();
+static void   BenchmarkParallelTreeBuild();
+static void   BenchmarkNodeArena();
+static void   BenchmarkOpenDomain();
+static void   BenchmarkReorder();
+static void   BenchmarkForceWalk();
+static void   BenchmarkStacklessWalk();
+static void   BenchmarkMultipole();
+static void   BenchmarkOpeningCriteria();
+static void   BenchmarkFmm();
+static void   BenchmarkTreePm();
+static void   BenchmarkDirectSum();
+static void   BenchmarkMixedPrecision();
+static void   BenchmarkBlockTimeStep();
+static void   BenchmarkIntegrators();
+static void   BenchmarkCollisionBroadphase();
+static void   BenchmarkParallelCollisions();
+static void   BenchmarkContactPairs();
+static void   BenchmarkVerletLists();
+static void   BenchmarkSweptCollisions();
+static void   BenchmarkAccretion();
+static double EnergyDrift(ParticleData& particles, int solver, size_t steps, QuadtreeNodePool& pool, DirectSolver& direct, double* stepMs, double* finalDrift);
+static double BlockStepDrift(ParticleData& particles, int substeps, size_t frames, QuadtreeNodePool& pool, size_t* evaluations, double* frameMs, int* deepestLevel);
+static void   FillOrbits(ParticleData& particles);
+static double IntegrateOrbits(ParticleData& particles, Integrator integrator, double dt, size_t steps, DirectSolver& direct, size_t* evaluations, double* angularDrift);
+static double TimeTreeWalks(const ParticleData& particles, QuadtreeNodePool& pool);
+static double CacheLinesPerLeaf(const ParticleData& particles, QuadtreeNodePool& pool);
+static double MaxRelativeForceError(const ParticleData& particles, const QuadtreeNode* reference, const QuadtreeNode* candidate, size_t samples);
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Public Functions                                                           */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  Run all benchmarks and log results
+  * @param  particleCount Particles in the full-size scenes
+  * @retval None
+  */
+void RunBenchmarks(size_t particleCount)
+{
+    benchmarkParticles = particleCount;
+
+    LOG_INFO("Running benchmarks (best of %d runs, %zu particles)", BENCHMARK_REPETITIONS, benchmarkParticles);
+
+    BenchmarkTreeBuild();
+    BenchmarkParallelTreeBuild();
+    BenchmarkNodeArena();
+    BenchmarkOpenDomain();
+    BenchmarkReorder();
+    BenchmarkForceWalk();
+    BenchmarkStacklessWalk();
+    BenchmarkMultipole();
+    BenchmarkOpeningCriteria();
+    BenchmarkFmm();
+    BenchmarkTreePm();
+    BenchmarkDirectSum();
+    BenchmarkMixedPrecision();
+    BenchmarkBlockTimeStep();
+    BenchmarkIntegrators();
+    BenchmarkCollisionBroadphase();
+    BenchmarkParallelCollisions();
+    BenchmarkContactPairs();
+    BenchmarkVerletLists();
+    BenchmarkSweptCollisions();
+    BenchmarkAccretion();
+
+    LOG_SUCCESS("Benchmarks complete");
+}
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Private Functions                                                          */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  Fill particle data with particles spread evenly over the viewport
+  * @param  particles
+  * @param  count
+  * @param  seed
+  * @retval None
+  */
+static void FillUniform(ParticleData& particles, size_t count, unsigned int seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> dis(-1.0, 1.0);
+
+    particles.Clear();
+    particles.Reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        particles.AddParticle(1e8, glm::dvec2(dis(gen), dis(gen)), glm::dvec2(0.0));
+    }
+}
+
+
+/**
+  * @brief  Fill particle data with a few dense clumps (brush-painted scenes)
+  * @param  particles
+  * @param  count
+  * @param  seed
+  * @retval None
+  */
+static void FillClustered(ParticleData& particles, size_t count, unsigned int seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> dis(-0.8, 0.8);
+    std::normal_distribution<> spread(0.0, 0.05);
+
+    glm::dvec2 clusters[8];
+    for (glm::dvec2& c : clusters)
+    {
+        c = glm::dvec2(dis(gen), dis(gen));
+    }
+
+    particles.Clear();
+    particles.Reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::dvec2 p = clusters[i % 8] + glm::dvec2(spread(gen), spread(gen));
+        p = glm::clamp(p, glm::dvec2(-1.0), glm::dvec2(1.0));
+        particles.AddParticle(1e8, p, glm::dvec2(0.0));
+    }
+}
+
+
+/**
+  * @brief  Fill particle data with a uniform disk of radius 0.5 (the circle fill template)
+  * @param  particles
+  * @param  count
+  * @param  seed
+  * @retval None
+  */
+static void FillDisk(ParticleData& particles, size_t count, unsigned int seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> angle(0.0, 2.0 * MATH_PI_CONSTANT);
+    std::uniform_real_distribution<> area(0.0, 1.0);
+
+    particles.Clear();
+    particles.Reserve(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        double a = angle(gen);
+        double r = 0.5 * std::sqrt(area(gen));
+        particles.AddParticle(1e8, glm::dvec2(r * std::cos(a), r * std::sin(a)), glm::dvec2(0.0));
+    }
+}
+
+
+/**
+  * @brief  Compare the recursive and Morton (linear) quadtree builders
+  * @param  None
+  * @retval None
+  */
+static void BenchmarkTreeBuild()
+{
+    LOG_INFO("Quadtree build: recursive Insert vs Morton linear build");
+    LOG_INFO("%10s %10s %14s %14s %9s %14s", "scene", "particles", "recursive(ms)", "morton(ms)", "speedup", "max rel err");
+
+    const size_t counts[] = { 10'000, 25'000, benchmarkParticles };
+    const char*  scenes[] = { "uniform", "clustered" };
+
+    ParticleData     particles;
+    QuadtreeNodePool recursivePool;
+    QuadtreeNodePool mortonPool;
+
+    for (int scene = 0; scene < 2; ++scene)
+    {
+        for (size_t count : counts)
+        {
+            if (scene == 0) FillUniform(particles, count, 1234);
+            else            FillClustered(particles, count, 1234);
+
+            double bestRecursive = 1e30;
+            double bestMorton    = 1e30;
+            QuadtreeNode* recursiveRoot = nullptr;
+            QuadtreeNode* mortonRoot    = nullptr;
+
+            for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+            {
+                BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+                recursivePool.Reset();
+                recursiveRoot = BuildQuadtreeRecursive(particles, recursivePool, 0.0, 0.0, 1.001);
+                recursiveRoot->ComputeMassDistribution(particles);
+                BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+                mortonPool.Reset();
+                mortonRoot = BuildQuadtreeMorton(particles, mortonPool, 0.0, 0.0, 1.001);
+                mortonRoot->ComputeMassDistribution(particles);
+                BENCH_CLOCK_T::time_point t2 = BENCH_CLOCK_T::now();
+
+                bestRecursive = std::min(bestRecursive, std::chrono::duration<double, std::milli>(t1 - t0).count());
+                bestMorton    = std::min(bestMorton, std::chrono::duration<double, std::milli>(t2 - t1).count());
+            }
+
+            double error = MaxRelativeForceError(particles, recursiveRoot, mortonRoot, 1000);
+
+            LOG_INFO("%10s %10zu %14.3f %14.3f %8.2fx %14.3e", scenes[scene], count, bestRecursive, bestMorton, bestRecursive / bestMorton, error);
+        }
+    }
+}
+
+
+/**
+  * @brief  Node arena size and build time for ordinary and degenerate scenes
+  * @param  None
+  * @retval None
+  * @note   "pile" squeezes every particle into a 1e-9 wide box (deeper than the Morton
+  *         keys resolve), "duplicates" stacks 10 particles on each of N / 10 positions.
+  *         The old fixed pool held MAX_NUM_PARTICLES * 4 nodes regardless of the scene.
+  */
+static void BenchmarkNodeArena()
+{
+    LOG_INFO("Quadtree node arena (%zu particles, Morton build, old fixed pool %.1f MB)", benchmarkParticles,
+        MAX_NUM_PARTICLES * 4 * (sizeof(QuadtreeNode) + sizeof(QuadtreeNodeCold)) / (1024.0 * 1024.0));
+    LOG_INFO("%10s %10s %10s %10s %10s %12s %10s", "scene", "nodes", "peak", "blocks", "MB", "build(ms)", "in tree");
+
+    const char* sceneNames[] = { "uniform", "clustered", "pile", "duplicates" };
+
+    ParticleData particles;
+    std::mt19937 gen(1234);
+    std::uniform_real_distribution<> dis(-1.0, 1.0);
+
+    for (int scene = 0; scene < 4; ++scene)
+    {
+        if (scene == 0)      FillUniform(particles, benchmarkParticles, 1234);
+        else if (scene == 1) FillClustered(particles, benchmarkParticles, 1234);
+        else
+        {
+            particles.Clear();
+            particles.Reserve(benchmarkParticles);
+            for (size_t i = 0; i < benchmarkParticles; ++i)
+            {
+                glm::dvec2 p = (scene == 2) ? glm::dvec2(0.3 + 1e-9 * dis(gen), 0.3 + 1e-9 * dis(gen))
+                                            : glm::dvec2((i / 10) * 15.0 / benchmarkParticles - 0.75, ((i / 10) % 97) * 1.5e-2 - 0.75);
+                particles.AddParticle(1e8, p, glm::dvec2(0.0));
+            }
+        }
+
+        // A fresh pool per scene so the peak belongs to this scene
+        QuadtreeNodePool pool;
+        QuadtreeNode*    root = nullptr;
+        double           best = 1e30;
+
+        for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+        {
+            BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+            pool.Reset();
+            root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001);
+            root->ComputeMassDistribution(particles);
+            BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+
+            best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+        }
+
+        LOG_INFO("%10s %10zu %10zu %10zu %10.1f %12.3f %9.1f%%", sceneNames[scene], pool.nextIndex, pool.HighWaterMark(),
+            pool.chunks.size(), pool.Capacity() * (sizeof(QuadtreeNode) + sizeof(QuadtreeNodeCold)) / (1024.0 * 1024.0), best,
+            100.0 * root->totalMass / (1e8 * particles.Size()));
+    }
+}
+
+
+/**
+  * @brief  Open-domain root sizing: bounds reduction cost and what each root keeps in the tree
+  * @param  None
+  * @retval None
+  * @note   "galaxy" spreads the particles over [-1000, 1000]; "runaway" is the clustered
+  *         scene plus one body far away. "fixed" is the viewport root used with
+  *         ENABLE_BOUNDING_BOX, which loses everything outside [-1, 1].
+  */
+static void BenchmarkOpenDomain()
+{
+    LOG_INFO("Open-domain root (%zu particles, Morton build, grouped walk)", benchmarkParticles);
+    LOG_INFO("%10s %10s %11s %10s %10s %10s %10s %10s", "scene", "root", "bounds(ms)", "build(ms)", "walk(ms)", "nodes", "outliers", "in tree");
+
+    const char* sceneNames[]  = { "galaxy", "runaway" };
+    const char* policyNames[] = { "fixed", "include", "track" };
+
+    ParticleData     particles;
+    QuadtreeNodePool pool;
+    OpeningTest      test(THETA);
+
+    for (int scene = 0; scene < 2; ++scene)
+    {
+        FillClustered(particles, benchmarkParticles, 1234);
+
+        if (scene == 0)
+        {
+            for (glm::dvec2& p : particles.positions) p *= 1000.0;
+        }
+        else
+        {
+            particles.positions.back() = glm::dvec2(1.0e4, 1.0e4);
+        }
+
+        for (int policy = 0; policy < 3; ++policy)
+        {
+            double bestBounds = 0.0;
+            double bestBuild  = 1e30;
+            double bestWalk   = 1e30;
+            double centerX = 0.0, centerY = 0.0, halfSize = 1.001;
+            QuadtreeNode* root = nullptr;
+
+            if (policy > 0)
+            {
+                bestBounds = 1e30;
+                for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+                {
+                    BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+                    ComputeDomainBounds(particles, (policy == 1) ? OutlierPolicy::Include : OutlierPolicy::Track, pool.domain);
+                    BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+
+                    bestBounds = std::min(bestBounds, std::chrono::duration<double, std::milli>(t1 - t0).count());
+                }
+
+                centerX  = pool.domain.centerX;
+                centerY  = pool.domain.centerY;
+                halfSize = pool.domain.halfSize;
+            }
+
+            for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+            {
+                BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+                pool.Reset();
+                root = BuildQuadtreeMorton(particles, pool, centerX, centerY, halfSize);
+                root->ComputeMassDistribution(particles);
+                BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+                ComputeAccelerationsGrouped(particles, root, test, pool);
+                BENCH_CLOCK_T::time_point t2 = BENCH_CLOCK_T::now();
+
+                bestBuild = std::min(bestBuild, std::chrono::duration<double, std::milli>(t1 - t0).count());
+                bestWalk  = std::min(bestWalk, std::chrono::duration<double, std::milli>(t2 - t1).count());
+            }
+
+            LOG_INFO("%10s %10s %11.3f %10.3f %10.3f %10zu %10zu %9.3f%%", sceneNames[scene], policyNames[policy], bestBounds, bestBuild, bestWalk,
+                pool.nextIndex, (policy > 0) ? pool.domain.outliers.size() : (size_t)0, 100.0 * root->totalMass / (1e8 * particles.Size()));
+        }
+    }
+
+    // The reduction against a plain scalar loop over the same particles
+    double bestScalar = 1e30;
+    for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+    {
+        BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+        glm::dvec2 minP(HUGE_VAL), maxP(-HUGE_VAL);
+        for (const glm::dvec2& p : particles.positions)
+        {
+            minP = glm::min(minP, p);
+            maxP = glm::max(maxP, p);
+        }
+        BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+
+        benchmarkSink = minP.x + maxP.y;
+        bestScalar = std::min(bestScalar, std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+
+    LOG_INFO("Scalar min/max loop (no mass moments): %.3f ms", bestScalar);
+}
+
+
+/**
+  * @brief  Thread scaling of the parallel Morton build + mass aggregation
+  * @param  None
+  * @retval None
+  */
+static void BenchmarkParallelTreeBuild()
+{
+#ifdef _OPENMP
+    LOG_INFO("Parallel quadtree build + mass distribution (%zu particles, uniform)", benchmarkParticles);
+    LOG_INFO("%10s %14s %14s %9s %14s", "threads", "serial(ms)", "parallel(ms)", "speedup", "max rel err");
+
+    const int threadCounts[] = { 1, 2, 4, 8, 16, 32 };
+    int defaultThreads = omp_get_max_threads();
+
+    ParticleData     particles;
+    QuadtreeNodePool serialPool;
+    QuadtreeNodePool parallelPool;
+
+    FillUniform(particles, benchmarkParticles, 1234);
+
+    double bestSerial = 1e30;
+    QuadtreeNode* serialRoot = nullptr;
+
+    for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+    {
+        BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+        serialPool.Reset();
+        serialRoot = BuildQuadtreeMorton(particles, serialPool, 0.0, 0.0, 1.001);
+        serialRoot->ComputeMassDistribution(particles);
+        BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+
+        bestSerial = std::min(bestSerial, std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+
+    for (int threads : threadCounts)
+    {
+        omp_set_num_threads(threads);
+
+        double bestParallel = 1e30;
+        QuadtreeNode* parallelRoot = nullptr;
+
+        for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+        {
+            BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+            parallelPool.Reset();
+            parallelRoot = BuildQuadtreeMortonParallel(particles, parallelPool, 0.0, 0.0, 1.001);
+            ComputeMassDistributionParallel(parallelRoot, particles, parallelPool);
+            BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+
+            bestParallel = std::min(bestParallel, std::chrono::duration<double, std::milli>(t1 - t0).count());
+        }
+
+        double error = MaxRelativeForceError(particles, serialRoot, parallelRoot, 1000);
+
+        LOG_INFO("%10d %14.3f %14.3f %8.2fx %14.3e", threads, bestSerial, bestParallel, bestSerial / bestParallel, error);
+    }
+
+    omp_set_num_threads(defaultThreads);
+#else
+    LOG_WARN("Parallel quadtree build benchmark skipped (built without OpenMP)");
+#endif
+}
+
+
+/**
+  * @brief  Compare tree walks over particles in insertion order vs Morton order
+  * @param  None
+  * @retval None
+  * @note   Runs at 100k particles. Hardware counters are not portable here, so cache misses
+  *         are estimated by the distinct 64-byte lines of the position array each leaf
+  *         touches (fewer lines per leaf means fewer misses per walk).
+  */
+static void BenchmarkReorder()
+{
+    const size_t count = 100'000;
+
+    LOG_INFO("Particle ordering: build + force + collision query pass (%zu particles)", count);
+    LOG_INFO("%10s %14s %14s %9s %14s %14s %14s", "scene", "unsorted(ms)", "morton(ms)", "speedup", "reorder(ms)", "lines/leaf", "morton lines");
+
+    const char* sceneNames[] = { "uniform", "clustered" };
+
+    ParticleData     particles;
+    QuadtreeNodePool pool;
+
+    for (int scene = 0; scene < 2; ++scene)
+    {
+        if (scene == 0) FillUniform(particles, count, 1234);
+        else            FillClustered(particles, count, 1234);
+
+        double bestUnsorted  = TimeTreeWalks(particles, pool);
+        double linesUnsorted = CacheLinesPerLeaf(particles, pool);
+
+        // The second reorder reuses the scratch buffers grown by the first
+        double reorderTime = 1e30;
+        for (int run = 0; run < 2; ++run)
+        {
+            BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+            ComputeMortonOrder(particles, pool, 0.0, 0.0, 1.001);
+            particles.Reorder(pool.sortedIndices);
+            BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+
+            reorderTime = std::min(reorderTime, std::chrono::duration<double, std::milli>(t1 - t0).count());
+        }
+
+        double bestSorted  = TimeTreeWalks(particles, pool);
+        double linesSorted = CacheLinesPerLeaf(particles, pool);
+
+        LOG_INFO("%10s %14.3f %14.3f %8.2fx %14.3f %14.2f %14.2f", sceneNames[scene], bestUnsorted, bestSorted, bestUnsorted / bestSorted, reorderTime,
+                 linesUnsorted, linesSorted);
+    }
+}
+
+
+/**
+  * @brief  Best time of a Morton build, mass pass, Barnes-Hut force pass and collision queries
+  * @param  particles   Reference to particle data (SoA)
+  * @param  pool        Node pool to build into
+  * @retval double      Milliseconds
+  */
+static double TimeTreeWalks(const ParticleData& particles, QuadtreeNodePool& pool)
+{
+    size_t numParticles = particles.Size();
+    double best = 1e30;
+    double checksum = 0.0;
+
+    std::vector<size_t> neighbors;
+    neighbors.reserve(32);
+
+    for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+    {
+        BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+        pool.Reset();
+        QuadtreeNode* root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001);
+        root->ComputeMassDistribution(particles);
+
+        for (size_t i = 0; i < numParticles; ++i)
+        {
+            glm::dvec2 force = ComputeForceBarnesHut(i, particles, root, THETA);
+            checksum += force.x;
+
+            const glm::dvec2& p = particles.positions[i];
+            double range = 2.0 * PARTICLE_RADIUS;
+
+            neighbors.clear();
+            root->QueryRange(p.x - range, p.y - range, p.x + range, p.y + range, neighbors);
+            checksum += (double)neighbors.size();
+        }
+        BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+
+        best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+
+    benchmarkSink = checksum;
+
+    return best;
+}
+
+
+/**
+  * @brief  Cache-miss proxy: distinct 64-byte lines of the position array touched per leaf
+  * @param  particles   Reference to particle data (SoA)
+  * @param  pool        Node pool to build into
+  * @retval double      Lines per non-empty leaf
+  */
+static double CacheLinesPerLeaf(const ParticleData& particles, QuadtreeNodePool& pool)
+{
+    pool.Reset();
+    QuadtreeNode* root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001);
+
+    std::vector<const QuadtreeNode*> stack = { root };
+    std::vector<size_t> lines;
+    size_t totalLines = 0;
+    size_t leaves = 0;
+
+    while (!stack.empty())
+    {
+        const QuadtreeNode* node = stack.back();
+        stack.pop_back();
+
+        if (node->children)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                stack.push_back(&node->children[c]);
+            }
+            continue;
+        }
+
+        lines.clear();
+        for (const QuadtreeNode* bucket = node; bucket; bucket = bucket->cold->overflow)
+        {
+            for (size_t k = 0; k < bucket->cold->particleCount; ++k)
+            {
+                lines.push_back(bucket->cold->particleIndices[k] * sizeof(glm::dvec2) / 64);
+            }
+        }
+
+        if (lines.empty())
+            continue;
+
+        std::sort(lines.begin(), lines.end());
+        totalLines += std::unique(lines.begin(), lines.end()) - lines.begin();
+        leaves++;
+    }
+
+    return (double)totalLines / (double)std::max<size_t>(leaves, 1);
+}
+
+
+/**
+  * @brief  Compare the per-particle Barnes-Hut walk with the grouped (interaction list) walk
+  * @param  None
+  * @retval None
+  */
+static void BenchmarkForceWalk()
+{
+    LOG_INFO("Force walk: per particle vs grouped (%zu particles, Morton order, theta %.2f)", benchmarkParticles, THETA);
+    LOG_INFO("%10s %14s %14s %9s %14s %14s", "scene", "particle(ms)", "grouped(ms)", "speedup", "particle rms", "grouped rms");
+
+    const char* sceneNames[] = { "uniform", "clustered" };
+    const size_t samples = 500;
+
+    ParticleData     particles;
+    QuadtreeNodePool pool;
+
+    for (int scene = 0; scene < 2; ++scene)
+    {
+        if (scene == 0) FillUniform(particles, benchmarkParticles, 1234);
+        else            FillClustered(particles, benchmarkParticles, 1234);
+
+        size_t numParticles = particles.Size();
+
+        ComputeMortonOrder(particles, pool, 0.0, 0.0, 1.001);
+        particles.Reorder(pool.sortedIndices);
+
+        pool.Reset();
+        QuadtreeNode* root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001);
+        root->ComputeMassDistribution(particles);
+
+        std::vector<glm::dvec2> perParticle(numParticles);
+
+        double bestPerParticle = 1e30;
+        double bestGrouped     = 1e30;
+
+        for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+        {
+            BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+            #pragma omp parallel for schedule(dynamic, 64)
+            for (int i = 0; i < (int)numParticles; ++i)
+            {
+                perParticle[i] = ComputeForceBarnesHut(i, particles, root, THETA) / particles.masses[i];
+            }
+            BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+            ComputeAccelerationsGrouped(particles, root, THETA, pool);
+            BENCH_CLOCK_T::time_point t2 = BENCH_CLOCK_T::now();
+
+            bestPerParticle = std::min(bestPerParticle, std::chrono::duration<double, std::milli>(t1 - t0).count());
+            bestGrouped     = std::min(bestGrouped, std::chrono::duration<double, std::milli>(t2 - t1).count());
+        }
+
+        // RMS error of both walks against direct summation on evenly spaced samples
+        double exactNorm2       = 0.0;
+        double perParticleErr2  = 0.0;
+        double groupedErr2      = 0.0;
+        for (size_t i = 0; i < numParticles; i += numParticles / samples)
+        {
+            glm::dvec2 exact = ComputeAccelerationDirect(i, particles);
+            glm::dvec2 perParticleDiff = perParticle[i] - exact;
+            glm::dvec2 groupedDiff     = particles.accelerations[i] - exact;
+
+            exactNorm2      += glm::dot(exact, exact);
+            perParticleErr2 += glm::dot(perParticleDiff, perParticleDiff);
+            groupedErr2     += glm::dot(groupedDiff, groupedDiff);
+        }
+
+        LOG_INFO("%10s %14.3f %14.3f %8.2fx %14.3e %14.3e", sceneNames[scene], bestPerParticle, bestGrouped,
+            bestPerParticle / bestGrouped, std::sqrt(perParticleErr2 / exactNorm2), std::sqrt(groupedErr2 / exactNorm2));
+    }
+
+    // Depth-capped leaves: piles of coincident particles fill overflow chains far past FORCE_GROUP_SIZE
+    // Away from the piles the two walks differ by the opening test alone, so only pile members are compared
+    LOG_INFO("%10s %10s %10s %10s %14s", "piles", "per pile", "groups", "missed", "pile rel diff");
+
+    const size_t pileSizes[] = { 20, 100, 1000 };
+    std::mt19937 gen(1234);
+    std::uniform_real_distribution<> dis(-0.75, 0.75);
+
+    for (size_t pileSize : pileSizes)
+    {
+        const size_t numPiles = 20;
+
+        size_t firstPiled = benchmarkParticles / 10;
+        FillUniform(particles, firstPiled, 1234);
+        for (size_t pile = 0; pile < numPiles; ++pile)
+        {
+            glm::dvec2 spot(dis(gen), dis(gen));
+            for (size_t k = 0; k < pileSize; ++k)
+            {
+                particles.AddParticle(1e8, spot, glm::dvec2(0.0));
+            }
+        }
+
+        // Piles sit at the root, depth-capped leaves included
+        size_t numParticles = particles.Size();
+        pool.Reset();
+        QuadtreeNode* root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001);
+        root->ComputeMassDistribution(particles);
+
+        // Poison the accelerations so particles the grouped walk skips show up
+        for (size_t i = 0; i < numParticles; ++i)
+        {
+            particles.accelerations[i] = glm::dvec2(std::nan(""));
+        }
+        ComputeAccelerationsGrouped(particles, root, THETA, pool);
+
+        size_t missed  = 0;
+        double maxDiff = 0.0;
+        for (size_t i = 0; i < numParticles; ++i)
+        {
+            if (std::isnan(particles.accelerations[i].x))
+            {
+                missed++;
+                continue;
+            }
+
+            if (i < firstPiled)
+                continue;
+
+            glm::dvec2 perParticle = ComputeForceBarnesHut(i, particles, root, THETA) / particles.masses[i];
+            maxDiff = std::max(maxDiff, glm::length(particles.accelerations[i] - perParticle) / std::max(glm::length(perParticle), 1e-30));
+        }
+
+        LOG_INFO("%10zu %10zu %10zu %10zu %14.3e", numPiles, pileSize, pool.forceGroups.size(), missed, maxDiff);
+    }
+}
+
+
+/**
+  * @brief  Compare the recursive per-particle walk with the stackless walk (results must match bit for bit)
+  * @param  None
+  * @retval None
+  */
+static void BenchmarkStacklessWalk()
+{
+    LOG_INFO("Per-particle walk: recursive vs stackless (%zu particles, Morton order)", benchmarkParticles);
+    LOG_INFO("Node size: QuadtreeNode %zu bytes + %zu cold (pool block %.1f MB), FlatQuadtreeNode %zu bytes",
+        sizeof(QuadtreeNode), sizeof(QuadtreeNodeCold), POOL_CHUNK_NODES * (sizeof(QuadtreeNode) + sizeof(QuadtreeNodeCold)) / (1024.0 * 1024.0),
+        sizeof(FlatQuadtreeNode));
+    LOG_INFO("%10s %8s %14s %14s %9s %10s", "scene", "theta", "recursive(ms)", "stackless(ms)", "speedup", "identical");
+
+    const char*  sceneNames[] = { "uniform", "clustered" };
+    const double thetas[]     = { 0.5, THETA };
+
+    ParticleData     particles;
+    QuadtreeNodePool pool;
+
+    for (int scene = 0; scene < 2; ++scene)
+    {
+        if (scene == 0) FillUniform(particles, benchmarkParticles, 1234);
+        else            FillClustered(particles, benchmarkParticles, 1234);
+
+        size_t numParticles = particles.Size();
+
+        ComputeMortonOrder(particles, pool, 0.0, 0.0, 1.001);
+        particles.Reorder(pool.sortedIndices);
+
+        pool.Reset();
+        QuadtreeNode* root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001);
+        root->ComputeMassDistribution(particles);
+
+        std::vector<glm::dvec2> recursive(numParticles);
+        std::vector<glm::dvec2> stackless(numParticles);
+
+        for (double theta : thetas)
+        {
+            double bestRecursive = 1e30;
+            double bestStackless = 1e30;
+
+            for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+            {
+                BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+                #pragma omp parallel for schedule(dynamic, 64)
+                for (int i = 0; i < (int)numParticles; ++i)
+                {
+                    recursive[i] = ComputeForceBarnesHut(i, particles, root, theta);
+                }
+                BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+                pool.flatTree.Build(root, particles);
+                #pragma omp parallel for schedule(dynamic, 64)
+                for (int i = 0; i < (int)numParticles; ++i)
+                {
+                    stackless[i] = ComputeForceBarnesHutStackless(i, particles, pool.flatTree, theta);
+                }
+                BENCH_CLOCK_T::time_point t2 = BENCH_CLOCK_T::now();
+
+                bestRecursive = std::min(bestRecursive, std::chrono::duration<double, std::milli>(t1 - t0).count());
+                bestStackless = std::min(bestStackless, std::chrono::duration<double, std::milli>(t2 - t1).count());
+            }
+
+            bool identical = std::memcmp(recursive.data(), stackless.data(), numParticles * sizeof(glm::dvec2)) == 0;
+
+            LOG_INFO("%10s %8.2f %14.3f %14.3f %8.2fx %10s", sceneNames[scene], theta, bestRecursive, bestStackless,
+                bestRecursive / bestStackless, identical ? "yes" : "NO");
+        }
+    }
+}
+
+
+/**
+  * @brief  Accuracy vs time of monopole and quadrupole far fields over a range of theta
+  * @param  None
+  * @retval None
+  */
+static void BenchmarkMultipole()
+{
+    LOG_INFO("Far-field accuracy vs direct summation (%zu particles, grouped walk)", benchmarkParticles);
+    LOG_INFO("%10s %8s %12s %14s %14s", "scene", "theta", "order", "time(ms)", "rms rel err");
+
+    const char*  sceneNames[] = { "uniform", "clustered" };
+    const double thetas[]     = { 0.5, 0.75, 1.0, 1.5, 2.0 };
+    const size_t samples      = 500;
+
+    ParticleData     particles;
+    QuadtreeNodePool pool;
+
+    for (int scene = 0; scene < 2; ++scene)
+    {
+        if (scene == 0) FillUniform(particles, benchmarkParticles, 1234);
+        else            FillClustered(particles, benchmarkParticles, 1234);
+
+        size_t numParticles = particles.Size();
+        size_t stride = numParticles / samples;
+
+        ComputeMortonOrder(particles, pool, 0.0, 0.0, 1.001);
+        particles.Reorder(pool.sortedIndices);
+
+        pool.Reset();
+        QuadtreeNode* root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001);
+        root->ComputeMassDistribution(particles);
+
+        std::vector<glm::dvec2> exact;
+        for (size_t i = 0; i < numParticles; i += stride)
+        {
+            exact.push_back(ComputeAccelerationDirect(i, particles));
+        }
+
+        for (double theta : thetas)
+        {
+            for (int order = 0; order < 2; ++order)
+            {
+                MultipoleOrder multipoleOrder = static_cast<MultipoleOrder>(order);
+                double best = 1e30;
+
+                for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+                {
+                    BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+                    ComputeAccelerationsGrouped(particles, root, theta, pool, multipoleOrder);
+                    BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+
+                    best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+                }
+
+                double exactNorm2 = 0.0;
+                double error2     = 0.0;
+                for (size_t s = 0; s < exact.size(); ++s)
+                {
+                    glm::dvec2 diff = particles.accelerations[s * stride] - exact[s];
+                    exactNorm2 += glm::dot(exact[s], exact[s]);
+                    error2     += glm::dot(diff, diff);
+                }
+
+                LOG_INFO("%10s %8.2f %12s %14.3f %14.3e", sceneNames[scene], theta, order ? "quadrupole" : "monopole",
+                    best, std::sqrt(error2 / exactNorm2));
+            }
+        }
+    }
+}
+
+
+/**
+  * @brief  Cost (interactions, time) vs accuracy of each opening criterion on the per-particle walk
+  * @param  None
+  * @retval None
+  * @note   RelativeForce needs last step's accelerations, so they are seeded by a theta 0.5 walk.
+  */
+static void BenchmarkOpeningCriteria()
+{
+    LOG_INFO("Opening criteria vs direct summation (%zu particles, per-particle walk, monopole)", benchmarkParticles);
+    LOG_INFO("%10s %14s %10s %14s %14s %14s", "scene", "criterion", "parameter", "interactions", "time(ms)", "rms rel err");
+
+    struct CriterionCase
+    {
+        OpeningCriterion criterion;
+        const char*      name;
+        double           parameter;
+    };
+
+    const CriterionCase cases[] = {
+        { OpeningCriterion::Geometric,     "geometric",     0.5  },
+        { OpeningCriterion::Geometric,     "geometric",     1.0  },
+        { OpeningCriterion::MinDistance,   "min-distance",  0.5  },
+        { OpeningCriterion::MinDistance,   "min-distance",  1.0  },
+        { OpeningCriterion::SalmonWarren,  "salmon-warren", 1e-3 },
+        { OpeningCriterion::SalmonWarren,  "salmon-warren", 1e-2 },
+        { OpeningCriterion::RelativeForce, "relative",      1e-3 },
+        { OpeningCriterion::RelativeForce, "relative",      5e-3 },
+    };
+    const char*  sceneNames[] = { "uniform", "clustered" };
+    const size_t samples      = 500;
+
+    ParticleData            particles;
+    QuadtreeNodePool        pool;
+    std::vector<glm::dvec2> forces;
+
+    for (int scene = 0; scene < 2; ++scene)
+    {
+        if (scene == 0) FillUniform(particles, benchmarkParticles, 1234);
+        else            FillClustered(particles, benchmarkParticles, 1234);
+
+        int numParticles = (int)particles.Size();
+        size_t stride = numParticles / samples;
+        forces.resize(numParticles);
+
+        ComputeMortonOrder(particles, pool, 0.0, 0.0, 1.001);
+        particles.Reorder(pool.sortedIndices);
+
+        pool.Reset();
+        QuadtreeNode* root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001);
+        root->ComputeMassDistribution(particles);
+
+        #pragma omp parallel for schedule(dynamic, 64)
+        for (int i = 0; i < numParticles; ++i)
+        {
+            particles.accelerations[i] = ComputeForceBarnesHut(i, particles, root, 0.5) / particles.masses[i];
+        }
+
+        std::vector<glm::dvec2> exact;
+        for (size_t i = 0; i < (size_t)numParticles; i += stride)
+        {
+            exact.push_back(ComputeAccelerationDirect(i, particles));
+        }
+
+        for (const CriterionCase& c : cases)
+        {
+            bool isErrorBased = (c.criterion == OpeningCriterion::SalmonWarren || c.criterion == OpeningCriterion::RelativeForce);
+            OpeningTest test(c.criterion, isErrorBased ? THETA : c.parameter, isErrorBased ? c.parameter : FORCE_TOLERANCE);
+            test.Prepare(root);
+
+            double best = 1e30;
+            size_t interactions = 0;
+
+            for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+            {
+                interactions = 0;
+
+                BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+                #pragma omp parallel for schedule(dynamic, 64) reduction(+:interactions)
+                for (int i = 0; i < numParticles; ++i)
+                {
+                    forces[i] = ComputeForceBarnesHut(i, particles, root, test, MultipoleOrder::Monopole, &interactions);
+                }
+                BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+
+                best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+            }
+
+            double exactNorm2 = 0.0;
+            double error2     = 0.0;
+            for (size_t s = 0; s < exact.size(); ++s)
+            {
+                glm::dvec2 diff = forces[s * stride] / particles.masses[s * stride] - exact[s];
+                exactNorm2 += glm::dot(exact[s], exact[s]);
+                error2     += glm::dot(diff, diff);
+            }
+
+            LOG_INFO("%10s %14s %10.2g %14.1f %14.3f %14.3e", sceneNames[scene], c.name, c.parameter,
+                (double)interactions / numParticles, best, std::sqrt(error2 / exactNorm2));
+        }
+    }
+}
+
+
+/**
+  * @brief  FMM time and accuracy across particle count and expansion order (Barnes-Hut for reference)
+  * @param  None
+  * @retval None
+  */
+static void BenchmarkFmm()
+{
+    LOG_INFO("FMM vs Barnes-Hut (uniform, Morton order, FMM theta %.2f)", FMM_THETA);
+    LOG_INFO("%10s %14s %14s %14s %14s", "particles", "solver", "time(ms)", "ns/particle", "rms rel err");
+
+    const size_t counts[] = { 10'000, 25'000, benchmarkParticles };
+    const int    orders[] = { 2, 4, 6, 8 };
+    const size_t samples  = 500;
+
+    ParticleData     particles;
+    QuadtreeNodePool pool;
+    FmmSolver        fmm;
+
+    for (size_t count : counts)
+    {
+        FillUniform(particles, count, 1234);
+
+        size_t stride = count / samples;
+
+        ComputeMortonOrder(particles, pool, 0.0, 0.0, 1.001);
+        particles.Reorder(pool.sortedIndices);
+
+        pool.Reset();
+        QuadtreeNode* root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001);
+        root->ComputeMassDistribution(particles);
+
+        std::vector<glm::dvec2> exact;
+        for (size_t i = 0; i < count; i += stride)
+        {
+            exact.push_back(ComputeAccelerationDirect(i, particles));
+        }
+
+        // Barnes-Hut reference row, then one row per FMM order
+        for (int row = -1; row < (int)(sizeof(orders) / sizeof(orders[0])); ++row)
+        {
+            double best = 1e30;
+
+            for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+            {
+                BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+                if (row < 0) ComputeAccelerationsGrouped(particles, root, THETA, pool);
+                else         fmm.ComputeAccelerations(particles, root, pool, orders[row]);
+                BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+
+                best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+            }
+
+            double exactNorm2 = 0.0;
+            double error2     = 0.0;
+            for (size_t s = 0; s < exact.size(); ++s)
+            {
+                glm::dvec2 diff = particles.accelerations[s * stride] - exact[s];
+                exactNorm2 += glm::dot(exact[s], exact[s]);
+                error2     += glm::dot(diff, diff);
+            }
+
+            char solverName[32];
+            if (row < 0) sprintf_s(solverName, "BH theta %.1f", THETA);
+            else         sprintf_s(solverName, "FMM p=%d", orders[row]);
+
+            LOG_INFO("%10zu %14s %14.3f %14.1f %14.3e", count, solverName, best, best * 1e6 / count, std::sqrt(error2 / exactNorm2));
+        }
+    }
+}
+
+
+/**
+  * @brief  TreePM vs Barnes-Hut on a dense uniform scene (SquareFill-like) up to 20x the scene size
+  * @param  None
+  * @retval None
+  * @note   The mesh grows with sqrt(N) (about four particles per cell). Scenes above the normal
+  *         size take the best of two runs, since the tree walk alone takes seconds there.
+  */
+static void BenchmarkTreePm()
+{
+    const double theta = 0.5;
+
+    LOG_INFO("TreePM vs Barnes-Hut (uniform, Morton order, theta %.1f, split %.2f cells, cutoff %.1f rs)", theta, TREEPM_SPLIT_CELLS, TREEPM_CUTOFF);
+    LOG_INFO("%10s %18s %14s %14s %14s %14s", "particles", "solver", "time(ms)", "ns/particle", "terms/particle", "rms rel err");
+
+    const size_t counts[] = { benchmarkParticles, 4 * benchmarkParticles, 20 * benchmarkParticles };
+    const size_t samples  = 200;
+
+    ParticleData     particles;
+    QuadtreeNodePool pool;
+    TreePmSolver     treePm;
+
+    for (size_t count : counts)
+    {
+        FillUniform(particles, count, 1234);
+
+        size_t stride = count / samples;
+        int    runs   = (count > benchmarkParticles) ? 2 : BENCHMARK_REPETITIONS;
+
+        int meshSize = TREEPM_MIN_MESH;
+        while (meshSize < TREEPM_MAX_MESH && meshSize * meshSize < (int)(count / 4))
+            meshSize *= 2;
+
+        ComputeMortonOrder(particles, pool, 0.0, 0.0, 1.001);
+        particles.Reorder(pool.sortedIndices);
+
+        pool.Reset();
+        QuadtreeNode* root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001);
+        root->ComputeMassDistribution(particles);
+
+        std::vector<glm::dvec2> exact;
+        for (size_t i = 0; i < count; i += stride)
+        {
+            exact.push_back(ComputeAccelerationDirect(i, particles));
+        }
+
+        // Barnes-Hut reference row, then TreePM with each mass assignment, then TSC with a wider short-range angle
+        for (int row = 0; row < 4; ++row)
+        {
+            double best = 1e30;
+            size_t interactions = 0;
+            double rowTheta = (row == 3) ? 2.0 * theta : theta;
+
+            for (int run = 0; run < runs; ++run)
+            {
+                interactions = 0;
+
+                BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+                if (row == 0)
+                {
+                    ComputeAccelerationsGrouped(particles, root, rowTheta, pool, MultipoleOrder::Monopole, &interactions);
+                }
+                else
+                {
+                    treePm.SetAssignment(row == 1 ? MeshAssignment::Cic : MeshAssignment::Tsc);
+                    treePm.ComputeAccelerations(particles, root, meshSize, rowTheta, &interactions);
+                }
+                BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+
+                best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+            }
+
+            double exactNorm2 = 0.0;
+            double error2     = 0.0;
+            for (size_t s = 0; s < exact.size(); ++s)
+            {
+                glm::dvec2 diff = particles.accelerations[s * stride] - exact[s];
+                exactNorm2 += glm::dot(exact[s], exact[s]);
+                error2     += glm::dot(diff, diff);
+            }
+
+            char solverName[32];
+            if (row == 0) sprintf_s(solverName, "BH grouped");
+            else          sprintf_s(solverName, "PM %s %d t%.1f", row == 1 ? "CIC" : "TSC", meshSize, rowTheta);
+
+            LOG_INFO("%10zu %18s %14.3f %14.1f %14.1f %14.3e", count, solverName, best, best * 1e6 / count,
+                (double)interactions / count, std::sqrt(error2 / exactNorm2));
+        }
+    }
+}
+
+
+/**
+  * @brief  SIMD all-pairs summation vs the scalar direct loop and a full Barnes-Hut step at small N
+  * @param  None
+  * @retval None
+  * @note   The tree column includes the Morton build and mass aggregation, since the direct
+  *         mode replaces all three. Error is the largest relative difference to the scalar loop.
+  */
+static void BenchmarkDirectSum()
+{
+    LOG_INFO("Direct summation vs Barnes-Hut at small N (clustered, theta %.2f, force kernel width %zu)", THETA, FORCE_SIMD_WIDTH);
+    LOG_INFO("%10s %14s %14s %14s %14s", "particles", "scalar(ms)", "simd(ms)", "tree(ms)", "simd max err");
+
+    const size_t counts[] = { 16, 64, 128, 256, 512, 1024, 2048, 4096 };
+
+    ParticleData            particles;
+    QuadtreeNodePool        pool;
+    DirectSolver            solver;
+    std::vector<glm::dvec2> scalar;
+
+    for (size_t count : counts)
+    {
+        FillClustered(particles, count, 1234);
+        int numParticles = (int)particles.Size();
+        scalar.resize(numParticles);
+
+        double bestScalar = 1e30;
+        double bestSimd   = 1e30;
+        double bestTree   = 1e30;
+
+        for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+        {
+            BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+            #pragma omp parallel for schedule(static) if(numParticles > 256)
+            for (int i = 0; i < numParticles; ++i)
+            {
+                scalar[i] = ComputeAccelerationDirect(i, particles);
+            }
+            BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+            solver.ComputeAccelerations(particles);
+            BENCH_CLOCK_T::time_point t2 = BENCH_CLOCK_T::now();
+
+            bestScalar = std::min(bestScalar, std::chrono::duration<double, std::milli>(t1 - t0).count());
+            bestSimd   = std::min(bestSimd,   std::chrono::duration<double, std::milli>(t2 - t1).count());
+        }
+
+        double maxError = 0.0;
+        for (int i = 0; i < numParticles; ++i)
+        {
+            maxError = std::max(maxError, glm::length(particles.accelerations[i] - scalar[i]) / glm::length(scalar[i]));
+        }
+
+        for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+        {
+            BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+            pool.Reset();
+            QuadtreeNode* root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001);
+            root->ComputeMassDistribution(particles);
+            ComputeAccelerationsGrouped(particles, root, THETA, pool);
+            BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+
+            bestTree = std::min(bestTree, std::chrono::duration<double, std::milli>(t1 - t0).count());
+        }
+
+        LOG_INFO("%10zu %14.4f %14.4f %14.4f %14.3e", count, bestScalar, bestSimd, bestTree, maxError);
+    }
+}
+
+
+/**
+  * @brief  Double vs mixed-precision grouped walk: speed, force difference and energy drift
+  * @param  None
+  * @retval None
+  * @note   The drift runs use template-sized scenes (2,000 particles of 1e8 kg, starting at
+  *         rest) without walls or collisions, integrated like the simulation (symplectic Euler
+  *         at TIME_STEP). Direct summation shows the drift of the integrator alone.
+  */
+static void BenchmarkMixedPrecision()
+{
+    LOG_INFO("Mixed precision grouped walk (%zu particles, Morton order, float kernel width %zu)", benchmarkParticles, FORCE_SIMD_WIDTH_MIXED);
+    LOG_INFO("%10s %8s %14s %14s %9s %14s", "scene", "theta", "double(ms)", "mixed(ms)", "speedup", "max rel diff");
+
+    const char*  sceneNames[] = { "uniform", "clustered" };
+    const double thetas[]     = { 0.5, THETA };
+
+    ParticleData            particles;
+    QuadtreeNodePool        pool;
+    DirectSolver            direct;
+    std::vector<glm::dvec2> reference;
+
+    for (int scene = 0; scene < 2; ++scene)
+    {
+        if (scene == 0) FillUniform(particles, benchmarkParticles, 1234);
+        else            FillClustered(particles, benchmarkParticles, 1234);
+
+        ComputeMortonOrder(particles, pool, 0.0, 0.0, 1.001);
+        particles.Reorder(pool.sortedIndices);
+
+        pool.Reset();
+        QuadtreeNode* root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001);
+        root->ComputeMassDistribution(particles);
+
+        for (double theta : thetas)
+        {
+            double bestDouble = 1e30;
+            double bestMixed  = 1e30;
+
+            for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+            {
+                BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+                ComputeAccelerationsGrouped(particles, root, theta, pool, MultipoleOrder::Monopole, nullptr, ForcePrecision::Double);
+                BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+                bestDouble = std::min(bestDouble, std::chrono::duration<double, std::milli>(t1 - t0).count());
+            }
+            reference = particles.accelerations;
+
+            for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+            {
+                BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+                ComputeAccelerationsGrouped(particles, root, theta, pool, MultipoleOrder::Monopole, nullptr, ForcePrecision::Mixed);
+                BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+                bestMixed = std::min(bestMixed, std::chrono::duration<double, std::milli>(t1 - t0).count());
+            }
+
+            double maxDiff = 0.0;
+            for (size_t i = 0; i < particles.Size(); ++i)
+            {
+                maxDiff = std::max(maxDiff, glm::length(particles.accelerations[i] - reference[i]) / glm::length(reference[i]));
+            }
+
+            LOG_INFO("%10s %8.2f %14.3f %14.3f %8.2fx %14.3e", sceneNames[scene], theta, bestDouble, bestMixed, bestDouble / bestMixed, maxDiff);
+        }
+    }
+
+    const size_t steps          = 1000;
+    const size_t driftParticles = NUM_TEMPLATE_PARTICLES;
+    const char*  driftScenes[]  = { "square", "disk", "clustered" };
+    const char*  solverNames[]  = { "direct", "double", "mixed" };
+
+    LOG_INFO("Energy drift over %zu steps (%zu particles from rest, theta %.2f)", steps, driftParticles, THETA);
+    LOG_INFO("%10s %8s %14s %14s %14s", "scene", "forces", "step(ms)", "final drift", "max drift");
+
+    for (int scene = 0; scene < 3; ++scene)
+    {
+        for (int solver = 0; solver < 3; ++solver)
+        {
+            if (scene == 0)      FillUniform(particles, driftParticles, 1234);
+            else if (scene == 1) FillDisk(particles, driftParticles, 1234);
+            else                 FillClustered(particles, driftParticles, 1234);
+
+            double stepMs     = 0.0;
+            double finalDrift = 0.0;
+            double maxDrift   = EnergyDrift(particles, solver, steps, pool, direct, &stepMs, &finalDrift);
+
+            LOG_INFO("%10s %8s %14.3f %14.3e %14.3e", driftScenes[scene], solverNames[solver], stepMs, finalDrift, maxDrift);
+        }
+    }
+}
+
+
+/**
+  * @brief  Hierarchical block timesteps vs shared steps on a scene with a wide range of timescales
+  * @param  None
+  * @retval None
+  * @note   Clustered template-sized scene from rest with one heavy body (1e11 kg) in the
+  *         middle, integrated without walls or collisions. The block run is compared with a
+  *         shared TIME_STEP and with a shared step at the finest level the block run used.
+  */
+static void BenchmarkBlockTimeStep()
+{
+    const size_t frames    = 200;
+    const size_t count     = NUM_TEMPLATE_PARTICLES;
+    const double heavyMass = 1e11;
+
+    LOG_INFO("Block timesteps over %zu frames (%zu clustered particles + one %.0e kg body, grouped walk, theta %.2f)", frames, count, heavyMass, THETA);
+    LOG_INFO("%16s %14s %14s %14s", "stepping", "forces/frame", "frame(ms)", "energy drift");
+
+    ParticleData     particles;
+    QuadtreeNodePool pool;
+
+    size_t evaluations  = 0;
+    double frameMs      = 0.0;
+    int    deepestLevel = 0;
+    double drift        = 0.0;
+
+    FillClustered(particles, count, 1234);
+    particles.AddParticle(heavyMass, glm::dvec2(0.0), glm::dvec2(0.0));
+    drift = BlockStepDrift(particles, 1, frames, pool, &evaluations, &frameMs, &deepestLevel);
+    LOG_INFO("%16s %14zu %14.3f %14.3e", "shared dt", evaluations / frames, frameMs, drift);
+
+    FillClustered(particles, count, 1234);
+    particles.AddParticle(heavyMass, glm::dvec2(0.0), glm::dvec2(0.0));
+    drift = BlockStepDrift(particles, 0, frames, pool, &evaluations, &frameMs, &deepestLevel);
+    LOG_INFO("%16s %14zu %14.3f %14.3e", "block", evaluations / frames, frameMs, drift);
+
+    int finest = 1 << deepestLevel;
+    char label[32];
+    snprintf(label, sizeof(label), "shared dt / %d", finest);
+
+    FillClustered(particles, count, 1234);
+    particles.AddParticle(heavyMass, glm::dvec2(0.0), glm::dvec2(0.0));
+    drift = BlockStepDrift(particles, finest, frames, pool, &evaluations, &frameMs, &deepestLevel);
+    LOG_INFO("%16s %14zu %14.3f %14.3e", label, evaluations / frames, frameMs, drift);
+}
+
+
+/**
+  * @brief  Integrate a scene with shared or block timesteps and measure the energy drift
+  * @param  particles    Scene to integrate (modified)
+  * @param  substeps     Shared steps of TIME_STEP / substeps per frame, or 0 for block timesteps
+  * @param  frames       Number of frames of TIME_STEP
+  * @param  pool         Node pool for the grouped walk
+  * @param  evaluations  Out: particle force evaluations over all frames
+  * @param  frameMs      Out: average time per frame (tree builds, forces and integration)
+  * @param  deepestLevel Out: finest block level used (0 for shared steps)
+  * @retval double       |E - E0| / |E0| after the last frame
+  */
+static double BlockStepDrift(ParticleData& particles, int substeps, size_t frames, QuadtreeNodePool& pool, size_t* evaluations, double* frameMs, int* deepestLevel)
+{
+    size_t numParticles = particles.Size();
+    double initialEnergy = ComputeTotalEnergy(particles);
+    BlockTimeStepper stepper;
+
+    *evaluations  = 0;
+    *deepestLevel = 0;
+
+    // Particles are not kept in the viewport here, so the root has to grow with them
+    auto buildTree = [&]()
+    {
+        double halfSize = 1.0;
+        for (size_t i = 0; i < numParticles; ++i)
+        {
+            halfSize = std::max(halfSize, std::max(std::abs(particles.positions[i].x), std::abs(particles.positions[i].y)));
+        }
+
+        pool.Reset();
+        QuadtreeNode* root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001 * halfSize);
+        root->ComputeMassDistribution(particles);
+        return root;
+    };
+
+    BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+
+    for (size_t frame = 0; frame < frames; ++frame)
+    {
+        if (substeps > 0)
+        {
+            double dt = TIME_STEP / (double)substeps;
+
+            for (int step = 0; step < substeps; ++step)
+            {
+                ComputeAccelerationsGrouped(particles, buildTree(), THETA, pool);
+                *evaluations += numParticles;
+
+                for (size_t i = 0; i < numParticles; ++i)
+                {
+                    particles.velocities[i] += particles.accelerations[i] * dt;
+                    particles.positions[i]  += particles.velocities[i] * dt;
+                }
+            }
+            continue;
+        }
+
+        stepper.BeginFrame(particles, TIME_STEP);
+
+        while (!stepper.IsFrameDone())
+        {
+            QuadtreeNode* root = buildTree();
+            bool isFull = (stepper.CollectActive(particles) == numParticles);
+
+            ComputeAccelerationsGrouped(particles, root, THETA, pool, MultipoleOrder::Monopole, nullptr, ForcePrecision::Double,
+                                        isFull ? nullptr : stepper.GetActiveMask());
+            stepper.Kick(particles);
+            stepper.Drift(particles);
+        }
+
+        *evaluations += stepper.GetForceEvaluations();
+        *deepestLevel = std::max(*deepestLevel, stepper.GetDeepestLevel());
+    }
+
+    BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+    *frameMs = std::chrono::duration<double, std::milli>(t1 - t0).count() / (double)frames;
+
+    return std::abs(ComputeTotalEnergy(particles) - initialEnergy) / std::abs(initialEnergy);
+}
+
+
+/**
+  * @brief  Symplectic Euler vs leapfrog vs Yoshida on bound orbits at growing time steps
+  * @param  None
+  * @retval None
+  * @note   Direct summation, so only the integrator contributes error. The position error
+  *         is the largest distance from a Yoshida run at TIME_STEP / 4, relative to the
+  *         body's distance from the origin.
+  */
+static void BenchmarkIntegrators()
+{
+    const double duration     = 5.0;
+    const double multiples[]  = { 1.0, 2.0, 5.0, 10.0 };
+    const char*  names[]      = { "euler", "leapfrog", "yoshida4" };
+
+    ParticleData particles;
+    ParticleData reference;
+    DirectSolver direct;
+    size_t       evaluations  = 0;
+    double       angularDrift = 0.0;
+
+    FillOrbits(reference);
+    IntegrateOrbits(reference, Integrator::Yoshida4, 0.25 * TIME_STEP, (size_t)std::llround(duration / (0.25 * TIME_STEP)), direct, &evaluations, &angularDrift);
+
+    LOG_INFO("Integrators on bound orbits (central body + 5 orbiters, %.1f s, direct summation)", duration);
+    LOG_INFO("%10s %10s %10s %14s %14s %14s", "scheme", "dt", "forces", "max dE/E", "dL/L", "pos error");
+
+    for (int scheme = 0; scheme < 3; ++scheme)
+    {
+        for (double multiple : multiples)
+        {
+            double dt = multiple * TIME_STEP;
+            size_t steps = (size_t)std::llround(duration / dt);
+
+            FillOrbits(particles);
+            double energyDrift = IntegrateOrbits(particles, static_cast<Integrator>(scheme), dt, steps, direct, &evaluations, &angularDrift);
+
+            double positionError = 0.0;
+            for (size_t i = 1; i < particles.Size(); ++i)
+            {
+                positionError = std::max(positionError, glm::length(particles.positions[i] - reference.positions[i]) / glm::length(reference.positions[i]));
+            }
+
+            LOG_INFO("%10s %10.0e %10zu %14.3e %14.3e %14.3e", names[scheme], dt, evaluations, energyDrift, angularDrift, positionError);
+        }
+    }
+}
+
+
+/**
+  * @brief  Fill particle data with a heavy central body and five light bodies on bound orbits
+  * @param  particles
+  * @retval None
+  * @note   Four orbits are circular for the softened force law; the fifth starts at 0.7 of the
+  *         circular speed (eccentric, periapsis near 0.16). The innermost period is ~0.22 s.
+  */
+static void FillOrbits(ParticleData& particles)
+{
+    const double centralMass = 1e11;
+    const double gm = GRAVITATIONAL_CONSTANT * centralMass;
+    const double radii[] = { 0.2, 0.35, 0.5, 0.75, 0.5 };
+    const double speeds[] = { 1.0, 1.0, 1.0, 1.0, 0.7 };
+
+    particles.Clear();
+    particles.AddParticle(centralMass, glm::dvec2(0.0), glm::dvec2(0.0));
+
+    for (int k = 0; k < 5; ++k)
+    {
+        double r = radii[k];
+        double circular = std::sqrt(gm * r / (r * r + SOFTENING * SOFTENING));
+        double angle = 1.3 * k;
+        glm::dvec2 direction(std::cos(angle), std::sin(angle));
+
+        particles.AddParticle(1e3, r * direction, speeds[k] * circular * glm::dvec2(-direction.y, direction.x));
+    }
+}
+
+
+/**
+  * @brief  Integrate a scene with direct-summation forces and the given integrator
+  * @param  particles    Scene to integrate (modified)
+  * @param  integrator   Scheme, stepped the same way as Simulation
+  * @param  dt           Step length
+  * @param  steps        Number of steps
+  * @param  direct       Force solver
+  * @param  evaluations  Out: force evaluations (whole scene)
+  * @param  angularDrift Out: |L - L0| / |L0| after the last step
+  * @retval double       Largest |E - E0| / |E0| seen (checked every step)
+  */
+static double IntegrateOrbits(ParticleData& particles, Integrator integrator, double dt, size_t steps, DirectSolver& direct, size_t* evaluations, double* angularDrift)
+{
+    const double leapfrogWeights[] = { 1.0 };
+    const double yoshidaWeights[]  = { YOSHIDA_W1, YOSHIDA_W0, YOSHIDA_W1 };
+    bool isYoshida = (integrator == Integrator::Yoshida4);
+    const double* weights = isYoshida ? yoshidaWeights : leapfrogWeights;
+    int numWeights = isYoshida ? 3 : 1;
+
+    size_t numParticles = particles.Size();
+    double initialEnergy = ComputeTotalEnergy(particles);
+    double initialAngularMomentum = ComputeTotalAngularMomentum(particles);
+    double maxDrift = 0.0;
+
+    direct.ComputeAccelerations(particles);
+    *evaluations = 1;
+
+    for (size_t step = 0; step < steps; ++step)
+    {
+        if (integrator == Integrator::SymplecticEuler)
+        {
+            if (step > 0)
+            {
+                direct.ComputeAccelerations(particles);
+                ++*evaluations;
+            }
+
+            ScaledAddSimd(particles.velocities.data(), particles.accelerations.data(), dt, numParticles);
+            ScaledAddSimd(particles.positions.data(), particles.velocities.data(), dt, numParticles);
+        }
+        else
+        {
+            double kick = 0.5 * weights[0] * dt;
+
+            for (int k = 0; k < numWeights; ++k)
+            {
+                ScaledAddSimd(particles.velocities.data(), particles.accelerations.data(), kick, numParticles);
+                ScaledAddSimd(particles.positions.data(), particles.velocities.data(), weights[k] * dt, numParticles);
+                direct.ComputeAccelerations(particles);
+                ++*evaluations;
+
+                kick = 0.5 * (weights[k] + ((k + 1 < numWeights) ? weights[k + 1] : 0.0)) * dt;
+            }
+
+            ScaledAddSimd(particles.velocities.data(), particles.accelerations.data(), kick, numParticles);
+        }
+
+        maxDrift = std::max(maxDrift, std::abs(ComputeTotalEnergy(particles) - initialEnergy) / std::abs(initialEnergy));
+    }
+
+    *angularDrift = std::abs(ComputeTotalAngularMomentum(particles) - initialAngularMomentum) / std::abs(initialAngularMomentum);
+    return maxDrift;
+}
+
+
+/**
+  * @brief  Collision candidates from quadtree range queries vs the uniform cell list
+  * @param  None
+  * @retval None
+  * @note   The tree is built for gravity anyway, so its build is not timed; the grid's
+  *         build is. Both sides count contacts (pairs closer than 2 * PARTICLE_RADIUS) to
+  *         check that the grid finds the same ones.
+  */
+static void BenchmarkCollisionBroadphase()
+{
+    LOG_INFO("Collision broadphase (Morton order, candidates and contacts for every particle)");
+    LOG_INFO("%10s %10s %12s %12s %12s %9s %12s %12s %10s", "scene", "particles", "tree(ms)", "build(ms)", "grid(ms)", "speedup", "tree cand", "grid cand", "contacts");
+
+    const char*  sceneNames[] = { "uniform", "disk" };
+    const size_t counts[]     = { 10'000, 50'000, 200'000 };
+
+    ParticleData        particles;
+    QuadtreeNodePool    pool;
+    CollisionGrid       grid;
+    std::vector<size_t> neighbors;
+    neighbors.reserve(1024);
+
+    // Counts candidates and true contacts of every particle
+    auto countContacts = [&](size_t i, size_t& candidates, size_t& contacts)
+    {
+        candidates += neighbors.size();
+        for (size_t j : neighbors)
+        {
+            if (j != i && glm::length(particles.positions[j] - particles.positions[i]) < 2.0 * PARTICLE_RADIUS)
+                contacts++;
+        }
+    };
+
+    for (int scene = 0; scene < 2; ++scene)
+    {
+        for (size_t count : counts)
+        {
+            if (scene == 0) FillUniform(particles, count, 1234);
+            else            FillDisk(particles, count, 1234);
+
+            ComputeMortonOrder(particles, pool, 0.0, 0.0, 1.001);
+            particles.Reorder(pool.sortedIndices);
+
+            pool.Reset();
+            QuadtreeNode* root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001);
+
+            double bestTree  = 1e30;
+            double bestBuild = 1e30;
+            double bestGrid  = 1e30;
+            size_t treeCandidates = 0, treeContacts = 0;
+            size_t gridCandidates = 0, gridContacts = 0;
+
+            for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+            {
+                treeCandidates = 0;
+                treeContacts   = 0;
+
+                BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const glm::dvec2& p = particles.positions[i];
+                    double range = 2.0 * PARTICLE_RADIUS;
+
+                    neighbors.clear();
+                    root->QueryRange(p.x - range, p.y - range, p.x + range, p.y + range, neighbors);
+                    countContacts(i, treeCandidates, treeContacts);
+                }
+                BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+
+                bestTree = std::min(bestTree, std::chrono::duration<double, std::milli>(t1 - t0).count());
+            }
+
+            for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+            {
+                gridCandidates = 0;
+                gridContacts   = 0;
+
+                BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+                grid.Build(particles);
+                BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+                for (size_t i = 0; i < count; ++i)
+                {
+                    neighbors.clear();
+                    grid.QueryNeighbors(particles.positions[i], neighbors);
+                    countContacts(i, gridCandidates, gridContacts);
+                }
+                BENCH_CLOCK_T::time_point t2 = BENCH_CLOCK_T::now();
+
+                bestBuild = std::min(bestBuild, std::chrono::duration<double, std::milli>(t1 - t0).count());
+                bestGrid  = std::min(bestGrid,  std::chrono::duration<double, std::milli>(t2 - t0).count());
+            }
+
+            if (gridContacts != treeContacts)
+            {
+                LOG_WARN("Grid found %zu contacts, tree %zu", gridContacts, treeContacts);
+            }
+
+            LOG_INFO("%10s %10zu %12.3f %12.3f %12.3f %8.2fx %12.1f %12.1f %10zu", sceneNames[scene], count, bestTree, bestBuild, bestGrid, bestTree / bestGrid,
+                     (double)treeCandidates / (double)count, (double)gridCandidates / (double)count, gridContacts / 2);
+        }
+    }
+}
+
+
+/**
+  * @brief  Serial collision loop vs checkerboard-colored parallel blocks on a collapsing disk
+  * @param  None
+  * @retval None
+  * @note   Every step resolves collisions, then drifts. The colored pass runs once with one
+  *         thread and once with all of them, and the two must match bit for bit. Overlap is
+  *         measured after the last step (pairs closer than 2 * PARTICLE_RADIUS).
+  */
+static void BenchmarkParallelCollisions()
+{
+    const size_t counts[]  = { 5'000, 20'000, 80'000 };
+    const int    numSteps  = 20;
+#ifdef _OPENMP
+    int defaultThreads = omp_get_max_threads();
+#else
+    int defaultThreads = 1;
+#endif
+
+    LOG_INFO("Parallel collisions (collapsing disk, %d steps, %d threads available)", numSteps, defaultThreads);
+    LOG_INFO("%10s %10s %12s %12s %9s %10s %10s %10s %10s %12s %12s %6s", "particles", "serial(ms)", "color 1T(ms)", "color(ms)", "speedup",
+             "ovl ser", "ovl col", "depth ser", "depth col", "KE ser", "KE col", "exact");
+
+    ParticleData        particles;
+    ParticleData        initial;
+    CollisionGrid       grid;
+    std::vector<size_t> neighbors;
+    std::vector<glm::dvec2> oneThread;
+    neighbors.reserve(1024);
+
+    // 0 = serial loop over the cell list visiting both sides of every pair, 1 = colored blocks
+    auto runSteps = [&](int mode) -> double
+    {
+        particles = initial;
+        size_t numParticles = particles.Size();
+
+        BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+        for (int step = 0; step < numSteps; ++step)
+        {
+            grid.Build(particles);
+
+            if (mode == 1)
+            {
+                grid.FindContacts(particles);
+                grid.ResolveContactsColored(particles);
+            }
+            else
+            {
+                for (size_t i = 0; i < numParticles; ++i)
+                {
+                    neighbors.clear();
+                    grid.QueryNeighbors(particles.positions[i], neighbors);
+                    for (size_t j : neighbors)
+                    {
+                        if (j != i)
+                            ResolveCollisionPair(particles, i, j);
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < numParticles; ++i)
+            {
+                particles.positions[i] += particles.velocities[i] * TIME_STEP;
+            }
+        }
+        BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+
+        return std::chrono::duration<double, std::milli>(t1 - t0).count() / numSteps;
+    };
+
+    // Overlapping pairs, mean overlap in radii, kinetic energy
+    auto measure = [&](size_t& overlaps, double& meanOverlap, double& kinetic)
+    {
+        overlaps = 0;
+        meanOverlap = 0.0;
+        kinetic = 0.0;
+        grid.Build(particles);
+
+        for (size_t i = 0; i < particles.Size(); ++i)
+        {
+            kinetic += 0.5 * particles.masses[i] * glm::dot(particles.velocities[i], particles.velocities[i]);
+
+            neighbors.clear();
+            grid.QueryNeighbors(particles.positions[i], neighbors);
+            for (size_t j : neighbors)
+            {
+                double distance = glm::length(particles.positions[j] - particles.positions[i]);
+                if (j > i && distance < 2.0 * PARTICLE_RADIUS)
+                {
+                    overlaps++;
+                    meanOverlap += (2.0 * PARTICLE_RADIUS - distance) / PARTICLE_RADIUS;
+                }
+            }
+        }
+
+        meanOverlap /= (double)std::max<size_t>(overlaps, 1);
+    };
+
+    for (size_t count : counts)
+    {
+        // Disk falling in on itself, with some thermal noise
+        FillDisk(initial, count, 1234);
+        std::mt19937 gen(99);
+        std::normal_distribution<> noise(0.0, 0.1);
+        for (size_t i = 0; i < count; ++i)
+        {
+            initial.velocities[i] = -initial.positions[i] + glm::dvec2(noise(gen), noise(gen));
+        }
+
+        double bestSerial = 1e30;
+        double bestOne    = 1e30;
+        double bestAll    = 1e30;
+        size_t serialOverlaps, coloredOverlaps;
+        double serialMean, coloredMean, serialKinetic, coloredKinetic;
+
+        for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+        {
+            bestSerial = std::min(bestSerial, runSteps(0));
+        }
+        measure(serialOverlaps, serialMean, serialKinetic);
+
+#ifdef _OPENMP
+        omp_set_num_threads(1);
+#endif
+        for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+        {
+            bestOne = std::min(bestOne, runSteps(1));
+        }
+        oneThread = particles.positions;
+
+#ifdef _OPENMP
+        omp_set_num_threads(defaultThreads);
+#endif
+        for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+        {
+            bestAll = std::min(bestAll, runSteps(1));
+        }
+        measure(coloredOverlaps, coloredMean, coloredKinetic);
+
+        bool isExact = std::equal(oneThread.begin(), oneThread.end(), particles.positions.begin());
+        if (!isExact)
+        {
+            LOG_WARN("Colored collisions differ between 1 and %d threads", defaultThreads);
+        }
+
+        LOG_INFO("%10zu %10.3f %12.3f %12.3f %8.2fx %10zu %10zu %10.4f %10.4f %12.4e %12.4e %6s", count, bestSerial, bestOne, bestAll, bestSerial / bestAll,
+                 serialOverlaps, coloredOverlaps, serialMean, coloredMean, serialKinetic, coloredKinetic, isExact ? "yes" : "NO");
+    }
+}
+
+
+/**
+  * @brief  One collision pass visiting both sides of every pair vs contacts generated once per pair
+  * @param  None
+  * @retval None
+  * @note   Same collapsing disk as BenchmarkParallelCollisions, grid build included. "unique"
+  *         filters the 3x3 query with j > i into a ContactBuffer (the serial path of Simulation),
+  *         "stencil" is CollisionGrid::FindContacts (half stencil), both resolved serially.
+  *         Exact distances are the glm::length calls of the narrow phase.
+  */
+static void BenchmarkContactPairs()
+{
+    const size_t counts[] = { 5'000, 20'000, 80'000 };
+
+    LOG_INFO("Contact generation (collapsing disk, one collision pass, 1 thread)");
+    LOG_INFO("%10s %12s %12s %12s %9s %9s %14s %14s %10s", "particles", "both(ms)", "unique(ms)", "stencil(ms)", "unique", "stencil",
+             "lengths both", "lengths uniq", "contacts");
+
+#ifdef _OPENMP
+    int defaultThreads = omp_get_max_threads();
+    omp_set_num_threads(1);
+#endif
+
+    ParticleData        particles;
+    ParticleData        initial;
+    CollisionGrid       grid;
+    ContactBuffer       contacts;
+    std::vector<size_t> neighbors;
+    neighbors.reserve(1024);
+
+    for (size_t count : counts)
+    {
+        FillDisk(initial, count, 1234);
+        std::mt19937 gen(99);
+        std::normal_distribution<> noise(0.0, 0.1);
+        for (size_t i = 0; i < count; ++i)
+        {
+            initial.velocities[i] = -initial.positions[i] + glm::dvec2(noise(gen), noise(gen));
+        }
+
+        double best[3] = { 1e30, 1e30, 1e30 };
+        size_t bothLengths = 0;
+        size_t uniqueContacts = 0;
+        size_t stencilContacts = 0;
+
+        for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+        {
+            // Both sides: every candidate pays a glm::length, twice per pair
+            particles = initial;
+            bothLengths = 0;
+            BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+            grid.Build(particles);
+            for (size_t i = 0; i < count; ++i)
+            {
+                neighbors.clear();
+                grid.QueryNeighbors(particles.positions[i], neighbors);
+                for (size_t j : neighbors)
+                {
+                    if (j != i)
+                        ResolveCollisionPair(particles, i, j);
+                }
+                bothLengths += neighbors.size() - 1;
+            }
+            BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+            best[0] = std::min(best[0], std::chrono::duration<double, std::milli>(t1 - t0).count());
+
+            // Unique pairs from the full query, squared-distance test, then a resolve pass
+            particles = initial;
+            t0 = BENCH_CLOCK_T::now();
+            grid.Build(particles);
+            contacts.Clear();
+            for (size_t i = 0; i < count; ++i)
+            {
+                neighbors.clear();
+                grid.QueryNeighbors(particles.positions[i], neighbors);
+                for (size_t j : neighbors)
+                {
+                    glm::dvec2 d = particles.positions[j] - particles.positions[i];
+                    if (j > i && glm::dot(d, d) < 4.0 * PARTICLE_RADIUS * PARTICLE_RADIUS)
+                    {
+                        contacts.first.push_back((uint32_t)i);
+                        contacts.second.push_back((uint32_t)j);
+                    }
+                }
+            }
+            for (size_t c = 0; c < contacts.first.size(); ++c)
+            {
+                ResolveCollisionPair(particles, contacts.first[c], contacts.second[c]);
+            }
+            t1 = BENCH_CLOCK_T::now();
+            best[1] = std::min(best[1], std::chrono::duration<double, std::milli>(t1 - t0).count());
+            uniqueContacts = contacts.first.size();
+
+            // Half stencil over the cells, block by block
+            particles = initial;
+            t0 = BENCH_CLOCK_T::now();
+            grid.Build(particles);
+            stencilContacts = grid.FindContacts(particles);
+            grid.ResolveContactsColored(particles);
+            t1 = BENCH_CLOCK_T::now();
+            best[2] = std::min(best[2], std::chrono::duration<double, std::milli>(t1 - t0).count());
+        }
+
+        if (uniqueContacts != stencilContacts)
+        {
+            LOG_WARN("Half stencil found %zu contacts, full query %zu", stencilContacts, uniqueContacts);
+        }
+
+        LOG_INFO("%10zu %12.3f %12.3f %12.3f %8.2fx %8.2fx %14.1f %14.1f %10zu", count, best[0], best[1], best[2], best[0] / best[1], best[0] / best[2],
+                 (double)bothLengths / (double)count, (double)uniqueContacts / (double)count, stencilContacts);
+    }
+
+#ifdef _OPENMP
+    omp_set_num_threads(defaultThreads);
+#endif
+}
+
+
+/**
+  * @brief  Contacts from a fresh cell search every step vs Verlet lists with a few skins
+  * @param  None
+  * @retval None
+  * @note   Each step finds contacts, resolves them with the colored pass and drifts. Only
+  *         contact finding is timed (grid build and list rebuilds included). A separate run
+  *         checks every step's Verlet contact count against a fresh search. The granular beds
+  *         are hexagonal lattices at 2.02 radii spacing with random velocities; the collapsing
+  *         disk starts heavily overlapped, so separation pushes exceed skin / 2 every step.
+  */
+static void BenchmarkVerletLists()
+{
+    const char*  sceneNames[]  = { "bed calm", "bed shaken", "collapse" };
+    const double noiseLevels[] = { 0.02, 0.2, 0.1 };
+    const size_t counts[]      = { 20'000, 80'000 };
+    const double skins[]      = { 0.0, 0.25 * PARTICLE_RADIUS, 0.5 * PARTICLE_RADIUS, 1.0 * PARTICLE_RADIUS };
+    const int    numSteps     = 50;
+
+    LOG_INFO("Verlet neighbor lists (%d steps, contact finding only)", numSteps);
+    LOG_INFO("%10s %10s %8s %12s %9s %14s %12s %10s %10s", "scene", "particles", "skin/R", "find(ms)", "speedup", "steps/rebuild", "list length",
+             "contacts", "mismatch");
+
+    ParticleData  particles;
+    ParticleData  initial;
+    CollisionGrid grid;
+    CollisionGrid reference;
+
+    // Returns the average contact finding time per step; counts steps whose contacts differ from a fresh search
+    auto runSteps = [&](double skin, bool isChecked, size_t* mismatches) -> double
+    {
+        particles = initial;
+        grid.ResetVerletStatistics();
+        double findMs = 0.0;
+
+        for (int step = 0; step < numSteps; ++step)
+        {
+            BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+            size_t contacts;
+            if (skin > 0.0)
+            {
+                contacts = grid.UpdateVerletContacts(particles, skin);
+            }
+            else
+            {
+                grid.Build(particles);
+                contacts = grid.FindContacts(particles);
+            }
+            BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+            findMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+            if (isChecked)
+            {
+                reference.Build(particles);
+                if (reference.FindContacts(particles) != contacts)
+                    (*mismatches)++;
+            }
+
+            grid.ResolveContactsColored(particles);
+
+            for (size_t i = 0; i < particles.Size(); ++i)
+            {
+                particles.positions[i] += particles.velocities[i] * TIME_STEP;
+            }
+        }
+
+        return findMs / numSteps;
+    };
+
+    for (int scene = 0; scene < 3; ++scene)
+    {
+        for (size_t count : counts)
+        {
+            if (scene == 2)
+            {
+                FillDisk(initial, count, 1234);
+            }
+            else
+            {
+                // Hexagonal rows, as square as the count allows
+                double spacing = 2.02 * PARTICLE_RADIUS;
+                size_t perRow = (size_t)std::ceil(std::sqrt((double)count * 0.866));
+
+                initial.Clear();
+                initial.Reserve(count);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    size_t row = i / perRow;
+                    double x = ((double)(i % perRow) + 0.5 * (double)(row & 1)) * spacing;
+                    double y = (double)row * spacing * 0.866;
+                    initial.AddParticle(1e8, glm::dvec2(x, y), glm::dvec2(0.0));
+                }
+            }
+
+            std::mt19937 gen(99);
+            std::normal_distribution<> noise(0.0, noiseLevels[scene]);
+            for (size_t i = 0; i < count; ++i)
+            {
+                glm::dvec2 inward = (scene == 2) ? -initial.positions[i] : glm::dvec2(0.0);
+                initial.velocities[i] = inward + glm::dvec2(noise(gen), noise(gen));
+            }
+
+            double baseline = 0.0;
+
+            for (double skin : skins)
+            {
+                double best = 1e30;
+                for (int run = 0; run < BENCHMARK_REPETITIONS; ++run)
+                {
+                    best = std::min(best, runSteps(skin, false, nullptr));
+                }
+
+                double stepsPerRebuild = (skin > 0.0) ? (double)grid.GetVerletStepCount() / (double)std::max<size_t>(grid.GetVerletRebuildCount(), 1) : 1.0;
+                double listLength = (skin > 0.0) ? 2.0 * (double)grid.GetCandidateCount() / (double)count : 0.0;
+                size_t contacts = grid.GetContactCount();
+
+                size_t mismatches = 0;
+                runSteps(skin, true, &mismatches);
+
+                if (skin == 0.0)
+                    baseline = best;
+
+                LOG_INFO("%10s %10zu %8.2f %12.3f %8.2fx %14.1f %12.1f %10zu %10zu", sceneNames[scene], count, skin / PARTICLE_RADIUS, best, baseline / best,
+                         stepsPerRebuild, listLength, contacts, mismatches);
+            }
+        }
+    }
+}
+
+
+/**
+  * @brief  Projectiles fired at a wall at growing timesteps, with and without swept collisions
+  * @param  None
+  * @retval None
+  * @note   The wall is 1 or 2 hexagonal rows (2.02 radii spacing) of particles 10^6 times
+  *         heavier than the projectiles, which arrive at 11 units/s (2 radii per step at
+  *         TIME_STEP). The end columns are left out, since they only graze the wall. A
+  *         projectile should bounce back; one found behind the wall went through it. Each
+  *         step resolves contacts (cell list, colored pass), drifts, then sweeps.
+  */
+static void BenchmarkSweptCollisions()
+{
+    const size_t bedColumns    = 300;
+    const size_t bedRowCounts[] = { 1, 2 };
+    const double speed         = 11.0;
+    const double duration      = 0.06;
+    const int    multipliers[] = { 1, 2, 4, 8 };
+
+    LOG_INFO("Swept collisions (%zu projectiles at a wall, %.2f s, 1 thread)", bedColumns - 2, duration);
+    LOG_INFO("%9s %8s %10s %8s %10s %10s %12s %12s %12s", "wall rows", "dt", "mode", "steps", "bounced", "tunneled", "fast/step", "impacts", "step(ms)");
+
+#ifdef _OPENMP
+    int defaultThreads = omp_get_max_threads();
+    omp_set_num_threads(1);
+#endif
+
+    ParticleData         particles;
+    ParticleData         initial;
+    CollisionGrid        grid;
+    SweptCollisionSolver swept;
+
+    for (size_t bedRows : bedRowCounts)
+    {
+        double spacing = 2.02 * PARTICLE_RADIUS;
+        double wallTop = (double)(bedRows - 1) * spacing * 0.866;
+
+        initial.Clear();
+        initial.Reserve(bedColumns * (bedRows + 1));
+        for (size_t row = 0; row < bedRows; ++row)
+        {
+            for (size_t column = 0; column < bedColumns; ++column)
+            {
+                double x = ((double)column + 0.5 * (double)(row & 1)) * spacing;
+                initial.AddParticle(1e14, glm::dvec2(x, (double)row * spacing * 0.866), glm::dvec2(0.0));
+            }
+        }
+
+        size_t firstProjectile = initial.Size();
+        for (size_t column = 1; column + 1 < bedColumns; ++column)
+        {
+            double x = ((double)column + 0.25) * spacing;
+            initial.AddParticle(1e8, glm::dvec2(x, wallTop + 0.05), glm::dvec2(0.0, -speed));
+        }
+
+        for (int multiplier : multipliers)
+        {
+            double dt = TIME_STEP * multiplier;
+            int numSteps = (int)std::lround(duration / dt);
+
+            for (int mode = 0; mode < 2; ++mode)
+            {
+                particles = initial;
+                size_t fastTotal = 0;
+                size_t impacts = 0;
+
+                BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+                for (int step = 0; step < numSteps; ++step)
+                {
+                    grid.Build(particles);
+                    grid.FindContacts(particles);
+                    grid.ResolveContactsColored(particles);
+
+                    for (size_t i = 0; i < particles.Size(); ++i)
+                    {
+                        particles.positions[i] += particles.velocities[i] * dt;
+                    }
+
+                    if (mode == 1)
+                    {
+                        impacts += swept.Resolve(particles, dt, SWEPT_SPEED_THRESHOLD);
+                        fastTotal += swept.GetFastCount();
+                    }
+                }
+                BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+
+                // Projectiles behind the wall went through it
+                size_t bounced  = 0;
+                size_t tunneled = 0;
+                for (size_t i = firstProjectile; i < particles.Size(); ++i)
+                {
+                    if (particles.positions[i].y < -PARTICLE_RADIUS)
+                        tunneled++;
+                    else if (particles.velocities[i].y > 0.0)
+                        bounced++;
+                }
+
+                LOG_INFO("%9zu %7dx %10s %8d %10zu %10zu %12.1f %12zu %12.3f", bedRows, multiplier, (mode == 1) ? "swept" : "discrete", numSteps, bounced, tunneled,
+                         (double)fastTotal / (double)numSteps, impacts, std::chrono::duration<double, std::milli>(t1 - t0).count() / numSteps);
+            }
+        }
+    }
+
+#ifdef _OPENMP
+    omp_set_num_threads(defaultThreads);
+#endif
+}
+
+
+/**
+  * @brief  Cold collapse of a disk with and without merge mode
+  * @param  None
+  * @retval None
+  * @note   The disk of FillDisk is scaled to radius 1 and starts at rest. Every frame builds the
+  *         tree, takes grouped forces, merges (when on), resolves contacts (cell list, colored
+  *         pass) and steps with symplectic Euler. Frame times are averaged over the first and
+  *         last 50 frames. Mass and momentum errors are the largest relative change across a
+  *         single merge pass.
+  */
+static void BenchmarkAccretion()
+{
+    const size_t counts[]  = { 5'000, 20'000 };
+    const int    numFrames = 250;
+    const int    window    = 50;
+
+    LOG_INFO("Accretion (cold collapse of a unit disk, %d frames, merge at mass ratio %.0f or below %.2f units/s)", numFrames, MERGE_MASS_RATIO, MERGE_RELATIVE_SPEED);
+    LOG_INFO("%10s %8s %10s %10s %12s %12s %12s %12s %12s", "particles", "merge", "final N", "merged", "first(ms)", "last(ms)", "total(s)", "mass err", "mom err");
+
+    ParticleData     particles;
+    ParticleData     initial;
+    QuadtreeNodePool pool;
+    CollisionGrid    grid;
+    AccretionSolver  accretion;
+
+    for (size_t count : counts)
+    {
+        FillDisk(initial, count, 42);
+        for (size_t i = 0; i < initial.Size(); ++i)
+        {
+            initial.positions[i] *= 2.0;
+        }
+
+        for (int mode = 0; mode < 2; ++mode)
+        {
+            particles = initial;
+            size_t merged = 0;
+            double massError = 0.0;
+            double momentumError = 0.0;
+            double firstMs = 0.0;
+            double lastMs = 0.0;
+
+            BENCH_CLOCK_T::time_point start = BENCH_CLOCK_T::now();
+            for (int frame = 0; frame < numFrames; ++frame)
+            {
+                BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+
+                if (mode == 1)
+                {
+                    double massBefore = 0.0;
+                    glm::dvec2 momentumBefore(0.0);
+                    for (size_t i = 0; i < particles.Size(); ++i)
+                    {
+                        massBefore += particles.masses[i];
+                        momentumBefore += particles.masses[i] * particles.velocities[i];
+                    }
+
+                    merged += accretion.Merge(particles, MERGE_MASS_RATIO, MERGE_RELATIVE_SPEED);
+
+                    double massAfter = 0.0;
+                    glm::dvec2 momentumAfter(0.0);
+                    for (size_t i = 0; i < particles.Size(); ++i)
+                    {
+                        massAfter += particles.masses[i];
+                        momentumAfter += particles.masses[i] * particles.velocities[i];
+                    }
+
+                    // Momentum error relative to the total mass times a typical speed of 1
+                    massError     = std::max(massError, std::abs(massAfter - massBefore) / massBefore);
+                    momentumError = std::max(momentumError, glm::length(momentumAfter - momentumBefore) / massBefore);
+                }
+
+                size_t numParticles = particles.Size();
+                double halfSize = 1.0;
+                for (size_t i = 0; i < numParticles; ++i)
+                {
+                    halfSize = std::max(halfSize, std::max(std::abs(particles.positions[i].x), std::abs(particles.positions[i].y)));
+                }
+
+                pool.Reset();
+                QuadtreeNode* root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001 * halfSize);
+                root->ComputeMassDistribution(particles);
+                ComputeAccelerationsGrouped(particles, root, THETA, pool);
+
+                grid.Build(particles);
+                grid.FindContacts(particles);
+                grid.ResolveContactsColored(particles);
+
+                for (size_t i = 0; i < numParticles; ++i)
+                {
+                    particles.velocities[i] += particles.accelerations[i] * TIME_STEP;
+                    particles.positions[i]  += particles.velocities[i] * TIME_STEP;
+                }
+
+                double ms = std::chrono::duration<double, std::milli>(BENCH_CLOCK_T::now() - t0).count();
+                if (frame < window)
+                    firstMs += ms / window;
+                if (frame >= numFrames - window)
+                    lastMs += ms / window;
+            }
+            double total = std::chrono::duration<double>(BENCH_CLOCK_T::now() - start).count();
+
+            LOG_INFO("%10zu %8s %10zu %10zu %12.2f %12.2f %12.2f %12.1e %12.1e", count, (mode == 1) ? "on" : "off", particles.Size(), merged,
+                     firstMs, lastMs, total, massError, momentumError);
+        }
+    }
+}
+
+
+/**
+  * @brief  Integrate a scene and track the relative change of ComputeTotalEnergy
+  * @param  particles  Scene to integrate (modified)
+  * @param  solver     0 = direct summation, 1 = grouped walk in double, 2 = grouped walk in mixed precision
+  * @param  steps      Number of steps of TIME_STEP
+  * @param  pool       Node pool for the tree solvers
+  * @param  direct     Solver used when solver is 0
+  * @param  stepMs     Out: average force time per step
+  * @param  finalDrift Out: |E - E0| / |E0| after the last step
+  * @retval double     Largest |E - E0| / |E0| seen (checked every 50 steps)
+  */
+static double EnergyDrift(ParticleData& particles, int solver, size_t steps, QuadtreeNodePool& pool, DirectSolver& direct, double* stepMs, double* finalDrift)
+{
+    const size_t checkInterval = 50;
+    size_t numParticles = particles.Size();
+    double initialEnergy = ComputeTotalEnergy(particles);
+    double maxDrift = 0.0;
+    double drift = 0.0;
+    double forceMs = 0.0;
+
+    for (size_t step = 1; step <= steps; ++step)
+    {
+        // Particles are not kept in the viewport here, so the root has to grow with them
+        double halfSize = 1.0;
+        for (size_t i = 0; i < numParticles; ++i)
+        {
+            halfSize = std::max(halfSize, std::max(std::abs(particles.positions[i].x), std::abs(particles.positions[i].y)));
+        }
+
+        BENCH_CLOCK_T::time_point t0 = BENCH_CLOCK_T::now();
+        if (solver == 0)
+        {
+            direct.ComputeAccelerations(particles);
+        }
+        else
+        {
+            pool.Reset();
+            QuadtreeNode* root = BuildQuadtreeMorton(particles, pool, 0.0, 0.0, 1.001 * halfSize);
+            root->ComputeMassDistribution(particles);
+            ComputeAccelerationsGrouped(particles, root, THETA, pool, MultipoleOrder::Monopole, nullptr,
+                                        (solver == 2) ? ForcePrecision::Mixed : ForcePrecision::Double);
+        }
+        BENCH_CLOCK_T::time_point t1 = BENCH_CLOCK_T::now();
+        forceMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+        for (size_t i = 0; i < numParticles; ++i)
+        {
+            particles.velocities[i] += particles.accelerations[i] * TIME_STEP;
+            particles.positions[i]  += particles.velocities[i] * TIME_STEP;
+        }
+
+        if (step % checkInterval == 0 || step == steps)
+        {
+            drift = std::abs(ComputeTotalEnergy(particles) - initialEnergy) / std::abs(initialEnergy);
+            maxDrift = std::max(maxDrift, drift);
+        }
+    }
+
+    *stepMs     = forceMs / (double)steps;
+    *finalDrift = drift;
+    return maxDrift;
+}
+
+
+/**
+  * @brief  Largest relative difference between Barnes-Hut forces from two trees
+  * @param  particles   Reference to particle data (SoA)
+  * @param  reference   Root of the reference tree
+  * @param  candidate   Root of the tree being checked
+  * @param  samples     Number of evenly spaced particles to compare
+  * @retval double
+  */
+static double MaxRelativeForceError(const ParticleData& particles, const QuadtreeNode* reference, const QuadtreeNode* candidate, size_t samples)
+{
+    size_t numParticles = particles.Size();
+    size_t stride = std::max<size_t>(1, numParticles / samples);
+    double maxError = 0.0;
+
+    for (size_t i = 0; i < numParticles; i += stride)
+    {
+        glm::dvec2 expected = ComputeForceBarnesHut(i, particles, reference, THETA);
+        glm::dvec2 actual   = ComputeForceBarnesHut(i, particles, candidate, THETA);
+
+        double magnitude = glm::length(expected);
+        if (magnitude > 0.0)
+        {
+            maxError = std::max(maxError, glm::length(actual - expected) / magnitude);
+        }
+    }
+
+    return maxError;
+}
+
+
+
+/******************************** END OF FILE *********************************/
@@ -0,0 +1,286 @@
+/**
+  ******************************************************************************
+  * @file    BlockTimeStep.cpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   Hierarchical block timesteps: per-particle power-of-two step levels
+  ******************************************************************************
+  * @attention
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "BlockTimeStep.hpp"
+#include "Simulation.hpp"
+
+/* Global variables --------------------------------------------------------- */
+/* Private typedef ---------------------------------------------------------- */
+/* Private define ----------------------------------------------------------- */
+
+#define BLOCK_TICKS (1 << BLOCK_MAX_LEVEL)
+
+/* Private macro ------------------------------------------------------------ */
+
+// Ticks between two steps of a particle on the given level
+#define BLOCK_STRIDE(level) (1 << (BLOCK_MAX_LEVEL - (level)))
+
+/* Private variables -------------------------------------------------------- */
+/* Private function prototypes ---------------------------------------------- */
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Public Functions                                                           */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  BlockTimeStepper constructor
+  * @retval None
+  */
+BlockTimeStepper::BlockTimeStepper()
+{
+    this->tick             = BLOCK_TICKS;
+    this->deepestLevel     = 0;
+    this->timeStep         = 0.0;
+    this->numParticles     = 0;
+    this->forceEvaluations = 0;
+    std::fill(std::begin(this->levelCounts), std::end(this->levelCounts), 0);
+}
+
+
+/**
+  * @brief  Start a frame: rewind to tick 0 and count the particles on each level
+  * @param  particles Reference to particle data (SoA)
+  * @param  timeStep  Frame length, the step of level 0
+  * @retval None
+  * @note   Tick 0 is aligned with every level, so the first substep is a full force evaluation.
+  */
+void BlockTimeStepper::BeginFrame(const ParticleData& particles, double timeStep)
+{
+    this->tick             = 0;
+    this->deepestLevel     = 0;
+    this->timeStep         = timeStep;
+    this->numParticles     = particles.Size();
+    this->forceEvaluations = 0;
+    std::fill(std::begin(this->levelCounts), std::end(this->levelCounts), 0);
+
+    for (size_t i = 0; i < this->numParticles; ++i)
+    {
+        int level = std::min((int)particles.timeLevels[i], BLOCK_MAX_LEVEL);
+        this->levelCounts[level]++;
+        this->deepestLevel = std::max(this->deepestLevel, level);
+    }
+}
+
+
+/**
+  * @brief  Check whether the frame has been fully stepped
+  * @retval bool True once every particle has reached the end of the frame
+  */
+bool BlockTimeStepper::IsFrameDone() const
+{
+    return this->tick >= BLOCK_TICKS;
+}
+
+
+/**
+  * @brief  Collect the particles whose step starts on the current tick
+  * @param  particles Reference to particle data (SoA)
+  * @retval size_t Number of active particles
+  * @note   Call after the tree has been rebuilt, since a reorder permutes the levels with the particles.
+  */
+size_t BlockTimeStepper::CollectActive(const ParticleData& particles)
+{
+    size_t numParticles = particles.Size();
+
+    this->activeParticles.clear();
+    this->activeMask.assign(numParticles, 0);
+
+    for (size_t i = 0; i < numParticles; ++i)
+    {
+        if (this->tick % BLOCK_STRIDE(particles.timeLevels[i]) == 0)
+        {
+            this->activeParticles.push_back((uint32_t)i);
+            this->activeMask[i] = 1;
+        }
+    }
+
+    this->forceEvaluations += this->activeParticles.size();
+
+    return this->activeParticles.size();
+}
+
+
+/**
+  * @brief  Pick each active particle's level from its new acceleration, then kick its velocity
+  * @param  particles Reference to particle data (SoA), accelerations of the active particles are current
+  * @retval None
+  * @note   A particle may always move to a finer level, but only moves to a coarser one where
+  *         the current tick is aligned with that level, so its steps stay synchronized.
+  */
+void BlockTimeStepper::Kick(ParticleData& particles)
+{
+    for (uint32_t i : this->activeParticles)
+    {
+        int level   = particles.timeLevels[i];
+        int desired = ChooseLevel(this->timeStep, particles.accelerations[i], particles.velocities[i]);
+
+        if (desired > level)
+        {
+            level = desired;
+        }
+        else
+        {
+            while (level > desired && this->tick % BLOCK_STRIDE(level - 1) == 0)
+                level--;
+        }
+
+        if (level != particles.timeLevels[i])
+        {
+            this->levelCounts[particles.timeLevels[i]]--;
+            this->levelCounts[level]++;
+            particles.timeLevels[i] = (uint8_t)level;
+            this->deepestLevel = std::max(this->deepestLevel, level);
+        }
+
+        // Same semi-implicit Euler update as the shared step, over this particle's own step
+        double dt = this->timeStep / (double)(1 << level);
+        particles.velocities[i] += particles.accelerations[i] * dt;
+        particles.velocities[i] *= DAMPING_FACTOR;
+    }
+}
+
+
+/**
+  * @brief  Move every particle up to the next tick on which some particle starts a step
+  * @param  particles Reference to particle data (SoA)
+  * @retval double Time advanced
+  */
+double BlockTimeStepper::Drift(ParticleData& particles)
+{
+    int next = BLOCK_TICKS;
+
+    for (int level = 0; level <= BLOCK_MAX_LEVEL; ++level)
+    {
+        if (this->levelCounts[level] == 0)
+            continue;
+
+        int stride = BLOCK_STRIDE(level);
+        next = std::min(next, (this->tick / stride + 1) * stride);
+    }
+
+    double dt = this->timeStep * (double)(next - this->tick) / (double)BLOCK_TICKS;
+    int numParticles = (int)particles.Size();
+
+    #pragma omp parallel for schedule(static) if(numParticles > 10000)
+    for (int i = 0; i < numParticles; ++i)
+    {
+        particles.positions[i] += particles.velocities[i] * dt;
+        particles.ages[i] += dt;
+    }
+
+    this->tick = next;
+
+    return dt;
+}
+
+
+/**
+  * @brief  Coarsest level whose step satisfies the acceleration and velocity criteria
+  * @param  timeStep     Level 0 step
+  * @param  acceleration Particle acceleration
+  * @param  velocity     Particle velocity
+  * @retval int Level in [0, BLOCK_MAX_LEVEL]
+  */
+int BlockTimeStepper::ChooseLevel(double timeStep, const glm::dvec2& acceleration, const glm::dvec2& velocity)
+{
+    double maxStep = timeStep;
+
+    double a = glm::length(acceleration);
+    if (a > 0.0)
+        maxStep = std::min(maxStep, std::sqrt(2.0 * BLOCK_ETA_ACCELERATION * SOFTENING / a));
+
+    double v = glm::length(velocity);
+    if (v > 0.0)
+        maxStep = std::min(maxStep, BLOCK_ETA_VELOCITY * PARTICLE_RADIUS / v);
+
+    int level = 0;
+    while (level < BLOCK_MAX_LEVEL && timeStep / (double)(1 << level) > maxStep)
+        level++;
+
+    return level;
+}
+
+
+/**
+  * @brief  Get the particles whose step starts on the current tick
+  * @retval const std::vector<uint32_t>& Active particle indices
+  */
+const std::vector<uint32_t>& BlockTimeStepper::GetActiveParticles() const
+{
+    return this->activeParticles;
+}
+
+
+/**
+  * @brief  Get the per-particle active flags
+  * @retval const uint8_t* 1 for active particles
+  */
+const uint8_t* BlockTimeStepper::GetActiveMask() const
+{
+    return this->activeMask.data();
+}
+
+
+/**
+  * @brief  Get the number of particle force evaluations in the current (or last) frame
+  * @retval size_t Force evaluations
+  */
+size_t BlockTimeStepper::GetForceEvaluations() const
+{
+    return this->forceEvaluations;
+}
+
+
+/**
+  * @brief  Get the finest level used in the current (or last) frame
+  * @retval int Level
+  */
+int BlockTimeStepper::GetDeepestLevel() const
+{
+    return this->deepestLevel;
+}
+
+
+/**
+  * @brief  Force evaluations a shared step at the finest level would need, per evaluation done
+  * @retval double Saving factor (1 when everyone is on the same level)
+  */
+double BlockTimeStepper::GetSharedStepRatio() const
+{
+    if (this->forceEvaluations == 0)
+        return 1.0;
+
+    return (double)this->numParticles * (double)(1 << this->deepestLevel) / (double)this->forceEvaluations;
+}
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Private Functions                                                          */
+/******************************************************************************/
+/******************************************************************************/
+
+
+
+/******************************** END OF FILE *********************************/
@@ -0,0 +1,582 @@
+/**
+  ******************************************************************************
+  * @file    CollisionGrid.cpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   Uniform-grid cell list for collision candidates
+  ******************************************************************************
+  * @attention
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "CollisionGrid.hpp"
+#include "Simulation.hpp"
+
+/* Global variables --------------------------------------------------------- */
+/* Private typedef ---------------------------------------------------------- */
+/* Private define ----------------------------------------------------------- */
+/* Private macro ------------------------------------------------------------ */
+/* Private variables -------------------------------------------------------- */
+/* Private function prototypes ---------------------------------------------- */
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Public Functions                                                           */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  CollisionGrid constructor
+  * @retval None
+  */
+CollisionGrid::CollisionGrid()
+{
+    this->cellsX          = 0;
+    this->cellsY          = 0;
+    this->cellSize        = 2.0 * PARTICLE_RADIUS;
+    this->inverseCellSize = 1.0 / this->cellSize;
+    this->originX         = 0.0;
+    this->originY         = 0.0;
+    this->blocksX         = 0;
+    this->blocksY         = 0;
+    this->contactCount    = 0;
+    this->candidateCount  = 0;
+    this->isVerletValid   = false;
+    this->verletSkin      = 0.0;
+    this->verletLayout    = 0;
+    this->verletRebuilds  = 0;
+    this->verletSteps     = 0;
+}
+
+
+/**
+  * @brief  Bin every particle into the grid with a counting sort on its cell index
+  * @param  particles Reference to particle data (SoA)
+  * @param  skin      Extra reach beyond contact distance (Verlet lists), 0 for contacts only
+  * @retval None
+  * @note   The grid covers the particles' bounding box. Cells are 2 * PARTICLE_RADIUS + skin
+  *         wide unless that would exceed the cell budget, in which case they widen (the 3x3
+  *         stencil still covers every contact, with more candidates per cell).
+  *         Invalidates the Verlet lists, which are grouped by the blocks of their own build.
+  */
+void CollisionGrid::Build(const ParticleData& particles, double skin)
+{
+    size_t numParticles = particles.Size();
+
+    this->isVerletValid = false;
+
+    if (numParticles == 0)
+    {
+        this->cellsX = 0;
+        this->cellsY = 0;
+        return;
+    }
+
+    glm::dvec2 minP = particles.positions[0];
+    glm::dvec2 maxP = particles.positions[0];
+    for (size_t i = 1; i < numParticles; ++i)
+    {
+        minP = glm::min(minP, particles.positions[i]);
+        maxP = glm::max(maxP, particles.positions[i]);
+    }
+
+    double extent = std::max(maxP.x - minP.x, maxP.y - minP.y);
+    double budget = (double)std::max(COLLISION_GRID_CELL_BUDGET * numParticles, COLLISION_GRID_MIN_CELLS);
+
+    this->cellSize        = std::max(2.0 * PARTICLE_RADIUS + skin, extent / std::sqrt(budget));
+    this->inverseCellSize = 1.0 / this->cellSize;
+    this->originX         = minP.x;
+    this->originY         = minP.y;
+    this->cellsX          = (int)((maxP.x - minP.x) * this->inverseCellSize) + 1;
+    this->cellsY          = (int)((maxP.y - minP.y) * this->inverseCellSize) + 1;
+
+    size_t numCells = (size_t)this->cellsX * (size_t)this->cellsY;
+
+    this->cellStart.assign(numCells + 1, 0);
+    this->cellParticles.resize(numParticles);
+    this->particleCells.resize(numParticles);
+
+    // Histogram, shifted by one so the prefix sum leaves each cell's first slot
+    for (size_t i = 0; i < numParticles; ++i)
+    {
+        uint32_t cell = (uint32_t)(CellY(particles.positions[i].y) * this->cellsX + CellX(particles.positions[i].x));
+        this->particleCells[i] = cell;
+        this->cellStart[cell + 1]++;
+    }
+
+    for (size_t c = 0; c < numCells; ++c)
+    {
+        this->cellStart[c + 1] += this->cellStart[c];
+    }
+
+    // Scatter in index order, so each cell lists its particles in ascending index order
+    for (size_t i = 0; i < numParticles; ++i)
+    {
+        this->cellParticles[this->cellStart[this->particleCells[i]]++] = (uint32_t)i;
+    }
+
+    // The scatter advanced every start to the next cell's start; shift back
+    for (size_t c = numCells; c > 0; --c)
+    {
+        this->cellStart[c] = this->cellStart[c - 1];
+    }
+    this->cellStart[0] = 0;
+}
+
+
+/**
+  * @brief  Append every particle in the 3x3 cells around a position (including itself)
+  * @param  position  Query point, clamped to the grid
+  * @param  neighbors Output, appended to
+  * @retval None
+  */
+void CollisionGrid::QueryNeighbors(const glm::dvec2& position, std::vector<size_t>& neighbors) const
+{
+    if (this->cellsX == 0)
+        return;
+
+    int cx = CellX(position.x);
+    int cy = CellY(position.y);
+    int x0 = std::max(cx - 1, 0);
+    int x1 = std::min(cx + 1, this->cellsX - 1);
+    int y0 = std::max(cy - 1, 0);
+    int y1 = std::min(cy + 1, this->cellsY - 1);
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        // Cells of one row are contiguous, so the three cells are one run of cellParticles
+        uint32_t begin = this->cellStart[y * this->cellsX + x0];
+        uint32_t end   = this->cellStart[y * this->cellsX + x1 + 1];
+
+        for (uint32_t k = begin; k < end; ++k)
+        {
+            neighbors.push_back(this->cellParticles[k]);
+        }
+    }
+}
+
+
+/**
+  * @brief  Append every particle binned in the cells overlapping a rectangle
+  * @param  xMin      Left edge
+  * @param  yMin      Bottom edge
+  * @param  xMax      Right edge
+  * @param  yMax      Top edge
+  * @param  neighbors Output, appended to (a superset of the particles inside)
+  * @retval None
+  */
+void CollisionGrid::QueryRange(double xMin, double yMin, double xMax, double yMax, std::vector<size_t>& neighbors) const
+{
+    if (this->cellsX == 0)
+        return;
+
+    int x0 = CellX(xMin);
+    int x1 = CellX(xMax);
+    int y0 = CellY(yMin);
+    int y1 = CellY(yMax);
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        uint32_t begin = this->cellStart[y * this->cellsX + x0];
+        uint32_t end   = this->cellStart[y * this->cellsX + x1 + 1];
+
+        for (uint32_t k = begin; k < end; ++k)
+        {
+            neighbors.push_back(this->cellParticles[k]);
+        }
+    }
+}
+
+
+/**
+  * @brief  Emit every touching pair once, grouped by parallel block
+  * @param  particles Reference to particle data (SoA), binned by the last Build
+  * @retval size_t Number of contacts
+  */
+size_t CollisionGrid::FindContacts(const ParticleData& particles)
+{
+    this->contactCount = this->FindPairs(particles, 2.0 * PARTICLE_RADIUS, this->rowContacts, this->blockContactEnd);
+
+    return this->contactCount;
+}
+
+
+/**
+  * @brief  Contacts from Verlet lists, rebuilding the lists (and the grid) only when needed
+  * @param  particles Reference to particle data (SoA)
+  * @param  skin      Extra reach of the lists beyond contact distance
+  * @retval size_t Number of contacts
+  * @note   The lists hold every pair closer than 2 * PARTICLE_RADIUS + skin at their build.
+  *         While no particle has moved more than skin / 2 since then, no pair can have
+  *         closed in from outside, so filtering the lists finds every contact. They are
+  *         rebuilt when someone moved further, when the skin changes, or when particles were
+  *         added, removed or reordered. Contacts keep the block grouping of the lists' build,
+  *         which only depends on particle identity, so ResolveContactsColored stays race free.
+  */
+size_t CollisionGrid::UpdateVerletContacts(const ParticleData& particles, double skin)
+{
+    int numParticles = (int)particles.Size();
+    bool isValid = this->isVerletValid && skin == this->verletSkin && particles.layoutVersion == this->verletLayout &&
+                   (size_t)numParticles == this->verletPositions.size();
+
+    if (isValid)
+    {
+        double limit = 0.25 * skin * skin;
+        int moved = 0;
+
+        #pragma omp parallel for schedule(static) reduction(+:moved) if(numParticles > 10000)
+        for (int i = 0; i < numParticles; ++i)
+        {
+            glm::dvec2 d = particles.positions[i] - this->verletPositions[i];
+            if (glm::dot(d, d) > limit)
+                moved++;
+        }
+
+        isValid = (moved == 0);
+    }
+
+    if (!isValid)
+    {
+        this->Build(particles, skin);
+        this->candidateCount = this->FindPairs(particles, 2.0 * PARTICLE_RADIUS + skin, this->rowCandidates, this->blockCandidateEnd);
+        this->verletPositions = particles.positions;
+        this->verletSkin      = skin;
+        this->verletLayout    = particles.layoutVersion;
+        this->isVerletValid   = true;
+        this->verletRebuilds++;
+    }
+
+    this->verletSteps++;
+
+    if ((int)this->rowContacts.size() < this->blocksY)
+        this->rowContacts.resize(this->blocksY);
+    this->blockContactEnd.resize((size_t)this->blocksX * this->blocksY);
+
+    const double contactDistanceSquared = 4.0 * PARTICLE_RADIUS * PARTICLE_RADIUS;
+
+    #pragma omp parallel for schedule(dynamic, 1) if(numParticles > 1000)
+    for (int by = 0; by < this->blocksY; ++by)
+    {
+        const ContactBuffer& candidates = this->rowCandidates[by];
+        ContactBuffer& contacts = this->rowContacts[by];
+        contacts.Clear();
+
+        uint32_t c = 0;
+        for (int bx = 0; bx < this->blocksX; ++bx)
+        {
+            size_t block = (size_t)by * this->blocksX + bx;
+
+            for (; c < this->blockCandidateEnd[block]; ++c)
+            {
+                uint32_t i = candidates.first[c];
+                uint32_t j = candidates.second[c];
+                glm::dvec2 d = particles.positions[j] - particles.positions[i];
+                if (glm::dot(d, d) < contactDistanceSquared)
+                {
+                    contacts.first.push_back(i);
+                    contacts.second.push_back(j);
+                }
+            }
+
+            this->blockContactEnd[block] = (uint32_t)contacts.first.size();
+        }
+    }
+
+    this->contactCount = 0;
+    for (int by = 0; by < this->blocksY; ++by)
+    {
+        this->contactCount += this->rowContacts[by].first.size();
+    }
+
+    return this->contactCount;
+}
+
+
+/**
+  * @brief  Forget the Verlet list counters
+  * @retval None
+  */
+void CollisionGrid::ResetVerletStatistics()
+{
+    this->verletRebuilds = 0;
+    this->verletSteps    = 0;
+}
+
+
+/**
+  * @brief  Resolve the contacts of the last FindContacts one after another, in buffer order
+  * @param  particles Reference to particle data (SoA)
+  * @retval None
+  * @note   Serial counterpart of ResolveContactsColored: rows of blocks bottom to top, each
+  *         row's contacts in the order they were found.
+  */
+void CollisionGrid::ResolveContacts(ParticleData& particles) const
+{
+    for (int by = 0; by < this->blocksY; ++by)
+    {
+        const ContactBuffer& contacts = this->rowContacts[by];
+        size_t count = contacts.first.size();
+
+        for (size_t c = 0; c < count; ++c)
+        {
+            ResolveCollisionPair(particles, contacts.first[c], contacts.second[c]);
+        }
+    }
+}
+
+
+/**
+  * @brief  Resolve the contacts of the last FindContacts in four parallel passes over checkerboard-colored blocks
+  * @param  particles Reference to particle data (SoA)
+  * @retval None
+  * @note   A block's contacts reach at most one cell past it, so blocks of the same color
+  *         touch disjoint particles. Each block resolves its contacts in the order they were
+  *         found, so the result is the same for any thread count.
+  */
+void CollisionGrid::ResolveContactsColored(ParticleData& particles) const
+{
+    bool isParallel = particles.Size() > 1000;
+
+    for (int color = 0; color < 4; ++color)
+    {
+        int firstX = color & 1;
+        int firstY = color >> 1;
+        int countX = (this->blocksX - firstX + 1) / 2;
+        int countY = (this->blocksY - firstY + 1) / 2;
+
+        #pragma omp parallel for schedule(dynamic, 4) if(isParallel)
+        for (int b = 0; b < countX * countY; ++b)
+        {
+            int bx = firstX + 2 * (b % countX);
+            int by = firstY + 2 * (b / countX);
+            size_t block = (size_t)by * this->blocksX + bx;
+            const ContactBuffer& contacts = this->rowContacts[by];
+
+            uint32_t begin = (bx == 0) ? 0 : this->blockContactEnd[block - 1];
+            uint32_t end   = this->blockContactEnd[block];
+
+            for (uint32_t c = begin; c < end; ++c)
+            {
+                ResolveCollisionPair(particles, contacts.first[c], contacts.second[c]);
+            }
+        }
+    }
+}
+
+
+/**
+  * @brief  Get the number of contacts found by the last FindContacts
+  * @retval size_t Contacts (each touching pair once)
+  */
+size_t CollisionGrid::GetContactCount() const
+{
+    return this->contactCount;
+}
+
+
+/**
+  * @brief  Get the number of candidate pairs in the Verlet lists
+  * @retval size_t Pairs closer than 2 * PARTICLE_RADIUS + skin at the last list build
+  */
+size_t CollisionGrid::GetCandidateCount() const
+{
+    return this->candidateCount;
+}
+
+
+/**
+  * @brief  Get the number of Verlet list builds since the statistics were reset
+  * @retval size_t Rebuilds
+  */
+size_t CollisionGrid::GetVerletRebuildCount() const
+{
+    return this->verletRebuilds;
+}
+
+
+/**
+  * @brief  Get the number of UpdateVerletContacts calls since the statistics were reset
+  * @retval size_t Steps
+  */
+size_t CollisionGrid::GetVerletStepCount() const
+{
+    return this->verletSteps;
+}
+
+
+/**
+  * @brief  Get the number of cells of the last build
+  * @retval size_t
+  */
+size_t CollisionGrid::GetCellCount() const
+{
+    return (size_t)this->cellsX * (size_t)this->cellsY;
+}
+
+
+/**
+  * @brief  Get the cell width of the last build
+  * @retval double
+  */
+double CollisionGrid::GetCellSize() const
+{
+    return this->cellSize;
+}
+
+
+
+/**
+  * @brief  Empty the buffer, keeping its capacity
+  * @retval None
+  */
+void ContactBuffer::Clear()
+{
+    this->first.clear();
+    this->second.clear();
+}
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Private Functions                                                          */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  Emit every pair closer than a distance once, grouped by parallel block
+  * @param  particles Reference to particle data (SoA), binned by the last Build
+  * @param  distance  Pair distance (at most the cell size)
+  * @param  rows      Output pairs, one buffer per row of blocks
+  * @param  blockEnd  Output end of each block's pairs in its row's buffer
+  * @retval size_t Number of pairs
+  * @note   A pair belongs to the cell of its first particle and is found from there with a
+  *         half stencil: later particles of the same cell, the next cell of the row and the
+  *         three cells above. Blocks are filled one row of blocks at a time (rows in parallel),
+  *         cells row by row inside a block, so the order does not depend on the thread count.
+  */
+size_t CollisionGrid::FindPairs(const ParticleData& particles, double distance, std::vector<ContactBuffer>& rows, std::vector<uint32_t>& blockEnd)
+{
+    this->blocksX = (this->cellsX + COLLISION_BLOCK_CELLS - 1) / COLLISION_BLOCK_CELLS;
+    this->blocksY = (this->cellsY + COLLISION_BLOCK_CELLS - 1) / COLLISION_BLOCK_CELLS;
+
+    if ((int)rows.size() < this->blocksY)
+        rows.resize(this->blocksY);
+    blockEnd.resize((size_t)this->blocksX * this->blocksY);
+
+    const double distanceSquared = distance * distance;
+
+    #pragma omp parallel for schedule(dynamic, 1) if(particles.Size() > 1000)
+    for (int by = 0; by < this->blocksY; ++by)
+    {
+        ContactBuffer& contacts = rows[by];
+        contacts.Clear();
+
+        int cellY1 = std::min((by + 1) * COLLISION_BLOCK_CELLS, this->cellsY);
+
+        for (int bx = 0; bx < this->blocksX; ++bx)
+        {
+            int cellX1 = std::min((bx + 1) * COLLISION_BLOCK_CELLS, this->cellsX);
+
+            for (int cy = by * COLLISION_BLOCK_CELLS; cy < cellY1; ++cy)
+            {
+                for (int cx = bx * COLLISION_BLOCK_CELLS; cx < cellX1; ++cx)
+                {
+                    int cell = cy * this->cellsX + cx;
+                    uint32_t cellEnd = this->cellStart[cell + 1];
+
+                    // Rest of this cell and the next one in the row are contiguous
+                    uint32_t rowEnd = this->cellStart[cell + ((cx + 1 < this->cellsX) ? 2 : 1)];
+
+                    // Three cells of the row above
+                    uint32_t aboveBegin = 0;
+                    uint32_t aboveEnd   = 0;
+                    if (cy + 1 < this->cellsY)
+                    {
+                        aboveBegin = this->cellStart[(cy + 1) * this->cellsX + std::max(cx - 1, 0)];
+                        aboveEnd   = this->cellStart[(cy + 1) * this->cellsX + std::min(cx + 1, this->cellsX - 1) + 1];
+                    }
+
+                    for (uint32_t k = this->cellStart[cell]; k < cellEnd; ++k)
+                    {
+                        uint32_t i = this->cellParticles[k];
+                        const glm::dvec2 posI = particles.positions[i];
+
+                        for (uint32_t m = k + 1; m < rowEnd; ++m)
+                        {
+                            uint32_t j = this->cellParticles[m];
+                            glm::dvec2 d = particles.positions[j] - posI;
+                            if (glm::dot(d, d) < distanceSquared)
+                            {
+                                contacts.first.push_back(i);
+                                contacts.second.push_back(j);
+                            }
+                        }
+
+                        for (uint32_t m = aboveBegin; m < aboveEnd; ++m)
+                        {
+                            uint32_t j = this->cellParticles[m];
+                            glm::dvec2 d = particles.positions[j] - posI;
+                            if (glm::dot(d, d) < distanceSquared)
+                            {
+                                contacts.first.push_back(i);
+                                contacts.second.push_back(j);
+                            }
+                        }
+                    }
+                }
+            }
+
+            blockEnd[(size_t)by * this->blocksX + bx] = (uint32_t)contacts.first.size();
+        }
+    }
+
+    size_t count = 0;
+    for (int by = 0; by < this->blocksY; ++by)
+    {
+        count += rows[by].first.size();
+    }
+
+    return count;
+}
+
+
+/**
+  * @brief  Column of an x coordinate, clamped to the grid
+  * @param  x
+  * @retval int
+  */
+int CollisionGrid::CellX(double x) const
+{
+    // Clamp before converting, so far-away query points cannot overflow the int
+    double cx = std::floor((x - this->originX) * this->inverseCellSize);
+    return (int)std::min(std::max(cx, 0.0), (double)(this->cellsX - 1));
+}
+
+
+/**
+  * @brief  Row of a y coordinate, clamped to the grid
+  * @param  y
+  * @retval int
+  */
+int CollisionGrid::CellY(double y) const
+{
+    // Clamp before converting, so far-away query points cannot overflow the int
+    double cy = std::floor((y - this->originY) * this->inverseCellSize);
+    return (int)std::min(std::max(cy, 0.0), (double)(this->cellsY - 1));
+}
+
+
+
+/******************************** END OF FILE *********************************/
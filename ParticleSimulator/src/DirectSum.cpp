@@ -0,0 +1,183 @@
+/**
+  ******************************************************************************
+  * @file    DirectSum.cpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   Exact all-pairs gravity (scalar reference and SIMD solver)
+  ******************************************************************************
+  * @attention
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "DirectSum.hpp"
+#include "Simulation.hpp"
+#include "VectorMath.hpp"
+
+/* Global variables --------------------------------------------------------- */
+/* Private typedef ---------------------------------------------------------- */
+/* Private define ----------------------------------------------------------- */
+/* Private macro ------------------------------------------------------------ */
+/* Private variables -------------------------------------------------------- */
+/* Private function prototypes ---------------------------------------------- */
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Public Functions                                                           */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  Exact O(N) acceleration of one particle (same softening as the tree walks)
+  * @param  particleIndex
+  * @param  particles     Reference to particle data (SoA)
+  * @retval glm::dvec2
+  */
+glm::dvec2 ComputeAccelerationDirect(size_t particleIndex, const ParticleData& particles)
+{
+    glm::dvec2 acceleration(0.0);
+    const glm::dvec2& p = particles.positions[particleIndex];
+
+    for (size_t j = 0; j < particles.Size(); ++j)
+    {
+        if (j == particleIndex)
+            continue;
+
+        glm::dvec2 dir = particles.positions[j] - p;
+        double r2 = glm::dot(dir, dir);
+
+        // Coincident particles have no direction (the tree kernels add nothing for them either)
+        if (r2 == 0.0)
+            continue;
+
+        double dist2 = std::max(r2, MIN_INTERACTION_DISTANCE * MIN_INTERACTION_DISTANCE);
+
+        acceleration += GRAVITATIONAL_CONSTANT * particles.masses[j] / (dist2 + SOFTENING * SOFTENING) * glm::normalize(dir);
+    }
+
+    return acceleration;
+}
+
+
+/**
+  * @brief  Exact O(N^2) total energy: kinetic plus the pair potential of the softened force law
+  * @param  particles Reference to particle data (SoA)
+  * @retval double
+  * @note   The potential integrates F = G m1 m2 / (max(r^2, MIN^2) + SOFTENING^2) from r to
+  *         infinity, so energy is conserved exactly by the forces the solvers approximate.
+  */
+double ComputeTotalEnergy(const ParticleData& particles)
+{
+    const double minDist = MIN_INTERACTION_DISTANCE;
+    const double minDist2 = minDist * minDist;
+    const double soft = SOFTENING;
+    const double halfPi = 0.5 * MATH_PI_CONSTANT;
+    const double potentialAtMin = halfPi - std::atan(minDist / soft);
+
+    int numParticles = (int)particles.Size();
+    double kinetic = 0.0;
+    double potential = 0.0;
+
+    #pragma omp parallel for schedule(dynamic, 16) reduction(+:kinetic, potential) if(numParticles > 256)
+    for (int i = 0; i < numParticles; ++i)
+    {
+        const glm::dvec2& p = particles.positions[i];
+        kinetic += 0.5 * particles.masses[i] * glm::dot(particles.velocities[i], particles.velocities[i]);
+
+        for (int j = i + 1; j < numParticles; ++j)
+        {
+            double gmm = GRAVITATIONAL_CONSTANT * particles.masses[i] * particles.masses[j];
+            double dist = glm::length(particles.positions[j] - p);
+
+            // Constant force inside MIN_INTERACTION_DISTANCE, arctan potential outside
+            if (dist >= minDist)
+                potential -= gmm / soft * (halfPi - std::atan(dist / soft));
+            else
+                potential -= gmm / soft * potentialAtMin + gmm / (minDist2 + soft * soft) * (minDist - dist);
+        }
+    }
+
+    return kinetic + potential;
+}
+
+
+/**
+  * @brief  Total angular momentum about the origin, sum of m (x vy - y vx)
+  * @param  particles Reference to particle data (SoA)
+  * @retval double
+  * @note   Pair forces are central, so only walls and the tree's approximation change it.
+  */
+double ComputeTotalAngularMomentum(const ParticleData& particles)
+{
+    int numParticles = (int)particles.Size();
+    double angularMomentum = 0.0;
+
+    #pragma omp parallel for schedule(static) reduction(+:angularMomentum) if(numParticles > 10000)
+    for (int i = 0; i < numParticles; ++i)
+    {
+        const glm::dvec2& p = particles.positions[i];
+        const glm::dvec2& v = particles.velocities[i];
+        angularMomentum += particles.masses[i] * (p.x * v.y - p.y * v.x);
+    }
+
+    return angularMomentum;
+}
+
+
+/**
+  * @brief  Overwrite every particle's acceleration with the exact all-pairs sum
+  * @param  particles Reference to particle data (SoA)
+  * @param  targets   Optional subset to update (block timesteps); every particle still acts as a source
+  * @retval None
+  */
+void DirectSolver::ComputeAccelerations(ParticleData& particles, const std::vector<uint32_t>* targets)
+{
+    int numParticles = (int)particles.Size();
+
+    this->x.resize(numParticles);
+    this->y.resize(numParticles);
+    this->mass.resize(numParticles);
+
+    for (int i = 0; i < numParticles; ++i)
+    {
+        this->x[i]    = particles.positions[i].x;
+        this->y[i]    = particles.positions[i].y;
+        this->mass[i] = particles.masses[i];
+    }
+
+    if (targets)
+    {
+        for (uint32_t i : *targets)
+        {
+            particles.accelerations[i] = AccumulateAccelerationSimd(this->x[i], this->y[i], this->x.data(), this->y.data(), this->mass.data(), numParticles);
+        }
+        return;
+    }
+
+    #pragma omp parallel for schedule(static) if(numParticles > 256)
+    for (int i = 0; i < numParticles; ++i)
+    {
+        particles.accelerations[i] = AccumulateAccelerationSimd(this->x[i], this->y[i], this->x.data(), this->y.data(), this->mass.data(), numParticles);
+    }
+}
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Private Functions                                                          */
+/******************************************************************************/
+/******************************************************************************/
+
+
+
+/******************************** END OF FILE *********************************/
@@ -17,6 +17,10 @@
 #include "PCH.hpp"
 
 #include "Engine.hpp"
+#include "CollisionGrid.hpp"
+#include "Fmm.hpp"
+#include "TreePm.hpp"
+#include "ForceAudit.hpp"
 #include "Simulation.hpp"
 #include "Particle.hpp"
 #include "ParticleData.hpp"
@@ -57,6 +61,7 @@ static GLuint       VAOText;
 static GLuint       VBOParticleColors;
 static GLuint       VBOParticlePositions;
 static GLuint       VBOText;
+static size_t       particleBufferCapacity;
 static glm::mat4    projectionParticles;
 static glm::mat4    projectionText;
 static SHADERS_T    shaders;
@@ -149,10 +154,6 @@ int Engine::Init()
     InitParticleBuffers(VAOParticles, VBOParticlePositions, VBOParticleColors, this->GetSimulation()->GetMaxParticleCount());
     InitTextBuffers(VAOText, VBOText);
 
-    // Pre-allocate staging buffers for GPU uploads (optimization)
-    stagingPositions.reserve(this->GetSimulation()->GetMaxParticleCount() * 2);
-    stagingColors.reserve(this->GetSimulation()->GetMaxParticleCount() * 3);
-
     glUseProgram(shaderParticle);
 
     glm::mat4 model = glm::mat4(1.0f);
@@ -297,12 +298,12 @@ void Engine::InitParticleBuffers(GLuint& VAO, GLuint& VBO_positions, GLuint& VBO
     glBindVertexArray(VAO);
 
     glGenBuffers(1, &VBO_positions);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_positions);
-    glBufferData(GL_ARRAY_BUFFER, maxParticles * 2 * sizeof(GLfloat), nullptr, GL_DYNAMIC_DRAW);
-
     glGenBuffers(1, &VBO_colors);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_colors);
-    glBufferData(GL_ARRAY_BUFFER, maxParticles * 3 * sizeof(GLfloat), nullptr, GL_DYNAMIC_DRAW);
+
+    if (!ResizeParticleBuffers(maxParticles))
+    {
+        LOG_ERROR("Out of memory allocating GPU buffers for %zu particles", maxParticles);
+    }
 
     glEnableVertexAttribArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, VBO_positions);
@@ -314,6 +315,57 @@ void Engine::InitParticleBuffers(GLuint& VAO, GLuint& VBO_positions, GLuint& VBO
 }
 
 
+/**
+  * @brief  Reallocate the particle VBOs and staging buffers for a new capacity
+  * @param  maxParticles
+  * @retval bool  False if out of memory (the previous capacity is kept)
+  * @note   The buffer objects keep their names, so the VAO's attribute bindings stay valid
+  */
+bool Engine::ResizeParticleBuffers(size_t maxParticles)
+{
+    // Pre-allocate staging buffers for GPU uploads (a failed reserve leaves them as they were)
+    try
+    {
+        stagingPositions.reserve(maxParticles * 2);
+        stagingColors.reserve(maxParticles * 3);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return false;
+    }
+
+    // Drop stale error flags so GL_OUT_OF_MEMORY below comes from these calls
+    while (glGetError() != GL_NO_ERROR) {}
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBOParticlePositions);
+    glBufferData(GL_ARRAY_BUFFER, maxParticles * 2 * sizeof(GLfloat), nullptr, GL_DYNAMIC_DRAW);
+
+    glBindBuffer(GL_ARRAY_BUFFER, VBOParticleColors);
+    glBufferData(GL_ARRAY_BUFFER, maxParticles * 3 * sizeof(GLfloat), nullptr, GL_DYNAMIC_DRAW);
+
+    if (glGetError() == GL_OUT_OF_MEMORY)
+    {
+        // Contents are uploaded every frame, so restoring the old size is enough
+        glBindBuffer(GL_ARRAY_BUFFER, VBOParticlePositions);
+        glBufferData(GL_ARRAY_BUFFER, particleBufferCapacity * 2 * sizeof(GLfloat), nullptr, GL_DYNAMIC_DRAW);
+
+        glBindBuffer(GL_ARRAY_BUFFER, VBOParticleColors);
+        glBufferData(GL_ARRAY_BUFFER, particleBufferCapacity * 3 * sizeof(GLfloat), nullptr, GL_DYNAMIC_DRAW);
+        return false;
+    }
+
+    // Release staging memory when the capacity shrinks
+    if (maxParticles < particleBufferCapacity)
+    {
+        stagingPositions.shrink_to_fit();
+        stagingColors.shrink_to_fit();
+    }
+
+    particleBufferCapacity = maxParticles;
+    return true;
+}
+
+
 /**
   * @brief  Initialize VAO and VBO buffers for rendering text
   * @param  None
@@ -584,7 +636,17 @@ void Engine::Run()
     GLuint shaderParticle = GetShader("particle");
 
     ParticleData particleData;
-    particleData.Reserve(this->GetSimulation()->GetMaxParticleCount());
+    size_t capacity = this->GetSimulation()->GetMaxParticleCount();
+    try
+    {
+        particleData.Reserve(capacity);
+    }
+    catch (const std::bad_alloc&)
+    {
+        LOG_ERROR("Out of memory reserving %zu particles, using the default capacity", capacity);
+        this->GetSimulation()->SetMaxParticleCount(MAX_NUM_PARTICLES);
+        particleData.Reserve(MAX_NUM_PARTICLES);
+    }
     this->GetSimulation()->SetParticleData(&particleData);
     this->GetSimulation()->InitTemplateParticles();
 
@@ -637,7 +699,7 @@ void Engine::Run()
         // Render particles
         glDisable(GL_BLEND);
         glUseProgram(shaderParticle);
-        RenderParticles(VAOParticles, particleData.Size());
+        RenderParticles(VAOParticles, std::min(particleData.Size(), particleBufferCapacity));
 
         // Render text
         if (isShowingUI)
@@ -646,13 +708,103 @@ void Engine::Run()
             glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
             RenderText("Particles:", 10.0f, 10.0f, 20.0f, FONT_T::RobotoBold, glm::vec3(1.0f));
-            sprintf_s(textBuffer, "%lld", this->GetSimulation()->GetParticleCount());
+            sprintf_s(textBuffer, "%zu / %zu", this->GetSimulation()->GetParticleCount(), this->GetSimulation()->GetMaxParticleCount());
             RenderText(textBuffer, 90.0f, 10.0f, 20.0f, FONT_T::RobotoLight, glm::vec3(1.0f));
 
             RenderText("Mass:", 10.0f, 30.0f, 20.0f, FONT_T::RobotoBold, glm::vec3(1.0f));
             sprintf_s(textBuffer, "%.2e kg", this->GetSimulation()->GetTotalMass());
             RenderText(textBuffer, 90.0f, 30.0f, 20.0f, FONT_T::RobotoLight, glm::vec3(1.0f));
 
+            RenderText("Nodes:", 10.0f, 50.0f, 20.0f, FONT_T::RobotoBold, glm::vec3(1.0f));
+            sprintf_s(textBuffer, "%zu (peak %zu, %.1f MB)", this->GetSimulation()->GetTreeNodeCount(), this->GetSimulation()->GetTreeNodeHighWaterMark(),
+                this->GetSimulation()->GetTreeNodeMemory() / (1024.0 * 1024.0));
+            RenderText(textBuffer, 90.0f, 50.0f, 20.0f, FONT_T::RobotoLight, glm::vec3(1.0f));
+
+            if (this->GetSimulation()->IsPersistentTreeEnabled())
+            {
+                RenderText("Tree:", 10.0f, 70.0f, 20.0f, FONT_T::RobotoBold, glm::vec3(1.0f));
+                sprintf_s(textBuffer, "%zu rebuilds / %zu refits", this->GetSimulation()->GetTreeRebuildCount(), this->GetSimulation()->GetTreeRefitCount());
+                RenderText(textBuffer, 90.0f, 70.0f, 20.0f, FONT_T::RobotoLight, glm::vec3(1.0f));
+            }
+
+            float statusY = this->GetSimulation()->IsPersistentTreeEnabled() ? 90.0f : 70.0f;
+
+            if (this->GetSimulation()->IsOpenDomainEnabled())
+            {
+                const char* policyNames[] = { "included", "tracked", "dropped" };
+                RenderText("Domain:", 10.0f, statusY, 20.0f, FONT_T::RobotoBold, glm::vec3(1.0f));
+                sprintf_s(textBuffer, "open, %zu outliers %s", this->GetSimulation()->GetOutlierCount(),
+                    policyNames[static_cast<int>(this->GetSimulation()->GetOutlierPolicy())]);
+                RenderText(textBuffer, 90.0f, statusY, 20.0f, FONT_T::RobotoLight, glm::vec3(1.0f));
+                statusY += 20.0f;
+            }
+
+            if (this->GetSimulation()->GetGravitySolver() != GravitySolver::Fmm || this->GetSimulation()->IsDirectSummationActive())
+            {
+                bool treePm = this->GetSimulation()->GetGravitySolver() == GravitySolver::TreePm;
+                RenderText("Cost:", 10.0f, statusY, 20.0f, FONT_T::RobotoBold, glm::vec3(1.0f));
+                sprintf_s(textBuffer, "%.1f interactions / particle%s", this->GetSimulation()->GetAverageInteractions(),
+                    this->GetSimulation()->IsDirectSummationActive() ? " (direct)" : (treePm ? " (short range)" : ""));
+                RenderText(textBuffer, 90.0f, statusY, 20.0f, FONT_T::RobotoLight, glm::vec3(1.0f));
+                statusY += 20.0f;
+            }
+
+            RenderText("Contacts:", 10.0f, statusY, 20.0f, FONT_T::RobotoBold, glm::vec3(1.0f));
+            if (this->GetSimulation()->GetNeighborListSkin() > 0.0)
+            {
+                sprintf_s(textBuffer, "%zu (Verlet lists: %.1f per particle, rebuilt every %.1f steps)", this->GetSimulation()->GetContactCount(),
+                    this->GetSimulation()->GetNeighborListLength(), this->GetSimulation()->GetNeighborListStepsPerRebuild());
+            }
+            else
+            {
+                sprintf_s(textBuffer, "%zu", this->GetSimulation()->GetContactCount());
+            }
+            RenderText(textBuffer, 90.0f, statusY, 20.0f, FONT_T::RobotoLight, glm::vec3(1.0f));
+            statusY += 20.0f;
+
+            if (this->GetSimulation()->IsSweptCollisionEnabled())
+            {
+                RenderText("Swept:", 10.0f, statusY, 20.0f, FONT_T::RobotoBold, glm::vec3(1.0f));
+                sprintf_s(textBuffer, "%zu fast movers, %zu impacts", this->GetSimulation()->GetSweptParticleCount(), this->GetSimulation()->GetSweptHitCount());
+                RenderText(textBuffer, 90.0f, statusY, 20.0f, FONT_T::RobotoLight, glm::vec3(1.0f));
+                statusY += 20.0f;
+            }
+
+            if (this->GetSimulation()->IsMergeModeEnabled())
+            {
+                RenderText("Merged:", 10.0f, statusY, 20.0f, FONT_T::RobotoBold, glm::vec3(1.0f));
+                sprintf_s(textBuffer, "%zu this frame, %zu total", this->GetSimulation()->GetMergeCount(), this->GetSimulation()->GetTotalMergeCount());
+                RenderText(textBuffer, 90.0f, statusY, 20.0f, FONT_T::RobotoLight, glm::vec3(1.0f));
+                statusY += 20.0f;
+            }
+
+            if (this->GetSimulation()->GetConservationInterval() > 0 && this->GetSimulation()->GetConservationReport().elapsed > 0.0)
+            {
+                const ConservationReport& drift = this->GetSimulation()->GetConservationReport();
+                RenderText("Drift:", 10.0f, statusY, 20.0f, FONT_T::RobotoBold, glm::vec3(1.0f));
+                sprintf_s(textBuffer, "energy %.1e / angular momentum %.1e over %.2f s", drift.energyDrift, drift.angularMomentumDrift, drift.elapsed);
+                RenderText(textBuffer, 90.0f, statusY, 20.0f, FONT_T::RobotoLight, glm::vec3(1.0f));
+                statusY += 20.0f;
+            }
+
+            if (this->GetSimulation()->IsBlockTimeStepEnabled())
+            {
+                RenderText("Steps:", 10.0f, statusY, 20.0f, FONT_T::RobotoBold, glm::vec3(1.0f));
+                sprintf_s(textBuffer, "%zu forces, finest dt / %d (%.1fx fewer than shared)", this->GetSimulation()->GetForceEvaluations(),
+                    1 << this->GetSimulation()->GetDeepestTimeLevel(), this->GetSimulation()->GetBlockStepSaving());
+                RenderText(textBuffer, 90.0f, statusY, 20.0f, FONT_T::RobotoLight, glm::vec3(1.0f));
+                statusY += 20.0f;
+            }
+
+            if (this->GetSimulation()->GetForceAuditInterval() > 0 && this->GetSimulation()->GetForceAuditReport().samples > 0)
+            {
+                const ForceAuditReport& audit = this->GetSimulation()->GetForceAuditReport();
+                RenderText("Error:", 10.0f, statusY, 20.0f, FONT_T::RobotoBold, glm::vec3(1.0f));
+                sprintf_s(textBuffer, "%.1e median / %.1e p99 / %.1e max (direct sum costs %.0fx)",
+                    audit.medianError, audit.p99Error, audit.maxError, audit.costRatio);
+                RenderText(textBuffer, 90.0f, statusY, 20.0f, FONT_T::RobotoLight, glm::vec3(1.0f));
+            }
+
             RenderText("Timestep:", this->GetWindowWidth() - 130.0f, 10, 18.0f, FONT_T::RobotoBold, glm::vec3(1.0f, 1.0, 0.0f));
             sprintf_s(textBuffer, "%.0e s", this->GetSimulation()->GetTimeStep());
             RenderText(textBuffer, this->GetWindowWidth() - 55.0f, 10, 18.0f, FONT_T::RobotoLight, glm::vec3(1.0f, 1.0, 0.0f));
@@ -708,7 +860,16 @@ void Engine::Run()
   */
 void Engine::UpdateParticleBuffers(const ParticleData& particleData)
 {
-    size_t numParticles = particleData.Size();
+    // Follow capacity changes (SetMaxParticleCount never drops below the particle count)
+    size_t capacity = this->GetSimulation()->GetMaxParticleCount();
+    if (capacity != particleBufferCapacity && !ResizeParticleBuffers(capacity))
+    {
+        LOG_ERROR("Out of memory allocating GPU buffers for %zu particles, capacity stays at %zu", capacity, particleBufferCapacity);
+        this->GetSimulation()->SetMaxParticleCount(particleBufferCapacity);
+    }
+
+    // Particles added while the larger capacity was pending are not drawn
+    size_t numParticles = std::min(particleData.Size(), particleBufferCapacity);
 
     // Reuse pre-allocated staging buffers instead of allocating new ones
     stagingPositions.resize(numParticles * 2);
@@ -982,6 +1143,288 @@ void Engine::KeyboardCallback(GLFWwindow* window, int key, int scancode, int act
 
                 case GLFW_KEY_F1: isShowingUI = !isShowingUI; break;
 
+                // Cycle quadtree build algorithm
+                case GLFW_KEY_B:
+                {
+                    const char* buildModeNames[] = { "Recursive", "Morton", "Morton (parallel)" };
+                    int currentMode = static_cast<int>(e->GetSimulation()->GetTreeBuildMode());
+                    currentMode = (currentMode + 1) % 3; // 3 total modes
+                    e->GetSimulation()->SetTreeBuildMode(static_cast<TreeBuildMode>(currentMode));
+                    LOG_INFO("Quadtree build: %s", buildModeNames[currentMode]);
+                    break;
+                }
+
+                // Toggle persistent quadtree (refit between steps instead of rebuilding)
+                case GLFW_KEY_P:
+                {
+                    bool enabled = !e->GetSimulation()->IsPersistentTreeEnabled();
+                    e->GetSimulation()->SetPersistentTreeEnabled(enabled);
+                    LOG_INFO("Persistent quadtree: %s", enabled ? "on" : "off");
+                    break;
+                }
+
+                // Cycle force walk (per particle recursive / per particle stackless / grouped)
+                case GLFW_KEY_G:
+                {
+                    const char* walkModeNames[] = { "per particle", "stackless", "grouped" };
+                    int currentMode = static_cast<int>(e->GetSimulation()->GetForceWalkMode());
+                    currentMode = (currentMode + 1) % 3; // 3 total modes
+                    e->GetSimulation()->SetForceWalkMode(static_cast<ForceWalkMode>(currentMode));
+                    LOG_INFO("Force walk: %s", walkModeNames[currentMode]);
+                    break;
+                }
+
+                // Cycle Barnes-Hut / FMM / TreePM gravity (Ctrl: cycle FMM expansion order or TreePM mesh size)
+                case GLFW_KEY_M:
+                {
+                    Simulation* simulation = e->GetSimulation();
+                    if (isKeyLeftCtrlPressed && simulation->GetGravitySolver() == GravitySolver::TreePm)
+                    {
+                        int meshSize = simulation->GetTreePmMeshSize() * 2;
+                        simulation->SetTreePmMeshSize(meshSize > TREEPM_MAX_MESH ? TREEPM_MIN_MESH : meshSize);
+                        LOG_INFO("TreePM mesh: %d x %d", simulation->GetTreePmMeshSize(), simulation->GetTreePmMeshSize());
+                    }
+                    else if (isKeyLeftCtrlPressed)
+                    {
+                        simulation->SetFmmOrder(simulation->GetFmmOrder() % FMM_MAX_ORDER + 1);
+                        LOG_INFO("FMM expansion order: %d", simulation->GetFmmOrder());
+                    }
+                    else
+                    {
+                        const char* solverNames[] = { "Barnes-Hut", "FMM", "TreePM" };
+                        int currentSolver = (static_cast<int>(simulation->GetGravitySolver()) + 1) % 3;
+                        simulation->SetGravitySolver(static_cast<GravitySolver>(currentSolver));
+                        LOG_INFO("Gravity: %s", solverNames[currentSolver]);
+                    }
+                    break;
+                }
+
+                // Toggle quadrupole far-field correction
+                case GLFW_KEY_Q:
+                {
+                    bool quadrupole = e->GetSimulation()->GetMultipoleOrder() != MultipoleOrder::Quadrupole;
+                    e->GetSimulation()->SetMultipoleOrder(quadrupole ? MultipoleOrder::Quadrupole : MultipoleOrder::Monopole);
+                    LOG_INFO("Far field: %s", quadrupole ? "quadrupole" : "monopole");
+                    break;
+                }
+
+                // Toggle mixed-precision force kernels
+                case GLFW_KEY_X:
+                {
+                    bool mixed = e->GetSimulation()->GetForcePrecision() != ForcePrecision::Mixed;
+                    e->GetSimulation()->SetForcePrecision(mixed ? ForcePrecision::Mixed : ForcePrecision::Double);
+                    LOG_INFO("Force precision: %s", mixed ? "mixed (float32 terms, double sums)" : "double");
+                    break;
+                }
+
+                // Cycle multipole acceptance criterion
+                case GLFW_KEY_K:
+                {
+                    const char* criterionNames[] = { "geometric", "min distance to box", "Salmon-Warren error bound", "relative force" };
+                    int currentCriterion = static_cast<int>(e->GetSimulation()->GetOpeningCriterion());
+                    currentCriterion = (currentCriterion + 1) % 4; // 4 total criteria
+                    e->GetSimulation()->SetOpeningCriterion(static_cast<OpeningCriterion>(currentCriterion));
+                    LOG_INFO("Opening criterion: %s", criterionNames[currentCriterion]);
+                    break;
+                }
+
+                // Adjust opening angle (Ctrl: error tolerance of the error-based criteria)
+                case GLFW_KEY_MINUS:
+                case GLFW_KEY_EQUAL:
+                {
+                    Simulation* simulation = e->GetSimulation();
+                    bool increase = (key == GLFW_KEY_EQUAL);
+                    if (isKeyLeftCtrlPressed)
+                    {
+                        simulation->SetForceTolerance(simulation->GetForceTolerance() * (increase ? 2.0 : 0.5));
+                        LOG_INFO("Force tolerance: %.2e", simulation->GetForceTolerance());
+                    }
+                    else
+                    {
+                        simulation->SetTheta(simulation->GetTheta() + (increase ? 0.1 : -0.1));
+                        LOG_INFO("Theta: %.2f", simulation->GetTheta());
+                    }
+                    break;
+                }
+
+                // Toggle periodic force accuracy audit against direct summation
+                case GLFW_KEY_V:
+                {
+                    bool enabled = e->GetSimulation()->GetForceAuditInterval() == 0;
+                    e->GetSimulation()->SetForceAuditInterval(enabled ? FORCE_AUDIT_INTERVAL : 0);
+                    LOG_INFO("Force audit: %s", enabled ? "on" : "off");
+                    break;
+                }
+
+                // Toggle hierarchical block timesteps
+                case GLFW_KEY_H:
+                {
+                    bool enabled = !e->GetSimulation()->IsBlockTimeStepEnabled();
+                    e->GetSimulation()->SetBlockTimeStepEnabled(enabled);
+                    LOG_INFO("Block timesteps: %s", enabled ? "on" : "off");
+                    break;
+                }
+
+                // Toggle collision broadphase (uniform cell list / quadtree range queries) (Ctrl: toggle parallel collisions)
+                case GLFW_KEY_L:
+                {
+                    Simulation* simulation = e->GetSimulation();
+                    if (isKeyLeftCtrlPressed)
+                    {
+                        bool enabled = !simulation->IsParallelCollisionsEnabled();
+                        simulation->SetParallelCollisionsEnabled(enabled);
+                        LOG_INFO("Parallel collisions: %s", enabled ? "on (colored grid blocks)" : "off");
+                    }
+                    else
+                    {
+                        const char* broadphaseNames[] = { "quadtree range queries", "uniform cell list" };
+                        int currentBroadphase = (static_cast<int>(simulation->GetCollisionBroadphase()) + 1) % 2; // 2 total broadphases
+                        simulation->SetCollisionBroadphase(static_cast<CollisionBroadphase>(currentBroadphase));
+                        LOG_INFO("Collision broadphase: %s", broadphaseNames[currentBroadphase]);
+                    }
+                    break;
+                }
+
+                // Toggle swept collisions for fast movers (Ctrl: cycle speed threshold)
+                case GLFW_KEY_E:
+                {
+                    Simulation* simulation = e->GetSimulation();
+                    if (isKeyLeftCtrlPressed)
+                    {
+                        // 0.5, 1 and 2 particle radii per step
+                        double threshold = simulation->GetSweptSpeedThreshold();
+                        threshold = (threshold >= 2.0) ? 0.5 : 2.0 * threshold;
+                        simulation->SetSweptSpeedThreshold(threshold);
+                        LOG_INFO("Swept collision threshold: %.1f particle radii per step", threshold);
+                    }
+                    else
+                    {
+                        bool enabled = !simulation->IsSweptCollisionEnabled();
+                        simulation->SetSweptCollisionEnabled(enabled);
+                        LOG_INFO("Swept collisions: %s", enabled ? "on" : "off");
+                    }
+                    break;
+                }
+
+                // Toggle merge mode (Ctrl: cycle relative speed threshold)
+                case GLFW_KEY_Z:
+                {
+                    Simulation* simulation = e->GetSimulation();
+                    if (isKeyLeftCtrlPressed)
+                    {
+                        // Off, then 0.25, 0.5, 1 and 2 units/s
+                        double speed = simulation->GetMergeRelativeSpeed();
+                        speed = (speed >= 2.0) ? 0.0 : (speed <= 0.0) ? 0.25 : 2.0 * speed;
+                        simulation->SetMergeRelativeSpeed(speed);
+                        LOG_INFO("Merge relative speed: %.2f (0 = off)", speed);
+                    }
+                    else
+                    {
+                        bool enabled = !simulation->IsMergeModeEnabled();
+                        simulation->SetMergeModeEnabled(enabled);
+                        LOG_INFO("Merge mode: %s", enabled ? "on" : "off");
+                    }
+                    break;
+                }
+
+                // Cycle merge mass ratio
+                case GLFW_KEY_Y:
+                {
+                    // Off, then 2, 10 and 100
+                    Simulation* simulation = e->GetSimulation();
+                    double ratio = simulation->GetMergeMassRatio();
+                    ratio = (ratio >= 100.0) ? 0.0 : (ratio <= 0.0) ? 2.0 : (ratio >= 10.0) ? 100.0 : 10.0;
+                    simulation->SetMergeMassRatio(ratio);
+                    LOG_INFO("Merge mass ratio: %.0f (0 = off)", ratio);
+                    break;
+                }
+
+                // Toggle Verlet neighbor lists for collisions (Ctrl: cycle skin)
+                case GLFW_KEY_J:
+                {
+                    Simulation* simulation = e->GetSimulation();
+                    double skin = simulation->GetNeighborListSkin();
+                    if (isKeyLeftCtrlPressed)
+                    {
+                        // 0.25, 0.5, 1 and 2 particle radii
+                        skin = (skin <= 0.0 || skin >= 2.0 * PARTICLE_RADIUS) ? 0.25 * PARTICLE_RADIUS : 2.0 * skin;
+                    }
+                    else
+                    {
+                        skin = (skin > 0.0) ? 0.0 : COLLISION_VERLET_SKIN;
+                    }
+
+                    simulation->SetNeighborListSkin(skin);
+                    if (skin > 0.0)
+                    {
+                        LOG_INFO("Verlet neighbor lists: on, skin %.2f particle radii", skin / PARTICLE_RADIUS);
+                    }
+                    else
+                    {
+                        LOG_INFO("Verlet neighbor lists: off");
+                    }
+                    break;
+                }
+
+                // Cycle time integrator (Ctrl: toggle energy / angular momentum drift reports)
+                case GLFW_KEY_I:
+                {
+                    Simulation* simulation = e->GetSimulation();
+                    if (isKeyLeftCtrlPressed)
+                    {
+                        bool enabled = simulation->GetConservationInterval() == 0;
+                        simulation->SetConservationInterval(enabled ? CONSERVATION_INTERVAL : 0);
+                        LOG_INFO("Drift reports: %s", enabled ? "on" : "off");
+                    }
+                    else
+                    {
+                        const char* integratorNames[] = { "symplectic Euler", "leapfrog (KDK)", "Yoshida 4th order" };
+                        int currentIntegrator = (static_cast<int>(simulation->GetIntegrator()) + 1) % 3; // 3 total integrators
+                        simulation->SetIntegrator(static_cast<Integrator>(currentIntegrator));
+                        LOG_INFO("Integrator: %s", integratorNames[currentIntegrator]);
+                    }
+                    break;
+                }
+
+                // Toggle periodic Morton-order reordering of particle data
+                case GLFW_KEY_O:
+                {
+                    bool enabled = e->GetSimulation()->GetReorderInterval() == 0;
+                    e->GetSimulation()->SetReorderInterval(enabled ? REORDER_INTERVAL : 0);
+                    LOG_INFO("Particle reordering: %s", enabled ? "on" : "off");
+                    break;
+                }
+
+                // Double particle capacity (Ctrl: halve it, never below the current count)
+                case GLFW_KEY_N:
+                {
+                    Simulation* simulation = e->GetSimulation();
+                    size_t capacity = simulation->GetMaxParticleCount();
+                    simulation->SetMaxParticleCount(isKeyLeftCtrlPressed ? capacity / 2 : capacity * 2);
+                    LOG_INFO("Particle capacity: %zu", simulation->GetMaxParticleCount());
+                    break;
+                }
+
+                // Toggle open domain (Ctrl: cycle outlier handling)
+                case GLFW_KEY_U:
+                {
+                    Simulation* simulation = e->GetSimulation();
+                    if (isKeyLeftCtrlPressed)
+                    {
+                        const char* policyNames[] = { "include", "track", "drop" };
+                        int currentPolicy = (static_cast<int>(simulation->GetOutlierPolicy()) + 1) % 3; // 3 total policies
+                        simulation->SetOutlierPolicy(static_cast<OutlierPolicy>(currentPolicy));
+                        LOG_INFO("Outliers: %s", policyNames[currentPolicy]);
+                    }
+                    else
+                    {
+                        bool enabled = !simulation->IsOpenDomainEnabled();
+                        simulation->SetOpenDomainEnabled(enabled);
+                        LOG_INFO("Open domain: %s", enabled ? "on" : "off");
+                    }
+                    break;
+                }
+
                 // Color visualization mode switching
                 case GLFW_KEY_C:
                 {
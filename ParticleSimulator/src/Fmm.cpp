@@ -0,0 +1,642 @@
+/**
+  ******************************************************************************
+  * @file    Fmm.cpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   Fast multipole gravity (P2M, M2M, M2L, L2L, L2P) on the quadtree
+  ******************************************************************************
+  * @attention
+  *
+  * Expansion coefficients are stored by multi-index (a, b), meaning x^a y^b,
+  * at offset TermIndex(a, b). All orders share this layout.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "Fmm.hpp"
+#include "Simulation.hpp"
+
+/* Global variables --------------------------------------------------------- */
+/* Private typedef ---------------------------------------------------------- */
+/* Private define ----------------------------------------------------------- */
+/* Private macro ------------------------------------------------------------ */
+/* Private variables -------------------------------------------------------- */
+/* Private function prototypes ---------------------------------------------- */
+
+static int    TermIndex(int a, int b);
+static bool   IsLeaf(const QuadtreeNode* node);
+static void   ScaledPowers(double x, int order, double* powers);
+static void   KernelDerivatives(double rx, double ry, int order, double* derivatives);
+static void   CollectTargets(QuadtreeNode* node, int level, std::vector<QuadtreeNode*>& targets);
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Public Functions                                                           */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  FmmSolver constructor
+  * @retval None
+  */
+FmmSolver::FmmSolver()
+{
+    this->order    = FMM_DEFAULT_ORDER;
+    this->numTerms = 0;
+}
+
+
+/**
+  * @brief  Overwrite every particle's acceleration with the FMM gravity estimate
+  * @param  particles Reference to particle data (SoA)
+  * @param  root      Root of a tree whose mass distribution has been computed
+  * @param  pool      Node pool the tree was built in
+  * @param  order     Expansion order (clamped to [1, FMM_MAX_ORDER])
+  * @retval None
+  */
+void FmmSolver::ComputeAccelerations(ParticleData& particles, QuadtreeNode* root, QuadtreeNodePool& pool, int order)
+{
+    this->order    = std::max(1, std::min(order, FMM_MAX_ORDER));
+    this->numTerms = (size_t)TermIndex(0, this->order) + 1;
+
+    // Every node handed out so far has a poolIndex below pool.nextIndex
+    this->multipoles.resize(pool.nextIndex * this->numTerms);
+    this->locals.assign(pool.nextIndex * this->numTerms, 0.0);
+
+    int numParticles = (int)particles.Size();
+
+    #pragma omp parallel for if(numParticles > 1000)
+    for (int i = 0; i < numParticles; ++i)
+    {
+        particles.accelerations[i] = glm::dvec2(0.0);
+    }
+
+    if (!root || root->totalMass <= 0.0)
+        return;
+
+    this->targets.clear();
+    CollectTargets(root, 0, this->targets);
+
+    int numTargets = (int)this->targets.size();
+
+    // Upward pass: P2M at leaves, M2M towards the root
+    #pragma omp parallel for schedule(dynamic, 1) if(numParticles > 1000)
+    for (int t = 0; t < numTargets; ++t)
+    {
+        this->Upward(this->targets[t], particles);
+    }
+    this->UpwardTop(root, 0);
+
+    // Each task only writes expansions and accelerations inside its own subtree
+    #pragma omp parallel for schedule(dynamic, 1) if(numParticles > 1000)
+    for (int t = 0; t < numTargets; ++t)
+    {
+        this->Interact(this->targets[t], root, particles);
+        this->Downward(this->targets[t], particles);
+    }
+}
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Private Functions                                                          */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  Multipole coefficients of a node
+  * @param  node
+  * @retval double*
+  */
+double* FmmSolver::Multipole(const QuadtreeNode* node)
+{
+    return &this->multipoles[(size_t)node->cold->poolIndex * this->numTerms];
+}
+
+
+/**
+  * @brief  Local coefficients of a node
+  * @param  node
+  * @retval double*
+  */
+double* FmmSolver::Local(const QuadtreeNode* node)
+{
+    return &this->locals[(size_t)node->cold->poolIndex * this->numTerms];
+}
+
+
+/**
+  * @brief  Compute multipoles for a subtree (P2M at leaves, M2M above)
+  * @param  node
+  * @param  particles Reference to particle data (SoA)
+  * @retval None
+  */
+void FmmSolver::Upward(const QuadtreeNode* node, const ParticleData& particles)
+{
+    if (IsLeaf(node))
+    {
+        this->ParticleToMultipole(node, particles);
+        return;
+    }
+
+    std::fill(this->Multipole(node), this->Multipole(node) + this->numTerms, 0.0);
+
+    for (int c = 0; c < 4; ++c)
+    {
+        const QuadtreeNode* child = &node->children[c];
+
+        this->Upward(child, particles);
+        this->MultipoleToMultipole(child, node);
+    }
+}
+
+
+/**
+  * @brief  M2M for the nodes above the parallel subtree roots
+  * @param  node
+  * @param  level Tree depth of node
+  * @retval None
+  */
+void FmmSolver::UpwardTop(const QuadtreeNode* node, int level)
+{
+    if (level == PARALLEL_SPLIT_LEVEL || IsLeaf(node))
+        return;
+
+    std::fill(this->Multipole(node), this->Multipole(node) + this->numTerms, 0.0);
+
+    for (int c = 0; c < 4; ++c)
+    {
+        const QuadtreeNode* child = &node->children[c];
+
+        this->UpwardTop(child, level + 1);
+        this->MultipoleToMultipole(child, node);
+    }
+}
+
+
+/**
+  * @brief  Dual tree walk: M2L for well-separated cells, P2P for touching leaves
+  * @param  target    Node receiving the interaction
+  * @param  source    Node producing it
+  * @param  particles Reference to particle data (SoA)
+  * @retval None
+  * @note   Only the target side is written, so walks for disjoint targets can run in parallel
+  */
+void FmmSolver::Interact(const QuadtreeNode* target, const QuadtreeNode* source, ParticleData& particles)
+{
+    if (target->totalMass <= 0.0 || source->totalMass <= 0.0)
+        return;
+
+    double dx = target->centerX - source->centerX;
+    double dy = target->centerY - source->centerY;
+    double radii = (target->halfSize + source->halfSize) * 1.4142135624;
+
+    if (radii * radii < FMM_THETA * FMM_THETA * (dx * dx + dy * dy))
+    {
+        this->MultipoleToLocal(target, source);
+        return;
+    }
+
+    bool targetLeaf = IsLeaf(target);
+    bool sourceLeaf = IsLeaf(source);
+
+    if (targetLeaf && sourceLeaf)
+    {
+        this->ParticleToParticle(target, source, particles);
+        return;
+    }
+
+    // Split the larger cell (or the only one that can be split)
+    if (sourceLeaf || (!targetLeaf && target->halfSize >= source->halfSize))
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            this->Interact(&target->children[c], source, particles);
+        }
+    }
+    else
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            this->Interact(target, &source->children[c], particles);
+        }
+    }
+}
+
+
+/**
+  * @brief  Push local expansions down a subtree (L2L) and evaluate them at leaves (L2P)
+  * @param  node
+  * @param  particles Reference to particle data (SoA)
+  * @retval None
+  */
+void FmmSolver::Downward(const QuadtreeNode* node, ParticleData& particles)
+{
+    if (node->totalMass <= 0.0)
+        return;
+
+    if (IsLeaf(node))
+    {
+        this->LocalToParticle(node, particles);
+        return;
+    }
+
+    for (int c = 0; c < 4; ++c)
+    {
+        const QuadtreeNode* child = &node->children[c];
+
+        this->LocalToLocal(node, child);
+        this->Downward(child, particles);
+    }
+}
+
+
+/**
+  * @brief  P2M: M_k = sum m (c - x)^k / k!
+  * @param  leaf
+  * @param  particles Reference to particle data (SoA)
+  * @retval None
+  */
+void FmmSolver::ParticleToMultipole(const QuadtreeNode* leaf, const ParticleData& particles)
+{
+    double* multipole = this->Multipole(leaf);
+    std::fill(multipole, multipole + this->numTerms, 0.0);
+
+    double px[FMM_MAX_ORDER + 1];
+    double py[FMM_MAX_ORDER + 1];
+
+    for (const QuadtreeNode* bucket = leaf; bucket; bucket = bucket->cold->overflow)
+    {
+        for (size_t k = 0; k < bucket->cold->particleCount; ++k)
+        {
+            size_t idx = bucket->cold->particleIndices[k];
+            double mass = particles.masses[idx];
+
+            ScaledPowers(leaf->centerX - particles.positions[idx].x, this->order, px);
+            ScaledPowers(leaf->centerY - particles.positions[idx].y, this->order, py);
+
+            for (int n = 0; n <= this->order; ++n)
+            {
+                for (int b = 0; b <= n; ++b)
+                {
+                    multipole[TermIndex(n - b, b)] += mass * px[n - b] * py[b];
+                }
+            }
+        }
+    }
+}
+
+
+/**
+  * @brief  M2M: shift a child's multipole to its parent's center and add it
+  * @param  child
+  * @param  parent
+  * @retval None
+  */
+void FmmSolver::MultipoleToMultipole(const QuadtreeNode* child, const QuadtreeNode* parent)
+{
+    if (child->totalMass <= 0.0)
+        return;
+
+    const double* source = this->Multipole(child);
+    double*       target = this->Multipole(parent);
+
+    double tx[FMM_MAX_ORDER + 1];
+    double ty[FMM_MAX_ORDER + 1];
+    ScaledPowers(parent->centerX - child->centerX, this->order, tx);
+    ScaledPowers(parent->centerY - child->centerY, this->order, ty);
+
+    for (int n = 0; n <= this->order; ++n)
+    {
+        for (int b = 0; b <= n; ++b)
+        {
+            int a = n - b;
+            double sum = 0.0;
+
+            for (int i = 0; i <= a; ++i)
+            {
+                for (int j = 0; j <= b; ++j)
+                {
+                    sum += tx[a - i] * ty[b - j] * source[TermIndex(i, j)];
+                }
+            }
+
+            target[TermIndex(a, b)] += sum;
+        }
+    }
+}
+
+
+/**
+  * @brief  M2L: L_n += sum_k M_k D_(k+n)(target - source)
+  * @param  target
+  * @param  source
+  * @retval None
+  */
+void FmmSolver::MultipoleToLocal(const QuadtreeNode* target, const QuadtreeNode* source)
+{
+    const double* multipole = this->Multipole(source);
+    double*       local     = this->Local(target);
+
+    double derivatives[FMM_MAX_TERMS];
+    KernelDerivatives(target->centerX - source->centerX, target->centerY - source->centerY, this->order, derivatives);
+
+    for (int n = 0; n <= this->order; ++n)
+    {
+        for (int b = 0; b <= n; ++b)
+        {
+            int a = n - b;
+            double sum = 0.0;
+
+            for (int m = 0; m <= this->order - n; ++m)
+            {
+                for (int j = 0; j <= m; ++j)
+                {
+                    int i = m - j;
+                    sum += multipole[TermIndex(i, j)] * derivatives[TermIndex(a + i, b + j)];
+                }
+            }
+
+            local[TermIndex(a, b)] += sum;
+        }
+    }
+}
+
+
+/**
+  * @brief  L2L: shift a parent's local expansion to a child's center and add it
+  * @param  parent
+  * @param  child
+  * @retval None
+  */
+void FmmSolver::LocalToLocal(const QuadtreeNode* parent, const QuadtreeNode* child)
+{
+    const double* source = this->Local(parent);
+    double*       target = this->Local(child);
+
+    double tx[FMM_MAX_ORDER + 1];
+    double ty[FMM_MAX_ORDER + 1];
+    ScaledPowers(child->centerX - parent->centerX, this->order, tx);
+    ScaledPowers(child->centerY - parent->centerY, this->order, ty);
+
+    for (int n = 0; n <= this->order; ++n)
+    {
+        for (int b = 0; b <= n; ++b)
+        {
+            int a = n - b;
+            double sum = 0.0;
+
+            for (int m = 0; m <= this->order - n; ++m)
+            {
+                for (int j = 0; j <= m; ++j)
+                {
+                    int i = m - j;
+                    sum += tx[i] * ty[j] * source[TermIndex(a + i, b + j)];
+                }
+            }
+
+            target[TermIndex(a, b)] += sum;
+        }
+    }
+}
+
+
+/**
+  * @brief  L2P: add G * grad(local expansion) to each particle in a leaf
+  * @param  leaf
+  * @param  particles Reference to particle data (SoA)
+  * @retval None
+  */
+void FmmSolver::LocalToParticle(const QuadtreeNode* leaf, ParticleData& particles)
+{
+    const double* local = this->Local(leaf);
+
+    double px[FMM_MAX_ORDER + 1];
+    double py[FMM_MAX_ORDER + 1];
+
+    for (const QuadtreeNode* bucket = leaf; bucket; bucket = bucket->cold->overflow)
+    {
+        for (size_t k = 0; k < bucket->cold->particleCount; ++k)
+        {
+            size_t idx = bucket->cold->particleIndices[k];
+
+            ScaledPowers(particles.positions[idx].x - leaf->centerX, this->order, px);
+            ScaledPowers(particles.positions[idx].y - leaf->centerY, this->order, py);
+
+            double gx = 0.0;
+            double gy = 0.0;
+
+            for (int n = 0; n < this->order; ++n)
+            {
+                for (int b = 0; b <= n; ++b)
+                {
+                    int a = n - b;
+                    double weight = px[a] * py[b];
+                    gx += weight * local[TermIndex(a + 1, b)];
+                    gy += weight * local[TermIndex(a, b + 1)];
+                }
+            }
+
+            particles.accelerations[idx] += GRAVITATIONAL_CONSTANT * glm::dvec2(gx, gy);
+        }
+    }
+}
+
+
+/**
+  * @brief  P2P: direct accelerations on the target leaf's particles (same formula as ComputeForceBarnesHut)
+  * @param  target
+  * @param  source
+  * @param  particles Reference to particle data (SoA)
+  * @retval None
+  */
+void FmmSolver::ParticleToParticle(const QuadtreeNode* target, const QuadtreeNode* source, ParticleData& particles)
+{
+    // Depth-capped leaves continue in their overflow buckets
+    for (const QuadtreeNode* targetBucket = target; targetBucket; targetBucket = targetBucket->cold->overflow)
+    {
+        for (size_t t = 0; t < targetBucket->cold->particleCount; ++t)
+        {
+            size_t i = targetBucket->cold->particleIndices[t];
+            glm::dvec2 acceleration(0.0);
+
+            for (const QuadtreeNode* sourceBucket = source; sourceBucket; sourceBucket = sourceBucket->cold->overflow)
+            {
+                for (size_t s = 0; s < sourceBucket->cold->particleCount; ++s)
+                {
+                    size_t j = sourceBucket->cold->particleIndices[s];
+
+                    if (j == i)
+                        continue;
+
+                    glm::dvec2 dir = particles.positions[j] - particles.positions[i];
+                    double dist2 = glm::dot(dir, dir);
+                    if (dist2 < MIN_INTERACTION_DISTANCE * MIN_INTERACTION_DISTANCE)
+                        dist2 = MIN_INTERACTION_DISTANCE * MIN_INTERACTION_DISTANCE;
+
+                    double softDist2 = dist2 + SOFTENING * SOFTENING;
+                    acceleration += GRAVITATIONAL_CONSTANT * particles.masses[j] / softDist2 * glm::normalize(dir);
+                }
+            }
+
+            particles.accelerations[i] += acceleration;
+        }
+    }
+}
+
+
+/**
+  * @brief  Offset of coefficient x^a y^b (grouped by total order a + b)
+  * @param  a
+  * @param  b
+  * @retval int
+  */
+static int TermIndex(int a, int b)
+{
+    int n = a + b;
+    return n * (n + 1) / 2 + b;
+}
+
+
+/**
+  * @brief  True if the node has no children
+  * @param  node
+  * @retval bool
+  */
+static bool IsLeaf(const QuadtreeNode* node)
+{
+    return !node->children;
+}
+
+
+/**
+  * @brief  powers[k] = x^k / k! for k = 0..order
+  * @param  x
+  * @param  order
+  * @param  powers
+  * @retval None
+  */
+static void ScaledPowers(double x, int order, double* powers)
+{
+    powers[0] = 1.0;
+    for (int k = 1; k <= order; ++k)
+    {
+        powers[k] = powers[k - 1] * x / k;
+    }
+}
+
+
+/**
+  * @brief  Partial derivatives d^(a+b) / dx^a dy^b of the softened kernel at r = (rx, ry)
+  * @param  rx
+  * @param  ry
+  * @param  order        Highest total derivative order a + b
+  * @param  derivatives  Output, indexed by TermIndex(a, b)
+  * @retval None
+  * @note   The kernel f is the potential whose gradient is the direct force law,
+  *         |grad f| = 1 / (d^2 + SOFTENING^2). With u = d^2 / 2, f'(u) = -1 / (d (d^2 + SOFTENING^2)),
+  *         and the higher radial derivatives R(n) = d^n f / du^n follow from the Leibniz rule.
+  *         The Cartesian derivatives then use the Hermite-style recurrence
+  *         R(n)[a+1, b] = x R(n+1)[a, b] + a R(n+1)[a-1, b] (and the same for y).
+  */
+static void KernelDerivatives(double rx, double ry, int order, double* derivatives)
+{
+    double radial[FMM_MAX_ORDER + 1][FMM_MAX_TERMS];
+    double inverseDistance[FMM_MAX_ORDER + 1];  // d^k/du^k of 1 / d
+    double inverseSoftened[FMM_MAX_ORDER + 1];  // d^k/du^k of 1 / (d^2 + SOFTENING^2)
+
+    double dist2 = rx * rx + ry * ry;
+    double soft2 = dist2 + SOFTENING * SOFTENING;
+    double dist  = std::sqrt(dist2);
+
+    inverseDistance[0] = 1.0 / dist;
+    inverseSoftened[0] = 1.0 / soft2;
+    for (int k = 0; k < order; ++k)
+    {
+        inverseDistance[k + 1] = inverseDistance[k] * -(2 * k + 1) / dist2;
+        inverseSoftened[k + 1] = inverseSoftened[k] * -2.0 * (k + 1) / soft2;
+    }
+
+    // R(0) is the potential itself (only the gradient is ever used)
+    radial[0][0] = (0.5 * MATH_PI_CONSTANT - std::atan(dist / SOFTENING)) / SOFTENING;
+
+    for (int n = 1; n <= order; ++n)
+    {
+        double binomial = 1.0;
+        double sum = 0.0;
+
+        for (int k = 0; k < n; ++k)
+        {
+            sum += binomial * inverseDistance[k] * inverseSoftened[n - 1 - k];
+            binomial = binomial * (n - 1 - k) / (k + 1);
+        }
+
+        radial[n][0] = -sum;
+    }
+
+    for (int total = 1; total <= order; ++total)
+    {
+        for (int n = 0; n <= order - total; ++n)
+        {
+            for (int b = 0; b <= total; ++b)
+            {
+                int a = total - b;
+                double result;
+
+                if (a > 0)
+                {
+                    result = rx * radial[n + 1][TermIndex(a - 1, b)];
+                    if (a > 1) result += (a - 1) * radial[n + 1][TermIndex(a - 2, b)];
+                }
+                else
+                {
+                    result = ry * radial[n + 1][TermIndex(0, b - 1)];
+                    if (b > 1) result += (b - 1) * radial[n + 1][TermIndex(0, b - 2)];
+                }
+
+                radial[n][TermIndex(a, b)] = result;
+            }
+        }
+    }
+
+    for (int k = 0; k <= TermIndex(0, order); ++k)
+    {
+        derivatives[k] = radial[0][k];
+    }
+}
+
+
+/**
+  * @brief  Gather the nodes at PARALLEL_SPLIT_LEVEL (and any shallower leaves)
+  * @param  node
+  * @param  level   Tree depth of node
+  * @param  targets Output list of subtree roots
+  * @retval None
+  */
+static void CollectTargets(QuadtreeNode* node, int level, std::vector<QuadtreeNode*>& targets)
+{
+    if (level == PARALLEL_SPLIT_LEVEL || IsLeaf(node))
+    {
+        targets.push_back(node);
+        return;
+    }
+
+    for (int c = 0; c < 4; ++c)
+    {
+        CollectTargets(&node->children[c], level + 1, targets);
+    }
+}
+
+
+
+/******************************** END OF FILE *********************************/
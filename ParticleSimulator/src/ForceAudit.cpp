@@ -0,0 +1,148 @@
+/**
+  ******************************************************************************
+  * @file    ForceAudit.cpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   Sampled accuracy check of the gravity solver against direct summation
+  ******************************************************************************
+  * @attention
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "DirectSum.hpp"
+#include "ForceAudit.hpp"
+#include "Simulation.hpp"
+
+/* Global variables --------------------------------------------------------- */
+/* Private typedef ---------------------------------------------------------- */
+
+typedef std::chrono::high_resolution_clock AUDIT_CLOCK_T;
+
+/* Private define ----------------------------------------------------------- */
+/* Private macro ------------------------------------------------------------ */
+/* Private variables -------------------------------------------------------- */
+/* Private function prototypes ---------------------------------------------- */
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Public Functions                                                           */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  ForceAudit constructor
+  * @retval None
+  */
+ForceAudit::ForceAudit()
+{
+    this->generator.seed(std::random_device{}());
+    this->report = ForceAuditReport();
+}
+
+
+/**
+  * @brief  Compare the current accelerations of a random sample with direct summation
+  * @param  particles Reference to particle data (SoA), accelerations from the solver this frame
+  * @param  solverMs  Time the solver took to produce those accelerations
+  * @retval None
+  * @note   Particles are drawn with replacement; every particle is used when there are
+  *         no more than FORCE_AUDIT_SAMPLES. Particles with zero exact acceleration are skipped.
+  */
+void ForceAudit::Run(const ParticleData& particles, double solverMs)
+{
+    size_t numParticles = particles.Size();
+    if (numParticles < 2)
+        return;
+
+    this->samples.clear();
+    if (numParticles <= FORCE_AUDIT_SAMPLES)
+    {
+        for (size_t i = 0; i < numParticles; ++i)
+        {
+            this->samples.push_back(i);
+        }
+    }
+    else
+    {
+        std::uniform_int_distribution<size_t> pick(0, numParticles - 1);
+        for (size_t s = 0; s < FORCE_AUDIT_SAMPLES; ++s)
+        {
+            this->samples.push_back(pick(this->generator));
+        }
+    }
+
+    int numSamples = (int)this->samples.size();
+    this->errors.assign(numSamples, -1.0);
+
+    AUDIT_CLOCK_T::time_point t0 = AUDIT_CLOCK_T::now();
+
+    #pragma omp parallel for schedule(dynamic, 4)
+    for (int s = 0; s < numSamples; ++s)
+    {
+        size_t i = this->samples[s];
+        glm::dvec2 exact = ComputeAccelerationDirect(i, particles);
+        double exactLength = glm::length(exact);
+
+        if (exactLength > 0.0)
+        {
+            // A non-finite solver result counts as the worst error (NaN would break the sort)
+            double error = glm::length(particles.accelerations[i] - exact) / exactLength;
+            this->errors[s] = std::isfinite(error) ? error : HUGE_VAL;
+        }
+    }
+
+    AUDIT_CLOCK_T::time_point t1 = AUDIT_CLOCK_T::now();
+    double sampleMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+    this->errors.erase(std::remove(this->errors.begin(), this->errors.end(), -1.0), this->errors.end());
+    if (this->errors.empty())
+        return;
+
+    std::sort(this->errors.begin(), this->errors.end());
+    size_t count = this->errors.size();
+
+    this->report.samples     = count;
+    this->report.medianError = (count % 2) ? this->errors[count / 2] : 0.5 * (this->errors[count / 2 - 1] + this->errors[count / 2]);
+    this->report.p99Error    = this->errors[(size_t)std::ceil(0.99 * count) - 1];
+    this->report.maxError    = this->errors[count - 1];
+    this->report.solverMs    = solverMs;
+    this->report.directMs    = sampleMs * (double)numParticles / (double)numSamples;
+    this->report.costRatio   = (solverMs > 0.0) ? this->report.directMs / solverMs : 0.0;
+
+    LOG_INFO("Force audit: %zu samples, relative error median %.2e / p99 %.2e / max %.2e, solver %.2f ms vs direct %.1f ms (%.1fx)",
+        count, this->report.medianError, this->report.p99Error, this->report.maxError,
+        this->report.solverMs, this->report.directMs, this->report.costRatio);
+}
+
+
+/**
+  * @brief  Get the result of the latest audit
+  * @param  None
+  * @retval const ForceAuditReport&
+  */
+const ForceAuditReport& ForceAudit::GetReport() const
+{
+    return this->report;
+}
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Private Functions                                                          */
+/******************************************************************************/
+/******************************************************************************/
+
+
+
+/******************************** END OF FILE *********************************/
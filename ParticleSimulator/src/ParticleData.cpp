@@ -28,6 +28,9 @@
 /* Private variables ---------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 
+template <typename T>
+static void PermuteArray(std::vector<T>& values, const std::vector<uint32_t>& order, std::vector<T>& scratch);
+
 
 
 /******************************************************************************/
@@ -63,8 +66,11 @@ size_t ParticleData::AddParticle(double mass, glm::dvec2 position, glm::dvec2 ve
     positions.push_back(position);
     velocities.push_back(velocity);
     colors.push_back(glm::vec3(1.0f));
+    timeLevels.push_back(0);
     framesSinceColorUpdate.push_back(0);
 
+    layoutVersion++;
+
     size_t index = positions.size() - 1;
     UpdateColor(index);  // Calculate initial color
     return index;
@@ -91,9 +97,12 @@ void ParticleData::RemoveParticle(size_t index)
         positions[index] = positions[lastIndex];
         velocities[index] = velocities[lastIndex];
         colors[index] = colors[lastIndex];
+        timeLevels[index] = timeLevels[lastIndex];
         framesSinceColorUpdate[index] = framesSinceColorUpdate[lastIndex];
     }
 
+    layoutVersion++;
+
     // Remove last element
     ages.pop_back();
     masses.pop_back();
@@ -101,10 +110,85 @@ void ParticleData::RemoveParticle(size_t index)
     positions.pop_back();
     velocities.pop_back();
     colors.pop_back();
+    timeLevels.pop_back();
     framesSinceColorUpdate.pop_back();
 }
 
 
+/**
+  * @brief  Remove every marked particle in one compaction pass
+  * @param  removed Per-particle flags (1 = remove)
+  * @retval size_t Number of particles removed
+  * @note   Unlike RemoveParticle, survivors keep their relative order, so a Morton-ordered
+  *         layout stays (nearly) ordered.
+  */
+size_t ParticleData::RemoveMarked(const std::vector<uint8_t>& removed)
+{
+    assert(removed.size() == positions.size());
+
+    size_t numParticles = positions.size();
+    size_t kept = 0;
+
+    for (size_t i = 0; i < numParticles; ++i)
+    {
+        if (removed[i])
+            continue;
+
+        if (kept != i)
+        {
+            ages[kept] = ages[i];
+            masses[kept] = masses[i];
+            accelerations[kept] = accelerations[i];
+            positions[kept] = positions[i];
+            velocities[kept] = velocities[i];
+            colors[kept] = colors[i];
+            timeLevels[kept] = timeLevels[i];
+            framesSinceColorUpdate[kept] = framesSinceColorUpdate[i];
+        }
+
+        kept++;
+    }
+
+    if (kept == numParticles)
+        return 0;
+
+    layoutVersion++;
+
+    ages.resize(kept);
+    masses.resize(kept);
+    accelerations.resize(kept);
+    positions.resize(kept);
+    velocities.resize(kept);
+    colors.resize(kept);
+    timeLevels.resize(kept);
+    framesSinceColorUpdate.resize(kept);
+
+    return numParticles - kept;
+}
+
+
+/**
+  * @brief  Permute every particle array
+  * @param  order   New-to-old index map (order[i] is the old index of particle i)
+  * @retval None
+  */
+void ParticleData::Reorder(const std::vector<uint32_t>& order)
+{
+    assert(order.size() == positions.size());
+
+    PermuteArray(ages, order, scratchDouble);
+    PermuteArray(masses, order, scratchDouble);
+    PermuteArray(accelerations, order, scratchVec2);
+    PermuteArray(positions, order, scratchVec2);
+    PermuteArray(velocities, order, scratchVec2);
+    PermuteArray(colors, order, scratchColor);
+    PermuteArray(timeLevels, order, scratchByte);
+    PermuteArray(framesSinceColorUpdate, order, scratchInt);
+
+    layoutVersion++;
+}
+
+
 /**
   * @brief  Clear all particles
   * @param  None
@@ -112,12 +196,15 @@ void ParticleData::RemoveParticle(size_t index)
   */
 void ParticleData::Clear()
 {
+    layoutVersion++;
+
     ages.clear();
     masses.clear();
     accelerations.clear();
     positions.clear();
     velocities.clear();
     colors.clear();
+    timeLevels.clear();
     framesSinceColorUpdate.clear();
 }
 
@@ -135,6 +222,7 @@ void ParticleData::Reserve(size_t capacity)
     positions.reserve(capacity);
     velocities.reserve(capacity);
     colors.reserve(capacity);
+    timeLevels.reserve(capacity);
     framesSinceColorUpdate.reserve(capacity);
 }
 
@@ -162,7 +250,6 @@ void ParticleData::UpdateParticle(size_t index, double timeStep)
     velocities[index] += accelerations[index] * timeStep;
     velocities[index] *= DAMPING_FACTOR;
     positions[index] += velocities[index] * timeStep;
-    accelerations[index] = glm::dvec2(0.0);
 
     UpdateColor(index);
 }
@@ -277,5 +364,31 @@ glm::vec3 ParticleData::CalculateColor(size_t index) const
 /******************************************************************************/
 
 
+/**
+  * @brief  Gather one particle array into a new order (keeps reserved capacity)
+  * @param  values
+  * @param  order   New-to-old index map
+  * @param  scratch Gather buffer shared by the arrays of this element type (only grows)
+  * @retval None
+  */
+template <typename T>
+static void PermuteArray(std::vector<T>& values, const std::vector<uint32_t>& order, std::vector<T>& scratch)
+{
+    size_t count = values.size();
+
+    if (scratch.size() < count)
+    {
+        scratch.resize(count);
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        scratch[i] = values[order[i]];
+    }
+
+    std::copy(scratch.begin(), scratch.begin() + count, values.begin());
+}
+
+
 
 /******************************** END OF FILE *********************************/
@@ -16,6 +16,7 @@
 
 #include "PCH.hpp"
 
+#include "Benchmark.hpp"
 #include "Engine.hpp"
 #include "Simulation.hpp"
 #include "Particle.hpp"
@@ -54,9 +55,33 @@ int WINAPI WinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance, _
         ShowConsole();
     }
 
+    // Particle capacity, e.g. "--particles 500000" (also sizes the benchmark scenes)
+    size_t particleCapacity = MAX_NUM_PARTICLES;
+    size_t particlesArg = cmdLine.find("--particles");
+
+    if (particlesArg != std::string::npos)
+    {
+        const char* value = cmdLine.c_str() + particlesArg + strlen("--particles");
+        while (*value == ' ' || *value == '=') ++value;
+
+        particleCapacity = std::min((size_t)std::strtoull(value, nullptr, 10), PARTICLE_CAPACITY_LIMIT);
+        if (particleCapacity == 0)
+        {
+            particleCapacity = MAX_NUM_PARTICLES;
+        }
+    }
+
+    if (cmdLine.find("--benchmark") != std::string::npos)
+    {
+        ShowConsole();
+        RunBenchmarks(particleCapacity);
+        return 0;
+    }
+
     Engine e;
 
     Simulation sim(&e);
+    sim.SetMaxParticleCount(particleCapacity);
 
     sim.GetEngine()->Init();
 
@@ -17,6 +17,7 @@
 #include "PCH.hpp"
 
 #include "Quadtree.hpp"
+#include "VectorMath.hpp"
 
 /* Global variables ----------------------------------------------------------*/
 /* Private typedef -----------------------------------------------------------*/
@@ -25,6 +26,26 @@
 /* Private variables ---------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 
+static int      CurrentThread();
+static void     AccumulateQuadrupole(double quadrupole[3], double mass, double dx, double dy);
+static glm::dvec2 QuadrupoleAcceleration(const double quadrupole[3], double rx, double ry, double soft2);
+static uint32_t ExpandBits16(uint32_t v);
+static uint32_t QuantizeAxis(double p, double minP, double width);
+static size_t   ComputeMortonKeys(const ParticleData& particles, QuadtreeNodePool& pool, size_t first, size_t last, double centerX, double centerY, double halfSize);
+static size_t   DropOutsideRoot(const QuadtreeNode* root, const ParticleData& particles, QuadtreeNodePool& pool, size_t count);
+static void     RadixSortMortonKeys(QuadtreeNodePool& pool, size_t count);
+static void     RadixSortMortonKeysParallel(QuadtreeNodePool& pool, size_t count);
+static void     BuildMortonRange(QuadtreeNode* node, size_t first, size_t last, int level, const ParticleData& particles, QuadtreeNodePool& pool, std::vector<MortonTask>* deferred);
+static void     CollectSubtreeRoots(QuadtreeNode* node, int level, std::vector<QuadtreeNode*>& roots);
+static void     CombineTopLevelMass(QuadtreeNode* node, int level);
+static void     RecordLeaves(QuadtreeNode* node, std::vector<QuadtreeNode*>& particleLeaves);
+static void     RemapLeafIndices(QuadtreeNode* node, const std::vector<uint32_t>& newIndexOf);
+static bool     FlattenSubtree(const QuadtreeNode* node, int depth, const ParticleData& particles, FlatQuadtree& tree);
+static void     BuildInteractionList(const QuadtreeNode* node, double xMin, double yMin, double xMax, double yMax, const OpeningTest& test, double lastAcceleration, const ParticleData& particles, ForcePrecision precision, const glm::dvec2& origin, InteractionList& list);
+static glm::dvec2 LeafAcceleration(double px, double py, const double* x, const double* y, const double* mass, size_t count, double centerX, double centerY, ForcePrecision precision);
+static bool     AcceptNode(const OpeningTest& test, double xMin, double yMin, double xMax, double yMax, double dist, const glm::dvec2& centerOfMass, const glm::dvec2& center, double halfSize, double totalMass, const double quadrupole[3], double lastAcceleration);
+static void     InsertTracked(QuadtreeNode* node, size_t particleIndex, const ParticleData& particles, QuadtreeNodePool& pool, std::vector<QuadtreeNode*>& particleLeaves);
+
 
 
 /******************************************************************************/
@@ -40,6 +61,7 @@
   * @param  cy    Center y coordinate
   * @param  hs    Half-size of the node
   * @retval None
+  * @note   The cold half stays attached to the pool slot; only its contents are reset.
   */
 void QuadtreeNode::Init(double cx, double cy, double hs)
 {
@@ -48,22 +70,44 @@ void QuadtreeNode::Init(double cx, double cy, double hs)
     this->centerY       = cy;
     this->halfSize      = hs;
     this->totalMass     = 0.0;
-    this->particleCount = 0;
-    this->nw = nullptr;
-    this->ne = nullptr;
-    this->sw = nullptr;
-    this->se = nullptr;
+    this->children      = nullptr;
+    this->cold->quadrupole[0] = 0.0;
+    this->cold->quadrupole[1] = 0.0;
+    this->cold->quadrupole[2] = 0.0;
+    this->cold->particleCount = 0;
+    this->cold->overflow      = nullptr;
+}
+
+
+/**
+  * @brief  Arena block constructor — places the hot nodes on cache lines and links their cold halves
+  * @retval None
+  */
+QuadtreeNodeChunk::QuadtreeNodeChunk()
+{
+    storage.resize(POOL_CHUNK_NODES * sizeof(QuadtreeNode) + CACHE_LINE_SIZE);
+    cold.resize(POOL_CHUNK_NODES);
+
+    uintptr_t address = reinterpret_cast<uintptr_t>(storage.data());
+    address = (address + CACHE_LINE_SIZE - 1) & ~(uintptr_t)(CACHE_LINE_SIZE - 1);
+    nodes = reinterpret_cast<QuadtreeNode*>(address);
+
+    for (size_t k = 0; k < POOL_CHUNK_NODES; ++k)
+    {
+        QuadtreeNode* node = new (&nodes[k]) QuadtreeNode;
+        node->cold = &cold[k];
+    }
 }
 
 
 /**
-  * @brief  QuadtreeNodePool constructor — pre-allocates all nodes once
+  * @brief  QuadtreeNodePool constructor — blocks are allocated on first use
   * @retval None
   */
 QuadtreeNodePool::QuadtreeNodePool()
 {
-    nodes.resize(POOL_MAX_NODES);
-    nextIndex = 0;
+    highWaterMark = 0;
+    Reset();
 }
 
 
@@ -76,13 +120,78 @@ QuadtreeNodePool::QuadtreeNodePool()
   */
 QuadtreeNode* QuadtreeNodePool::Allocate(double cx, double cy, double hs)
 {
-    assert(nextIndex < POOL_MAX_NODES && "QuadtreeNodePool exhausted — increase POOL_MAX_NODES");
-    QuadtreeNode* node = &nodes[nextIndex++];
+    QuadtreeNodeSlice& slice = slices[CurrentThread()];
+
+    // Claim a fresh slice for this thread once its current one is used up (slices never straddle blocks)
+    if (slice.next == slice.end)
+    {
+        ClaimSlice(slice);
+    }
+
+    QuadtreeNode* node = slice.next++;
     node->Init(cx, cy, hs);
+    node->cold->poolIndex = slice.nextIndex++;
     return node;
 }
 
 
+/**
+  * @brief  Allocate the four children of a node as consecutive pool nodes
+  * @param  cx    Parent center x
+  * @param  cy    Parent center y
+  * @param  hs    Parent half-size
+  * @retval Pointer to the first child (nw, then ne, sw, se)
+  * @note   A slice with fewer than four nodes left is abandoned (at most three nodes lost).
+  */
+QuadtreeNode* QuadtreeNodePool::AllocateChildren(double cx, double cy, double hs)
+{
+    QuadtreeNodeSlice& slice = slices[CurrentThread()];
+
+    if (slice.end - slice.next < 4)
+    {
+        ClaimSlice(slice);
+    }
+
+    double quarterSize = hs / 2.0;
+    const double offsetX[4] = { -quarterSize, quarterSize, -quarterSize, quarterSize };
+    const double offsetY[4] = { quarterSize, quarterSize, -quarterSize, -quarterSize };
+
+    QuadtreeNode* children = slice.next;
+    for (int c = 0; c < 4; ++c)
+    {
+        children[c].Init(cx + offsetX[c], cy + offsetY[c], quarterSize);
+        children[c].cold->poolIndex = slice.nextIndex++;
+    }
+    slice.next += 4;
+
+    return children;
+}
+
+
+/**
+  * @brief  Hand the next POOL_SLICE_NODES nodes of the arena to a thread, growing it by a block if needed
+  * @param  slice The thread's slice
+  * @retval None
+  */
+void QuadtreeNodePool::ClaimSlice(QuadtreeNodeSlice& slice)
+{
+    #pragma omp critical(QuadtreeNodePool)
+    {
+        size_t chunk = nextIndex / POOL_CHUNK_NODES;
+        if (chunk == chunks.size())
+        {
+            chunks.emplace_back();
+        }
+
+        slice.next      = chunks[chunk].nodes + nextIndex % POOL_CHUNK_NODES;
+        slice.end       = slice.next + POOL_SLICE_NODES;
+        slice.nextIndex = (uint32_t)nextIndex;
+        nextIndex      += POOL_SLICE_NODES;
+        highWaterMark   = std::max(highWaterMark, nextIndex);
+    }
+}
+
+
 /**
   * @brief  Reset the pool for reuse next frame (no destructors, O(1))
   * @retval None
@@ -90,6 +199,74 @@ QuadtreeNode* QuadtreeNodePool::Allocate(double cx, double cy, double hs)
 void QuadtreeNodePool::Reset()
 {
     nextIndex = 0;
+
+    for (QuadtreeNodeSlice& slice : slices)
+    {
+        slice.next      = nullptr;
+        slice.end       = nullptr;
+        slice.nextIndex = 0;
+    }
+}
+
+
+/**
+  * @brief  Number of nodes the allocated blocks can hold
+  * @param  None
+  * @retval size_t
+  */
+size_t QuadtreeNodePool::Capacity() const
+{
+    return chunks.size() * POOL_CHUNK_NODES;
+}
+
+
+/**
+  * @brief  Most nodes in use at once since the pool was created (in whole slices)
+  * @param  None
+  * @retval size_t
+  */
+size_t QuadtreeNodePool::HighWaterMark() const
+{
+    return highWaterMark;
+}
+
+
+/**
+  * @brief  Set total mass, center of mass and quadrupole from children that are already computed
+  * @retval None
+  */
+void QuadtreeNode::CombineChildMass()
+{
+    double massSum = 0.0;
+    glm::dvec2 weightedPosition(0.0);
+
+    for (int c = 0; c < 4; ++c)
+    {
+        massSum += children[c].totalMass;
+        weightedPosition += children[c].centerOfMass * children[c].totalMass;
+    }
+
+    totalMass = massSum;
+    if (massSum > 0.0)
+    {
+        centerOfMass = weightedPosition / massSum;
+    }
+
+    // Shift each child's quadrupole to this node's center of mass (parallel-axis theorem)
+    double* quadrupole = cold->quadrupole;
+    quadrupole[0] = quadrupole[1] = quadrupole[2] = 0.0;
+
+    for (int c = 0; c < 4; ++c)
+    {
+        const QuadtreeNode& child = children[c];
+        if (child.totalMass <= 0.0)
+            continue;
+
+        quadrupole[0] += child.cold->quadrupole[0];
+        quadrupole[1] += child.cold->quadrupole[1];
+        quadrupole[2] += child.cold->quadrupole[2];
+        AccumulateQuadrupole(quadrupole, child.totalMass, child.centerOfMass.x - centerOfMass.x, child.centerOfMass.y - centerOfMass.y);
+    }
 }
 
 
@@ -101,19 +278,28 @@ void QuadtreeNodePool::Reset()
 void QuadtreeNode::ComputeMassDistribution(const ParticleData& particles)
 {
     // Leaf node with particles in bucket
-    if (!nw && !ne && !sw && !se)
+    if (!children)
     {
-        if (particleCount > 0)
+        // A retained (persistent) leaf may have been emptied since last step
+        double* quadrupole = cold->quadrupole;
+        totalMass = 0.0;
+        quadrupole[0] = quadrupole[1] = quadrupole[2] = 0.0;
+
+        if (cold->particleCount > 0 || cold->overflow)
         {
             double massSum = 0.0;
             glm::dvec2 weightedPosition(0.0);
 
-            for (size_t k = 0; k < particleCount; ++k)
+            // Depth-capped leaves continue in their overflow buckets
+            for (const QuadtreeNode* bucket = this; bucket; bucket = bucket->cold->overflow)
             {
-                size_t idx = particleIndices[k];
-                double mass = particles.masses[idx];
-                massSum += mass;
-                weightedPosition += particles.positions[idx] * mass;
+                for (size_t k = 0; k < bucket->cold->particleCount; ++k)
+                {
+                    size_t idx = bucket->cold->particleIndices[k];
+                    double mass = particles.masses[idx];
+                    massSum += mass;
+                    weightedPosition += particles.positions[idx] * mass;
+                }
             }
 
             totalMass = massSum;
@@ -121,44 +307,27 @@ void QuadtreeNode::ComputeMassDistribution(const ParticleData& particles)
             {
                 centerOfMass = weightedPosition / massSum;
             }
+
+            for (const QuadtreeNode* bucket = this; bucket; bucket = bucket->cold->overflow)
+            {
+                for (size_t k = 0; k < bucket->cold->particleCount; ++k)
+                {
+                    size_t idx = bucket->cold->particleIndices[k];
+                    AccumulateQuadrupole(quadrupole, particles.masses[idx],
+                        particles.positions[idx].x - centerOfMass.x, particles.positions[idx].y - centerOfMass.y);
+                }
+            }
         }
         return;
     }
 
     // Otherwise, get total mass from all children nodes
-    double massSum = 0.0;
-    glm::dvec2 weightedPosition(0.0);
-
-    if (nw)
+    for (int c = 0; c < 4; ++c)
     {
-        nw->ComputeMassDistribution(particles);
-        massSum += nw->totalMass;
-        weightedPosition += nw->centerOfMass * nw->totalMass;
-    }
-    if (ne)
-    {
-        ne->ComputeMassDistribution(particles);
-        massSum += ne->totalMass;
-        weightedPosition += ne->centerOfMass * ne->totalMass;
-    }
-    if (sw)
-    {
-        sw->ComputeMassDistribution(particles);
-        massSum += sw->totalMass;
-        weightedPosition += sw->centerOfMass * sw->totalMass;
-    }
-    if (se)
-    {
-        se->ComputeMassDistribution(particles);
-        massSum += se->totalMass;
-        weightedPosition += se->centerOfMass * se->totalMass;
+        children[c].ComputeMassDistribution(particles);
     }
 
-    totalMass = massSum;
-    if (massSum > 0.0)
-    {
-        centerOfMass = weightedPosition / massSum;
-    }
+    CombineChildMass();
 }
 
 
@@ -172,22 +341,30 @@ void QuadtreeNode::ComputeMassDistribution(const ParticleData& particles)
 void QuadtreeNode::Insert(size_t particleIndex, const ParticleData& particles, QuadtreeNodePool& pool)
 {
     // If this is a leaf node and bucket has capacity, add to bucket
-    if (!nw && !ne && !sw && !se)
+    if (!children)
     {
-        if (particleCount < BUCKET_CAPACITY)
+        QuadtreeNodeCold& bucket = *cold;
+        if (bucket.particleCount < BUCKET_CAPACITY)
+        {
+            bucket.particleIndices[bucket.particleCount++] = (uint32_t)particleIndex;
+            return;
+        }
+
+        // Coincident particles would otherwise split the node until halfSize underflows
+        if (halfSize < MIN_NODE_HALF_SIZE)
         {
-            particleIndices[particleCount++] = particleIndex;
+            InsertOverflow(particleIndex, pool);
             return;
         }
 
         // Bucket is full — subdivide and redistribute existing particles
         Subdivide(pool);
 
-        for (size_t k = 0; k < particleCount; ++k)
+        for (size_t k = 0; k < bucket.particleCount; ++k)
         {
-            InsertIntoChild(particleIndices[k], particles, pool);
+            InsertIntoChild(bucket.particleIndices[k], particles, pool);
         }
-        particleCount = 0;
+        bucket.particleCount = 0;
     }
 
     // Insert the new particle into appropriate child
@@ -195,6 +372,30 @@ void QuadtreeNode::Insert(size_t particleIndex, const ParticleData& particles, Q
 }
 
 
+/**
+  * @brief  Add a particle to a depth-capped leaf, chaining a new bucket when the last one is full
+  * @param  particleIndex Index of particle in ParticleData
+  * @param  pool          Node pool for allocating the overflow bucket
+  * @retval None
+  * @note   Overflow buckets cover the same square and are never split, so any number of
+  *         coincident particles stays in the tree.
+  */
+void QuadtreeNode::InsertOverflow(size_t particleIndex, QuadtreeNodePool& pool)
+{
+    QuadtreeNode* bucket = this;
+    while (bucket->cold->particleCount == BUCKET_CAPACITY)
+    {
+        if (!bucket->cold->overflow)
+        {
+            bucket->cold->overflow = pool.Allocate(centerX, centerY, halfSize);
+        }
+        bucket = bucket->cold->overflow;
+    }
+
+    bucket->cold->particleIndices[bucket->cold->particleCount++] = (uint32_t)particleIndex;
+}
+
+
 /**
   * @brief  Insert a particle into a child node
   * @param  particleIndex Index of particle in ParticleData
@@ -207,10 +408,14 @@ void QuadtreeNode::InsertIntoChild(size_t particleIndex, const ParticleData& par
     double px = particles.positions[particleIndex].x;
     double py = particles.positions[particleIndex].y;
 
-    if      (nw->Contains(px, py)) { nw->Insert(particleIndex, particles, pool); }
-    else if (ne->Contains(px, py)) { ne->Insert(particleIndex, particles, pool); }
-    else if (sw->Contains(px, py)) { sw->Insert(particleIndex, particles, pool); }
-    else if (se->Contains(px, py)) { se->Insert(particleIndex, particles, pool); }
+    for (int c = 0; c < 4; ++c)
+    {
+        if (children[c].Contains(px, py))
+        {
+            children[c].Insert(particleIndex, particles, pool);
+            return;
+        }
+    }
 }
 
 
@@ -239,35 +444,34 @@ void QuadtreeNode::QueryRange(double xMin, double yMin, double xMax, double yMax
     }
 
     // If leaf node, return all particle indices in bucket
-    if (!nw && !ne && !sw && !se)
+    if (!children)
     {
-        for (size_t k = 0; k < particleCount; ++k)
+        for (const QuadtreeNode* bucket = this; bucket; bucket = bucket->cold->overflow)
         {
-            results.push_back(particleIndices[k]);
+            for (size_t k = 0; k < bucket->cold->particleCount; ++k)
+            {
+                results.push_back(bucket->cold->particleIndices[k]);
+            }
         }
         return;
     }
 
     // Otherwise, recursively search children
-    if (nw) nw->QueryRange(xMin, yMin, xMax, yMax, results);
-    if (ne) ne->QueryRange(xMin, yMin, xMax, yMax, results);
-    if (sw) sw->QueryRange(xMin, yMin, xMax, yMax, results);
-    if (se) se->QueryRange(xMin, yMin, xMax, yMax, results);
+    for (int c = 0; c < 4; ++c)
+    {
+        children[c].QueryRange(xMin, yMin, xMax, yMax, results);
+    }
 }
 
 
 /**
-  * @brief  Subdivide this node into four children (allocated from pool)
+  * @brief  Subdivide this node into four consecutive children (allocated from pool)
   * @param  pool  Node pool
   * @retval None
   */
 void QuadtreeNode::Subdivide(QuadtreeNodePool& pool)
 {
-    double quarterSize = halfSize / 2.0;
-    nw = pool.Allocate(centerX - quarterSize, centerY + quarterSize, quarterSize);
-    ne = pool.Allocate(centerX + quarterSize, centerY + quarterSize, quarterSize);
-    sw = pool.Allocate(centerX - quarterSize, centerY - quarterSize, quarterSize);
-    se = pool.Allocate(centerX + quarterSize, centerY - quarterSize, quarterSize);
+    children = pool.AllocateChildren(centerX, centerY, halfSize);
 }
 
 
@@ -285,85 +489,1750 @@ bool QuadtreeNode::Contains(double px, double py) const
 
 
 /**
-  * @brief  Compute forces between particles that share a node and use approximations for further away nodes
-  * @param  particleIndex Index of particle to compute force for
-  * @param  particles     Reference to particle data (SoA)
-  * @param  node          Quadtree node
-  * @param  theta         Barnes-Hut approximation threshold
-  * @retval glm::dvec2    Force vector
+  * @brief  PersistentQuadtree constructor
+  * @retval None
   */
-glm::dvec2 ComputeForceBarnesHut(size_t particleIndex, const ParticleData& particles, const QuadtreeNode* node, double theta)
+PersistentQuadtree::PersistentQuadtree()
 {
-    glm::dvec2 force(0.0);
+    root                   = nullptr;
+    layoutVersion          = 0;
+    migrationsSinceRebuild = 0;
+    rebuildCount           = 0;
+    refitCount             = 0;
+    nodesAtRebuild         = 0;
+}
 
-    // If this node is empty, no force
-    if (!node || node->totalMass <= 0.0)
-        return force;
 
-    // If leaf node with particles in bucket
-    if (!node->nw && !node->ne && !node->sw && !node->se)
+/**
+  * @brief  Adopt a freshly built tree and record which leaf holds each particle
+  * @param  root      Root of the new tree
+  * @param  particles Reference to particle data (SoA)
+  * @param  pool      Pool the tree was built in (its size bounds later refit growth)
+  * @retval None
+  */
+void PersistentQuadtree::Attach(QuadtreeNode* root, const ParticleData& particles, const QuadtreeNodePool& pool)
+{
+    this->root                   = root;
+    this->layoutVersion          = particles.layoutVersion;
+    this->migrationsSinceRebuild = 0;
+    this->nodesAtRebuild         = pool.nextIndex;
+    this->rebuildCount++;
+
+    // Particles left out by the builder keep nullptr
+    particleLeaves.assign(particles.Size(), nullptr);
+    RecordLeaves(root, particleLeaves);
+}
+
+
+/**
+  * @brief  Forget the retained tree so the next step rebuilds
+  * @retval None
+  */
+void PersistentQuadtree::Invalidate()
+{
+    root = nullptr;
+}
+
+
+/**
+  * @brief  Reuse last step's topology, moving only particles that left their leaf
+  * @param  particles Reference to particle data (SoA)
+  * @param  pool      Node pool the tree was built in (new nodes are appended)
+  * @retval bool      False if the caller must do a full rebuild instead
+  * @note   Mass distribution is not updated here. Every particle moves every step,
+  *         so the caller still refits all nodes bottom-up afterwards.
+  */
+bool PersistentQuadtree::Refit(const ParticleData& particles, QuadtreeNodePool& pool)
+{
+    size_t numParticles = particles.Size();
+
+    if (!root || particles.layoutVersion != layoutVersion || particleLeaves.size() != numParticles)
+        return false;
+
+    migrants.clear();
+    for (size_t i = 0; i < numParticles; ++i)
     {
-        // Compute direct force with each particle in the bucket
-        for (size_t k = 0; k < node->particleCount; ++k)
-        {
-            size_t idx = node->particleIndices[k];
+        const QuadtreeNode* leaf = particleLeaves[i];
+        const glm::dvec2&   p    = particles.positions[i];
 
-            // Skip if it's the same particle
-            if (idx == particleIndex)
-                continue;
+        // Open-domain outliers stay out of the tree while they stay outside the root
+        if (!leaf && !root->Contains(p.x, p.y))
+            continue;
+
+        if (!leaf || !root->Contains(p.x, p.y))
+            return false;
 
-            glm::dvec2 dir = particles.positions[idx] - particles.positions[particleIndex];
-            double dist2 = glm::dot(dir, dir);
-            if (dist2 < MIN_INTERACTION_DISTANCE * MIN_INTERACTION_DISTANCE)
-                dist2 = MIN_INTERACTION_DISTANCE * MIN_INTERACTION_DISTANCE;
+        if (!leaf->Contains(p.x, p.y))
+            migrants.push_back(i);
+    }
 
-            double softDist2 = dist2 + SOFTENING * SOFTENING;
-            double invDist = 1.0 / std::sqrt(softDist2);
+    // Too much churn (or too many nodes left behind by splits) — a fresh tree is cheaper and tighter
+    if (migrants.size() > numParticles * PERSISTENT_REBUILD_FRACTION ||
+        migrationsSinceRebuild + migrants.size() > numParticles * PERSISTENT_MAX_DRIFT ||
+        pool.nextIndex > nodesAtRebuild + (size_t)(nodesAtRebuild * PERSISTENT_MAX_POOL_GROWTH))
+        return false;
 
-            double f = GRAVITATIONAL_CONSTANT * particles.masses[particleIndex] * particles.masses[idx] * invDist * invDist;
-            force += f * glm::normalize(dir);
+    // Take every migrant out first so splitting a leaf never redistributes one of them
+    for (size_t idx : migrants)
+    {
+        // Swap-remove from the old leaf's bucket (or one of its overflow buckets)
+        bool isRemoved = false;
+        for (QuadtreeNode* bucket = particleLeaves[idx]; bucket && !isRemoved; bucket = bucket->cold->overflow)
+        {
+            for (size_t k = 0; k < bucket->cold->particleCount; ++k)
+            {
+                if (bucket->cold->particleIndices[k] == idx)
+                {
+                    bucket->cold->particleIndices[k] = bucket->cold->particleIndices[--bucket->cold->particleCount];
+                    isRemoved = true;
+                    break;
+                }
+            }
         }
-        return force;
     }
 
-    // Size of this region
-    double dx = node->centerOfMass.x - particles.positions[particleIndex].x;
-    double dy = node->centerOfMass.y - particles.positions[particleIndex].y;
-    double dist = std::sqrt(dx * dx + dy * dy);
+    for (size_t idx : migrants)
+    {
+        InsertTracked(root, idx, particles, pool, particleLeaves);
+    }
 
-    // If region is far away, treat as single mass
-    if ((node->halfSize * 2.0) / dist < theta)
+    migrationsSinceRebuild += migrants.size();
+    refitCount++;
+    return true;
+}
+
+
+/**
+  * @brief  Follow a ParticleData::Reorder without rebuilding the tree
+  * @param  order                 New-to-old index map passed to ParticleData::Reorder
+  * @param  previousLayoutVersion layoutVersion before the reorder
+  * @param  particles             Reference to particle data (SoA), already reordered
+  * @retval None
+  */
+void PersistentQuadtree::Remap(const std::vector<uint32_t>& order, size_t previousLayoutVersion, const ParticleData& particles)
+{
+    // Tree is already stale — it will be rebuilt anyway
+    if (!root || layoutVersion != previousLayoutVersion || particleLeaves.size() != order.size())
+        return;
+
+    newIndexOf.resize(order.size());
+    for (size_t i = 0; i < order.size(); ++i)
     {
-        // Use node's total mass
-        if (dist < MIN_INTERACTION_DISTANCE)
-            dist = MIN_INTERACTION_DISTANCE;
+        newIndexOf[order[i]] = (uint32_t)i;
+    }
 
-        double dist2 = dist * dist + SOFTENING * SOFTENING;
-        double invDist = 1.0 / std::sqrt(dist2);
+    RemapLeafIndices(root, newIndexOf);
 
-        double f = GRAVITATIONAL_CONSTANT * particles.masses[particleIndex] * node->totalMass * invDist * invDist;
-        glm::dvec2 dir = glm::normalize(glm::dvec2(dx, dy));
-        force += f * dir;
-        return force;
+    std::vector<QuadtreeNode*> permutedLeaves(order.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        permutedLeaves[i] = particleLeaves[order[i]];
     }
-    else
+    particleLeaves.swap(permutedLeaves);
+
+    layoutVersion = particles.layoutVersion;
+}
+
+
+/**
+  * @brief  Size an open-domain root square from the particles, leaving far outliers outside it
+  * @param  particles Reference to particle data (SoA)
+  * @param  policy    OutlierPolicy::Include sizes the root to cover every particle
+  * @param  bounds    Output root square and outliers (its block buffers are reused)
+  * @retval None
+  * @note   One parallel SIMD pass gives the bounding box and the mass moments. A second,
+  *         scalar pass runs only when the box reaches past OUTLIER_RADIUS_FACTOR RMS radii
+  *         from the center of mass, to list the outliers and measure everyone else.
+  */
+void ComputeDomainBounds(const ParticleData& particles, OutlierPolicy policy, DomainBounds& bounds)
+{
+    int numParticles = (int)particles.Size();
+    int numBlocks    = (numParticles + (int)DOMAIN_BOUNDS_BLOCK - 1) / (int)DOMAIN_BOUNDS_BLOCK;
+
+    bounds.outliers.clear();
+    bounds.blockMin.resize(numBlocks);
+    bounds.blockMax.resize(numBlocks);
+    bounds.blockMoments.resize(numBlocks);
+
+    #pragma omp parallel for schedule(static) if(numBlocks > 1)
+    for (int b = 0; b < numBlocks; ++b)
     {
-        // Otherwise, recurse into children
-        force += ComputeForceBarnesHut(particleIndex, particles, node->nw, theta);
-        force += ComputeForceBarnesHut(particleIndex, particles, node->ne, theta);
-        force += ComputeForceBarnesHut(particleIndex, particles, node->sw, theta);
-        force += ComputeForceBarnesHut(particleIndex, particles, node->se, theta);
+        size_t first = (size_t)b * DOMAIN_BOUNDS_BLOCK;
+        size_t count = std::min(DOMAIN_BOUNDS_BLOCK, (size_t)numParticles - first);
+        AccumulateBoundsSimd(&particles.positions[first], &particles.masses[first], count, bounds.blockMin[b], bounds.blockMax[b], bounds.blockMoments[b]);
     }
-    return force;
+
+    // Merge in block order so the result does not depend on the thread count
+    glm::dvec2 minP(HUGE_VAL);
+    glm::dvec2 maxP(-HUGE_VAL);
+    glm::dvec4 moments(0.0);
+
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        minP     = glm::min(minP, bounds.blockMin[b]);
+        maxP     = glm::max(maxP, bounds.blockMax[b]);
+        moments += bounds.blockMoments[b];
+    }
+
+    if (numParticles == 0)
+    {
+        minP = glm::dvec2(0.0);
+        maxP = glm::dvec2(0.0);
+    }
+
+    bounds.minP         = minP;
+    bounds.maxP         = maxP;
+    bounds.centerOfMass = (moments.x > 0.0) ? glm::dvec2(moments.y, moments.z) / moments.x : 0.5 * (minP + maxP);
+    bounds.rmsRadius    = (moments.x > 0.0) ? std::sqrt(std::max(0.0, moments.w / moments.x - glm::dot(bounds.centerOfMass, bounds.centerOfMass))) : 0.0;
+
+    glm::dvec2 coreMin = minP;
+    glm::dvec2 coreMax = maxP;
+
+    // Skip the second pass when even the farthest corner of the box is within the cutoff
+    double     cutoff = OUTLIER_RADIUS_FACTOR * bounds.rmsRadius;
+    glm::dvec2 reach  = glm::max(maxP - bounds.centerOfMass, bounds.centerOfMass - minP);
+
+    if (policy != OutlierPolicy::Include && glm::dot(reach, reach) > cutoff * cutoff)
+    {
+        coreMin = glm::dvec2(HUGE_VAL);
+        coreMax = glm::dvec2(-HUGE_VAL);
+
+        for (int i = 0; i < numParticles; ++i)
+        {
+            const glm::dvec2& p = particles.positions[i];
+            glm::dvec2 d = p - bounds.centerOfMass;
+
+            if (glm::dot(d, d) > cutoff * cutoff)
+            {
+                bounds.outliers.push_back((uint32_t)i);
+            }
+            else
+            {
+                coreMin = glm::min(coreMin, p);
+                coreMax = glm::max(coreMax, p);
+            }
+        }
+
+        // Too many to treat separately: this is a spread-out scene, not a runaway body
+        if (bounds.outliers.size() > OUTLIER_MAX_COUNT || bounds.outliers.size() == (size_t)numParticles)
+        {
+            bounds.outliers.clear();
+            coreMin = minP;
+            coreMax = maxP;
+        }
+    }
+
+    // Pad so particles on the max edge are inside (QuadtreeNode::Contains is half-open)
+    glm::dvec2 extent = coreMax - coreMin;
+    bounds.centerX  = 0.5 * (coreMin.x + coreMax.x);
+    bounds.centerY  = 0.5 * (coreMin.y + coreMax.y);
+    bounds.halfSize = std::max(0.5 * std::max(extent.x, extent.y) * (1.0 + DOMAIN_PADDING), PARTICLE_RADIUS);
+
+    // Outliers that fall inside the square (near its corners) go in the tree after all
+    glm::dvec2 rootMin(bounds.centerX - bounds.halfSize, bounds.centerY - bounds.halfSize);
+    glm::dvec2 rootMax(bounds.centerX + bounds.halfSize, bounds.centerY + bounds.halfSize);
+
+    bounds.outliers.erase(std::remove_if(bounds.outliers.begin(), bounds.outliers.end(), [&](uint32_t i)
+    {
+        const glm::dvec2& p = particles.positions[i];
+        return p.x >= rootMin.x && p.x < rootMax.x && p.y >= rootMin.y && p.y < rootMax.y;
+    }), bounds.outliers.end());
 }
 
 
+/**
+  * @brief  Compute Morton keys and leave particle indices sorted in pool.sortedIndices
+  * @param  particles Reference to particle data (SoA)
+  * @param  pool      Node pool holding the key/index buffers
+  * @param  centerX   Root center x coordinate
+  * @param  centerY   Root center y coordinate
+  * @param  halfSize  Root half-size
+  * @retval size_t    Number of particles outside the root (sorted into the edge cells)
+  */
+size_t ComputeMortonOrder(const ParticleData& particles, QuadtreeNodePool& pool, double centerX, double centerY, double halfSize)
+{
+    size_t numParticles = particles.Size();
 
-/******************************************************************************/
-/******************************************************************************/
-/* Private Functions                                                          */
-/******************************************************************************/
-/******************************************************************************/
+    pool.mortonKeys.resize(numParticles);
+    pool.mortonKeysTemp.resize(numParticles);
+    pool.sortedIndices.resize(numParticles);
+    pool.sortedIndicesTemp.resize(numParticles);
+
+    size_t outside = ComputeMortonKeys(particles, pool, 0, numParticles, centerX, centerY, halfSize);
+    RadixSortMortonKeys(pool, numParticles);
+    return outside;
+}
+
+
+/**
+  * @brief  Build a quadtree by inserting particles one at a time from the root
+  * @param  particles Reference to particle data (SoA)
+  * @param  pool      Node pool (must already be reset)
+  * @param  centerX   Root center x coordinate
+  * @param  centerY   Root center y coordinate
+  * @param  halfSize  Root half-size
+  * @retval Pointer to root node
+  * @note   Particles outside the root are left out of the tree
+  */
+QuadtreeNode* BuildQuadtreeRecursive(const ParticleData& particles, QuadtreeNodePool& pool, double centerX, double centerY, double halfSize)
+{
+    QuadtreeNode* root = pool.Allocate(centerX, centerY, halfSize);
+    size_t numParticles = particles.Size();
+
+    for (size_t i = 0; i < numParticles; ++i)
+    {
+        const glm::dvec2& p = particles.positions[i];
+        if (root->Contains(p.x, p.y))
+            root->Insert(i, particles, pool);
+    }
+
+    return root;
+}
+
+
+/**
+  * @brief  Build a quadtree from radix-sorted Morton keys (linear build)
+  * @param  particles Reference to particle data (SoA)
+  * @param  pool      Node pool (must already be reset)
+  * @param  centerX   Root center x coordinate
+  * @param  centerY   Root center y coordinate
+  * @param  halfSize  Root half-size
+  * @retval Pointer to root node
+  * @note   Produces the same topology and leaf bucket order as BuildQuadtreeRecursive,
+  *         so mass distribution and Barnes-Hut forces match. Cells below MORTON_BITS
+  *         levels fall back to recursive insertion.
+  */
+QuadtreeNode* BuildQuadtreeMorton(const ParticleData& particles, QuadtreeNodePool& pool, double centerX, double centerY, double halfSize)
+{
+    size_t numParticles = particles.Size();
+    size_t outside = ComputeMortonOrder(particles, pool, centerX, centerY, halfSize);
+
+    QuadtreeNode* root = pool.Allocate(centerX, centerY, halfSize);
+
+    if (outside > 0)
+        numParticles = DropOutsideRoot(root, particles, pool, numParticles);
+
+    BuildMortonRange(root, 0, numParticles, 0, particles, pool, nullptr);
+
+    return root;
+}
+
+
+/**
+  * @brief  Multi-threaded Morton build
+  * @param  particles Reference to particle data (SoA)
+  * @param  pool      Node pool (must already be reset)
+  * @param  centerX   Root center x coordinate
+  * @param  centerY   Root center y coordinate
+  * @param  halfSize  Root half-size
+  * @retval Pointer to root node
+  * @note   Keys and the radix sort are split across threads, the levels above
+  *         PARALLEL_SPLIT_LEVEL are emitted serially and every subtree below it
+  *         is built by a worker allocating from its own pool slice. The result
+  *         matches BuildQuadtreeMorton apart from where nodes sit in the pool.
+  */
+QuadtreeNode* BuildQuadtreeMortonParallel(const ParticleData& particles, QuadtreeNodePool& pool, double centerX, double centerY, double halfSize)
+{
+    int numParticles = (int)particles.Size();
+
+    pool.mortonKeys.resize(numParticles);
+    pool.mortonKeysTemp.resize(numParticles);
+    pool.sortedIndices.resize(numParticles);
+    pool.sortedIndicesTemp.resize(numParticles);
+
+    constexpr int KEY_BLOCK = 4096;
+    int numBlocks = (numParticles + KEY_BLOCK - 1) / KEY_BLOCK;
+    int outside = 0;
+
+    #pragma omp parallel for schedule(static) reduction(+:outside)
+    for (int b = 0; b < numBlocks; ++b)
+    {
+        size_t first = (size_t)b * KEY_BLOCK;
+        size_t last  = std::min(first + KEY_BLOCK, (size_t)numParticles);
+        outside += (int)ComputeMortonKeys(particles, pool, first, last, centerX, centerY, halfSize);
+    }
+
+    RadixSortMortonKeysParallel(pool, numParticles);
+
+    QuadtreeNode* root = pool.Allocate(centerX, centerY, halfSize);
+
+    if (outside > 0)
+        numParticles = (int)DropOutsideRoot(root, particles, pool, numParticles);
+
+    pool.mortonTasks.clear();
+    BuildMortonRange(root, 0, numParticles, 0, particles, pool, &pool.mortonTasks);
+
+    int numTasks = (int)pool.mortonTasks.size();
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int t = 0; t < numTasks; ++t)
+    {
+        const MortonTask& task = pool.mortonTasks[t];
+        BuildMortonRange(task.node, task.first, task.last, PARALLEL_SPLIT_LEVEL, particles, pool, nullptr);
+    }
+
+    return root;
+}
+
+
+/**
+  * @brief  Compute mass distribution with the subtrees below PARALLEL_SPLIT_LEVEL in parallel
+  * @param  root      Root node
+  * @param  particles Reference to particle data (SoA)
+  * @param  pool      Node pool (provides the reusable work list)
+  * @retval None
+  * @note   Sums are taken in the same order as ComputeMassDistribution, so results are identical
+  */
+void ComputeMassDistributionParallel(QuadtreeNode* root, const ParticleData& particles, QuadtreeNodePool& pool)
+{
+    pool.subtreeRoots.clear();
+    CollectSubtreeRoots(root, 0, pool.subtreeRoots);
+
+    int numRoots = (int)pool.subtreeRoots.size();
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (int r = 0; r < numRoots; ++r)
+    {
+        pool.subtreeRoots[r]->ComputeMassDistribution(particles);
+    }
+
+    CombineTopLevelMass(root, 0);
+}
+
+
+/**
+  * @brief  OpeningTest constructor for the classic geometric criterion
+  * @param  theta Barnes-Hut approximation threshold
+  * @retval None
+  */
+OpeningTest::OpeningTest(double theta)
+{
+    this->criterion  = OpeningCriterion::Geometric;
+    this->theta      = theta;
+    this->tolerance  = FORCE_TOLERANCE;
+    this->errorBound = 0.0;
+}
+
+
+/**
+  * @brief  OpeningTest constructor
+  * @param  criterion Multipole acceptance criterion
+  * @param  theta     Geometric / MinDistance threshold
+  * @param  tolerance SalmonWarren / RelativeForce error fraction
+  * @retval None
+  */
+OpeningTest::OpeningTest(OpeningCriterion criterion, double theta, double tolerance)
+{
+    this->criterion  = criterion;
+    this->theta      = theta;
+    this->tolerance  = tolerance;
+    this->errorBound = 0.0;
+}
+
+
+/**
+  * @brief  Derive per-frame parameters from the tree (call after its mass distribution is computed)
+  * @param  root
+  * @retval None
+  * @note   SalmonWarren allows each node an absolute error of tolerance times the field of
+  *         the whole system seen from one domain width away, G M / (2 halfSize)^2.
+  */
+void OpeningTest::Prepare(const QuadtreeNode* root)
+{
+    this->errorBound = 0.0;
+
+    if (root && root->totalMass > 0.0)
+    {
+        double width = root->halfSize * 2.0;
+        this->errorBound = this->tolerance * root->totalMass / (width * width);
+    }
+}
+
+
+/**
+  * @brief  Compute forces between particles that share a node and use approximations for further away nodes
+  * @param  particleIndex Index of particle to compute force for
+  * @param  particles     Reference to particle data (SoA)
+  * @param  node          Quadtree node
+  * @param  test          Opening criterion deciding which nodes are approximated
+  * @param  order         Far-field expansion applied to accepted nodes
+  * @param  interactions  Optional counter, incremented once per accepted node or particle pair
+  * @param  precision     Arithmetic of the leaf particle terms (accepted nodes are always double)
+  * @retval glm::dvec2    Force vector
+  */
+glm::dvec2 ComputeForceBarnesHut(size_t particleIndex, const ParticleData& particles, const QuadtreeNode* node, const OpeningTest& test, MultipoleOrder order, size_t* interactions, ForcePrecision precision)
+{
+    glm::dvec2 force(0.0);
+
+    // If this node is empty, no force
+    if (!node || node->totalMass <= 0.0)
+        return force;
+
+    // If leaf node with particles in bucket
+    if (!node->children)
+    {
+        // Gather each bucket into SoA form for the SIMD kernel (the particle itself contributes nothing)
+        double bodyX[BUCKET_CAPACITY];
+        double bodyY[BUCKET_CAPACITY];
+        double bodyMass[BUCKET_CAPACITY];
+        const glm::dvec2& position = particles.positions[particleIndex];
+        glm::dvec2 acceleration(0.0);
+        size_t count = 0;
+        size_t self = 0;
+
+        for (const QuadtreeNode* bucket = node; bucket; bucket = bucket->cold->overflow)
+        {
+            for (size_t k = 0; k < bucket->cold->particleCount; ++k)
+            {
+                size_t idx = bucket->cold->particleIndices[k];
+                bodyX[k]    = particles.positions[idx].x;
+                bodyY[k]    = particles.positions[idx].y;
+                bodyMass[k] = particles.masses[idx];
+                self += (idx == particleIndex);
+            }
+
+            acceleration += LeafAcceleration(position.x, position.y, bodyX, bodyY, bodyMass, bucket->cold->particleCount, node->centerX, node->centerY, precision);
+            count += bucket->cold->particleCount;
+        }
+
+        force = particles.masses[particleIndex] * acceleration;
+
+        if (interactions)
+            *interactions += count - self;
+        return force;
+    }
+
+    // Size of this region
+    const glm::dvec2& position = particles.positions[particleIndex];
+    double dx = node->centerOfMass.x - position.x;
+    double dy = node->centerOfMass.y - position.y;
+    double dist = std::sqrt(dx * dx + dy * dy);
+    double lastAcceleration = (test.criterion == OpeningCriterion::RelativeForce) ? glm::length(particles.accelerations[particleIndex]) : 0.0;
+
+    // If region is far away, treat as single mass
+    if (AcceptNode(test, position.x, position.y, position.x, position.y, dist, node->centerOfMass, glm::dvec2(node->centerX, node->centerY),
+                   node->halfSize, node->totalMass, node->cold->quadrupole, lastAcceleration))
+    {
+        // Use node's total mass
+        if (dist < MIN_INTERACTION_DISTANCE)
+            dist = MIN_INTERACTION_DISTANCE;
+
+        double dist2 = dist * dist + SOFTENING * SOFTENING;
+        double invDist = 1.0 / std::sqrt(dist2);
+
+        double f = GRAVITATIONAL_CONSTANT * particles.masses[particleIndex] * node->totalMass * invDist * invDist;
+        glm::dvec2 dir = glm::normalize(glm::dvec2(dx, dy));
+        force += f * dir;
+
+        if (order == MultipoleOrder::Quadrupole)
+        {
+            force += particles.masses[particleIndex] * QuadrupoleAcceleration(node->cold->quadrupole, -dx, -dy, dist2);
+        }
+
+        if (interactions)
+            ++*interactions;
+        return force;
+    }
+    else
+    {
+        // Otherwise, recurse into children
+        for (int c = 0; c < 4; ++c)
+        {
+            force += ComputeForceBarnesHut(particleIndex, particles, &node->children[c], test, order, interactions, precision);
+        }
+    }
+    return force;
+}
+
+
+/**
+  * @brief  Copy the non-empty nodes into depth-first order with skip indices
+  * @param  root      Root of a tree whose mass distribution has been computed
+  * @param  particles Reference to particle data (SoA)
+  * @retval bool      False if the tree is deeper than FLAT_TREE_MAX_DEPTH
+  */
+bool FlatQuadtree::Build(const QuadtreeNode* root, const ParticleData& particles)
+{
+    nodes.clear();
+    quadrupoles.clear();
+    centers.clear();
+    bodyX.clear();
+    bodyY.clear();
+    bodyMass.clear();
+    bodyIndex.clear();
+
+    if (!root || root->totalMass <= 0.0)
+        return true;
+
+    return FlattenSubtree(root, 0, particles, *this);
+}
+
+
+/**
+  * @brief  Same as ComputeForceBarnesHut, walked as one loop over a flattened tree
+  * @param  particleIndex Index of particle to compute force for
+  * @param  particles     Reference to particle data (SoA)
+  * @param  tree          Compact tree produced by FlatQuadtree::Build
+  * @param  test          Opening criterion deciding which nodes are approximated
+  * @param  order         Far-field expansion applied to accepted nodes
+  * @param  interactions  Optional counter, incremented once per accepted node or particle pair
+  * @param  precision     Arithmetic of the leaf particle terms (accepted nodes are always double)
+  * @retval glm::dvec2    Force vector (bit-identical to ComputeForceBarnesHut at the same precision)
+  * @note   An accepted node or leaf continues at its skip index, an opened node at the next
+  *         index. partial[d] holds the running sum for the open node at depth d - 1 and is
+  *         folded into its parent once the walk leaves that subtree, which repeats the
+  *         recursive version's additions in the same order.
+  */
+glm::dvec2 ComputeForceBarnesHutStackless(size_t particleIndex, const ParticleData& particles, const FlatQuadtree& tree, const OpeningTest& test, MultipoleOrder order, size_t* interactions, ForcePrecision precision)
+{
+    glm::dvec2 partial[FLAT_TREE_MAX_DEPTH + 1];
+    partial[0] = glm::dvec2(0.0);
+
+    const FlatQuadtreeNode* nodes = tree.nodes.data();
+    const double*   bodyX     = tree.bodyX.data();
+    const double*   bodyY     = tree.bodyY.data();
+    const double*   bodyMass  = tree.bodyMass.data();
+    const uint32_t* bodyIndex = tree.bodyIndex.data();
+
+    uint32_t numNodes = (uint32_t)tree.nodes.size();
+    const glm::dvec2 position = particles.positions[particleIndex];
+    const double mass = particles.masses[particleIndex];
+    const double lastAcceleration = (test.criterion == OpeningCriterion::RelativeForce) ? glm::length(particles.accelerations[particleIndex]) : 0.0;
+    size_t count = 0;
+    int openDepth = -1;
+    uint32_t i = 0;
+
+    while (i < numNodes)
+    {
+        const FlatQuadtreeNode& node = nodes[i];
+        int depth = node.depth;
+
+        // Leaving finished subtrees
+        for (; openDepth >= depth; --openDepth)
+        {
+            partial[openDepth] += partial[openDepth + 1];
+        }
+
+        if (node.bodyCount > 0)
+        {
+            // Same kernel and operand order as the recursive walk's leaf branch
+            uint32_t first = node.firstBody;
+            glm::dvec2 force = mass * LeafAcceleration(position.x, position.y, bodyX + first, bodyY + first, bodyMass + first, node.bodyCount,
+                                                       tree.centers[i].x, tree.centers[i].y, precision);
+
+            count += node.bodyCount;
+            for (uint32_t b = first; b < first + node.bodyCount; ++b)
+            {
+                count -= (bodyIndex[b] == particleIndex);
+            }
+
+            partial[depth] += force;
+            i = node.skip;
+            continue;
+        }
+
+        double dx = node.centerOfMass.x - position.x;
+        double dy = node.centerOfMass.y - position.y;
+        double dist = std::sqrt(dx * dx + dy * dy);
+
+        if (AcceptNode(test, position.x, position.y, position.x, position.y, dist, node.centerOfMass, tree.centers[i],
+                       node.halfSize, node.totalMass, &tree.quadrupoles[3 * (size_t)i], lastAcceleration))
+        {
+            if (dist < MIN_INTERACTION_DISTANCE)
+                dist = MIN_INTERACTION_DISTANCE;
+
+            double dist2 = dist * dist + SOFTENING * SOFTENING;
+            double invDist = 1.0 / std::sqrt(dist2);
+
+            glm::dvec2 force(0.0);
+            double f = GRAVITATIONAL_CONSTANT * mass * node.totalMass * invDist * invDist;
+            glm::dvec2 dir = glm::normalize(glm::dvec2(dx, dy));
+            force += f * dir;
+
+            if (order == MultipoleOrder::Quadrupole)
+            {
+                force += mass * QuadrupoleAcceleration(&tree.quadrupoles[3 * (size_t)i], -dx, -dy, dist2);
+            }
+
+            partial[depth] += force;
+            ++count;
+            i = node.skip;
+            continue;
+        }
+
+        // Open the node: its children follow it directly
+        partial[depth + 1] = glm::dvec2(0.0);
+        openDepth = depth;
+        ++i;
+    }
+
+    for (; openDepth >= 0; --openDepth)
+    {
+        partial[openDepth] += partial[openDepth + 1];
+    }
+
+    if (interactions)
+        *interactions += count;
+
+    return partial[0];
+}
+
+
+/**
+  * @brief  Clear all entries (capacity is kept for reuse)
+  * @param  None
+  * @retval None
+  */
+void InteractionList::Clear()
+{
+    nodeX.clear();
+    nodeY.clear();
+    nodeMass.clear();
+    nodeQxx.clear();
+    nodeQxy.clear();
+    nodeQyy.clear();
+    bodyX.clear();
+    bodyY.clear();
+    bodyMass.clear();
+    bodyIndex.clear();
+    nodeOffsetX.clear();
+    nodeOffsetY.clear();
+    nodeGm.clear();
+    bodyOffsetX.clear();
+    bodyOffsetY.clear();
+    bodyGm.clear();
+}
+
+
+/**
+  * @brief  Barnes-Hut accelerations using one tree walk per group of nearby particles
+  * @param  particles Reference to particle data (SoA), accelerations are overwritten
+  * @param  root      Root of a tree whose mass distribution has been computed
+  * @param  test         Opening criterion deciding which nodes are approximated
+  * @param  pool         Node pool (holds the reusable group list)
+  * @param  order        Far-field expansion applied to accepted nodes
+  * @param  interactions Optional counter, incremented once per accepted node or particle pair of each member
+  * @param  precision    Mixed evaluates node and particle terms in float32 on offsets from the group's node center
+  * @param  activeMask   Optional per-particle flags; only flagged particles get new accelerations (block timesteps)
+  * @retval None
+  * @note   A node is accepted for a group only if it passes the opening test against the
+  *         nearest point of the group's bounding box (and the smallest last acceleration of
+  *         its members), so every member would also accept it on its own walk. Groups
+  *         therefore open at least as many nodes as ComputeForceBarnesHut.
+  */
+void ComputeAccelerationsGrouped(ParticleData& particles, const QuadtreeNode* root, const OpeningTest& test, QuadtreeNodePool& pool, MultipoleOrder order, size_t* interactions, ForcePrecision precision, const uint8_t* activeMask)
+{
+    std::vector<const QuadtreeNode*>& groups = pool.forceGroups;
+    groups.clear();
+
+    if (!root)
+        return;
+
+    if (CollectForceGroups(root, groups) <= FORCE_GROUP_SIZE)
+    {
+        groups.push_back(root);
+    }
+
+    int numGroups = (int)groups.size();
+    size_t totalInteractions = 0;
+
+    #pragma omp parallel reduction(+:totalInteractions) if(particles.Size() > 1000)
+    {
+        InteractionList     list;
+        std::vector<size_t> members;
+        members.reserve(FORCE_GROUP_SIZE);
+
+        #pragma omp for schedule(dynamic, 4)
+        for (int g = 0; g < numGroups; ++g)
+        {
+            members.clear();
+            CollectGroupMembers(groups[g], members);
+
+            // Block timesteps: inactive members keep their accelerations (the box shrinks to the active ones)
+            if (activeMask)
+            {
+                members.erase(std::remove_if(members.begin(), members.end(), [&](size_t i) { return !activeMask[i]; }), members.end());
+            }
+
+            if (members.empty())
+                continue;
+
+            // Tight bounding box of the group's particles
+            double xMin = particles.positions[members[0]].x, xMax = xMin;
+            double yMin = particles.positions[members[0]].y, yMax = yMin;
+            double lastAcceleration = glm::length(particles.accelerations[members[0]]);
+            for (size_t i : members)
+            {
+                xMin = std::min(xMin, particles.positions[i].x);
+                yMin = std::min(yMin, particles.positions[i].y);
+                xMax = std::max(xMax, particles.positions[i].x);
+                yMax = std::max(yMax, particles.positions[i].y);
+                lastAcceleration = std::min(lastAcceleration, glm::length(particles.accelerations[i]));
+            }
+
+            // Mixed: offsets from the group's node center are small, so float32 keeps their relative accuracy
+            glm::dvec2 origin(groups[g]->centerX, groups[g]->centerY);
+            bool isMixed = (precision == ForcePrecision::Mixed);
+
+            list.Clear();
+            BuildInteractionList(root, xMin, yMin, xMax, yMax, test, lastAcceleration, particles, precision, origin, list);
+
+            const double* nodeX    = list.nodeX.data();
+            const double* nodeY    = list.nodeY.data();
+            const double* nodeMass = list.nodeMass.data();
+            const double* nodeQxx  = list.nodeQxx.data();
+            const double* nodeQxy  = list.nodeQxy.data();
+            const double* nodeQyy  = list.nodeQyy.data();
+            const double* bodyX    = list.bodyX.data();
+            const double* bodyY    = list.bodyY.data();
+            const double* bodyMass = list.bodyMass.data();
+            const size_t* bodyIdx  = list.bodyIndex.data();
+            size_t numNodes  = list.nodeQxx.size();
+            size_t numBodies = list.bodyIndex.size();
+
+            if (isMixed)
+            {
+                // Massless padding to whole vectors, so short lists skip the scalar tail
+                size_t paddedNodes  = (numNodes + FORCE_SIMD_WIDTH_MIXED - 1) / FORCE_SIMD_WIDTH_MIXED * FORCE_SIMD_WIDTH_MIXED;
+                size_t paddedBodies = (numBodies + FORCE_SIMD_WIDTH_MIXED - 1) / FORCE_SIMD_WIDTH_MIXED * FORCE_SIMD_WIDTH_MIXED;
+                list.nodeOffsetX.resize(paddedNodes, 0.0f);
+                list.nodeOffsetY.resize(paddedNodes, 0.0f);
+                list.nodeGm.resize(paddedNodes, 0.0f);
+                list.bodyOffsetX.resize(paddedBodies, 0.0f);
+                list.bodyOffsetY.resize(paddedBodies, 0.0f);
+                list.bodyGm.resize(paddedBodies, 0.0f);
+            }
+
+            for (size_t i : members)
+            {
+                double px = particles.positions[i].x;
+                double py = particles.positions[i].y;
+                float  offsetX = (float)(px - origin.x);
+                float  offsetY = (float)(py - origin.y);
+
+                // Accepted nodes act as point masses, same SIMD kernel as the particles of opened leaves
+                glm::dvec2 acceleration = isMixed ? AccumulateAccelerationMixed(offsetX, offsetY, list.nodeOffsetX.data(), list.nodeOffsetY.data(), list.nodeGm.data(), list.nodeGm.size())
+                                                  : AccumulateAccelerationSimd(px, py, nodeX, nodeY, nodeMass, numNodes);
+                double ax = acceleration.x;
+                double ay = acceleration.y;
+
+                // Quadrupole correction of accepted nodes (r points from the node to the particle), always in double
+                if (order == MultipoleOrder::Quadrupole)
+                {
+                    for (size_t k = 0; k < numNodes; ++k)
+                    {
+                        double rx = isMixed ? (double)offsetX - list.nodeOffsetX[k] : px - nodeX[k];
+                        double ry = isMixed ? (double)offsetY - list.nodeOffsetY[k] : py - nodeY[k];
+                        double clamped = std::max(std::sqrt(rx * rx + ry * ry), MIN_INTERACTION_DISTANCE);
+                        double soft2 = clamped * clamped + SOFTENING * SOFTENING;
+                        double inv5 = 1.0 / (soft2 * soft2 * std::sqrt(soft2));
+                        double qrx = nodeQxx[k] * rx + nodeQxy[k] * ry;
+                        double qry = nodeQxy[k] * rx + nodeQyy[k] * ry;
+                        double rqr = (rx * qrx + ry * qry) * 2.5 / soft2;
+                        ax += GRAVITATIONAL_CONSTANT * inv5 * (qrx - rqr * rx);
+                        ay += GRAVITATIONAL_CONSTANT * inv5 * (qry - rqr * ry);
+                    }
+                }
+
+                // Particles from opened leaves (the member itself contributes nothing)
+                acceleration = isMixed ? AccumulateAccelerationMixed(offsetX, offsetY, list.bodyOffsetX.data(), list.bodyOffsetY.data(), list.bodyGm.data(), list.bodyGm.size())
+                                       : AccumulateAccelerationSimd(px, py, bodyX, bodyY, bodyMass, numBodies);
+                particles.accelerations[i] = glm::dvec2(ax + acceleration.x, ay + acceleration.y);
+
+                if (interactions)
+                {
+                    size_t self = 0;
+                    for (size_t k = 0; k < numBodies; ++k)
+                    {
+                        self += (bodyIdx[k] == i);
+                    }
+                    totalInteractions += numNodes + numBodies - self;
+                }
+            }
+        }
+    }
+
+    if (interactions)
+        *interactions += totalInteractions;
+}
+
+
+/**
+  * @brief  Split the tree into groups of at most FORCE_GROUP_SIZE particles
+  * @param  node    Current node
+  * @param  groups  Receives the root node of each group
+  * @retval size_t  Number of particles below node
+  * @note   A subtree small enough to be a group is left for its parent to emit, so each
+  *         group is the largest subtree that still fits. The caller emits the root if it fits.
+  *         A depth-capped leaf whose overflow chain holds more than FORCE_GROUP_SIZE cannot
+  *         be split, so it is emitted here as one oversized group (neither its parent nor
+  *         the caller would emit it, the count being too large).
+  */
+size_t CollectForceGroups(const QuadtreeNode* node, std::vector<const QuadtreeNode*>& groups)
+{
+    if (!node)
+        return 0;
+
+    if (!node->children)
+    {
+        size_t count = 0;
+        for (const QuadtreeNode* bucket = node; bucket; bucket = bucket->cold->overflow)
+        {
+            count += bucket->cold->particleCount;
+        }
+
+        if (count > FORCE_GROUP_SIZE)
+            groups.push_back(node);
+
+        return count;
+    }
+
+    const QuadtreeNode* children = node->children;
+    size_t counts[4];
+    size_t total = 0;
+
+    for (int c = 0; c < 4; ++c)
+    {
+        counts[c] = CollectForceGroups(&children[c], groups);
+        total += counts[c];
+    }
+
+    if (total > FORCE_GROUP_SIZE)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            if (counts[c] > 0 && counts[c] <= FORCE_GROUP_SIZE)
+                groups.push_back(&children[c]);
+        }
+    }
+
+    return total;
+}
+
+
+/**
+  * @brief  Gather the particle indices stored below a node
+  * @param  node
+  * @param  members
+  * @retval None
+  */
+void CollectGroupMembers(const QuadtreeNode* node, std::vector<size_t>& members)
+{
+    if (!node->children)
+    {
+        for (const QuadtreeNode* bucket = node; bucket; bucket = bucket->cold->overflow)
+        {
+            members.insert(members.end(), bucket->cold->particleIndices, bucket->cold->particleIndices + bucket->cold->particleCount);
+        }
+        return;
+    }
+
+    for (int c = 0; c < 4; ++c)
+    {
+        CollectGroupMembers(&node->children[c], members);
+    }
+}
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Private Functions                                                          */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  Index of the calling OpenMP thread (0 when OpenMP is disabled)
+  * @param  None
+  * @retval int
+  */
+static int CurrentThread()
+{
+#ifdef _OPENMP
+    int thread = omp_get_thread_num();
+    assert(thread < POOL_MAX_THREADS && "Too many threads for QuadtreeNodePool — increase POOL_MAX_THREADS");
+    return thread;
+#else
+    return 0;
+#endif
+}
+
+
+/**
+  * @brief  Add a point mass to a traceless quadrupole (3D form restricted to the plane)
+  * @param  quadrupole  Tensor to accumulate into (xx, xy, yy)
+  * @param  mass
+  * @param  dx          Offset from the expansion center
+  * @param  dy
+  * @retval None
+  */
+static void AccumulateQuadrupole(double quadrupole[3], double mass, double dx, double dy)
+{
+    quadrupole[0] += mass * (2.0 * dx * dx - dy * dy);
+    quadrupole[1] += mass * 3.0 * dx * dy;
+    quadrupole[2] += mass * (2.0 * dy * dy - dx * dx);
+}
+
+
+/**
+  * @brief  Acceleration due to a node's quadrupole moment
+  * @param  quadrupole  Node quadrupole (xx, xy, yy)
+  * @param  rx          Vector from the node's center of mass to the particle
+  * @param  ry
+  * @param  soft2       Softened squared distance (same as the monopole term)
+  * @retval glm::dvec2
+  * @note   a = G * (Q r / s^5 - 5/2 (r.Q.r) r / s^7)
+  */
+static glm::dvec2 QuadrupoleAcceleration(const double quadrupole[3], double rx, double ry, double soft2)
+{
+    double inv5 = 1.0 / (soft2 * soft2 * std::sqrt(soft2));
+    double qrx = quadrupole[0] * rx + quadrupole[1] * ry;
+    double qry = quadrupole[1] * rx + quadrupole[2] * ry;
+    double rqr = (rx * qrx + ry * qry) * 2.5 / soft2;
+
+    return GRAVITATIONAL_CONSTANT * inv5 * glm::dvec2(qrx - rqr * rx, qry - rqr * ry);
+}
+
+
+/**
+  * @brief  Spread the low 16 bits of a value so a zero bit sits between each bit
+  * @param  v
+  * @retval uint32_t
+  */
+static uint32_t ExpandBits16(uint32_t v)
+{
+    v &= 0x0000FFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+
+/**
+  * @brief  Map a coordinate onto the Morton grid, clamping to the root bounds
+  * @param  p       Coordinate
+  * @param  minP    Lower root bound on this axis
+  * @param  width   Root width
+  * @retval uint32_t Cell coordinate in [0, 2^MORTON_BITS)
+  * @note   Divides by the width (rather than multiplying by its inverse) so cell
+  *         edges land exactly where QuadtreeNode::Contains puts them
+  */
+static uint32_t QuantizeAxis(double p, double minP, double width)
+{
+    constexpr double GRID_SIZE = (double)(1u << MORTON_BITS);
+
+    double t = (p - minP) / width * GRID_SIZE;
+
+    if (t <= 0.0)        return 0;
+    if (t >= GRID_SIZE)  return (1u << MORTON_BITS) - 1;
+    return (uint32_t)t;
+}
+
+
+/**
+  * @brief  Compute Morton keys and identity indices for a range of particles
+  * @param  particles Reference to particle data (SoA)
+  * @param  pool      Node pool holding the key/index buffers
+  * @param  first     First particle index
+  * @param  last      One past the last particle index
+  * @param  centerX   Root center x coordinate
+  * @param  centerY   Root center y coordinate
+  * @param  halfSize  Root half-size
+  * @retval size_t    Number of particles outside the root (same test as QuadtreeNode::Contains)
+  */
+static size_t ComputeMortonKeys(const ParticleData& particles, QuadtreeNodePool& pool, size_t first, size_t last, double centerX, double centerY, double halfSize)
+{
+    double minX  = centerX - halfSize;
+    double minY  = centerY - halfSize;
+    double maxX  = centerX + halfSize;
+    double maxY  = centerY + halfSize;
+    double width = halfSize * 2.0;
+    size_t outside = 0;
+
+    for (size_t i = first; i < last; ++i)
+    {
+        const glm::dvec2& p = particles.positions[i];
+        uint32_t qx = QuantizeAxis(p.x, minX, width);
+        uint32_t qy = QuantizeAxis(p.y, minY, width);
+
+        pool.mortonKeys[i]    = (ExpandBits16(qy) << 1) | ExpandBits16(qx);
+        pool.sortedIndices[i] = (uint32_t)i;
+        outside += !(p.x >= minX && p.x < maxX && p.y >= minY && p.y < maxY);
+    }
+
+    return outside;
+}
+
+
+/**
+  * @brief  Remove particles outside the root from the sorted key/index buffers
+  * @param  root      Root node
+  * @param  particles Reference to particle data (SoA)
+  * @param  pool      Node pool holding the sorted key/index buffers
+  * @param  count     Number of sorted keys
+  * @retval size_t    Number of keys left (order of the rest is kept)
+  * @note   QuantizeAxis clamps them into the edge cells, where they would end up
+  *         in leaves that do not contain them. BuildQuadtreeRecursive skips them too.
+  */
+static size_t DropOutsideRoot(const QuadtreeNode* root, const ParticleData& particles, QuadtreeNodePool& pool, size_t count)
+{
+    uint32_t* keys    = pool.mortonKeys.data();
+    uint32_t* indices = pool.sortedIndices.data();
+    size_t    kept    = 0;
+
+    for (size_t k = 0; k < count; ++k)
+    {
+        const glm::dvec2& p = particles.positions[indices[k]];
+        if (root->Contains(p.x, p.y))
+        {
+            keys[kept]    = keys[k];
+            indices[kept] = indices[k];
+            ++kept;
+        }
+    }
+
+    return kept;
+}
+
+
+/**
+  * @brief  Stable LSD radix sort of pool.mortonKeys, carrying pool.sortedIndices along
+  * @param  pool    Node pool holding the key/index buffers
+  * @param  count   Number of keys
+  * @retval None
+  */
+static void RadixSortMortonKeys(QuadtreeNodePool& pool, size_t count)
+{
+    uint32_t* keys       = pool.mortonKeys.data();
+    uint32_t* keysTemp   = pool.mortonKeysTemp.data();
+    uint32_t* values     = pool.sortedIndices.data();
+    uint32_t* valuesTemp = pool.sortedIndicesTemp.data();
+
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        size_t histogram[256] = { 0 };
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            histogram[(keys[i] >> shift) & 0xFF]++;
+        }
+
+        // Skip passes where every key has the same digit
+        if (histogram[(keys[0] >> shift) & 0xFF] == count)
+            continue;
+
+        size_t offset = 0;
+        for (size_t b = 0; b < 256; ++b)
+        {
+            size_t n = histogram[b];
+            histogram[b] = offset;
+            offset += n;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            size_t dst = histogram[(keys[i] >> shift) & 0xFF]++;
+            keysTemp[dst]   = keys[i];
+            valuesTemp[dst] = values[i];
+        }
+
+        std::swap(keys, keysTemp);
+        std::swap(values, valuesTemp);
+    }
+
+    // An odd number of passes leaves the result in the temp buffers
+    if (keys != pool.mortonKeys.data())
+    {
+        pool.mortonKeys.swap(pool.mortonKeysTemp);
+        pool.sortedIndices.swap(pool.sortedIndicesTemp);
+    }
+}
+
+
+/**
+  * @brief  Multi-threaded version of RadixSortMortonKeys
+  * @param  pool    Node pool holding the key/index buffers
+  * @param  count   Number of keys
+  * @retval None
+  * @note   Each thread histograms and scatters its own block of keys. Offsets are
+  *         laid out digit-major, thread-minor, so the sort stays stable.
+  */
+static void RadixSortMortonKeysParallel(QuadtreeNodePool& pool, size_t count)
+{
+#ifdef _OPENMP
+    int maxThreads = omp_get_max_threads();
+    pool.radixHistograms.resize((size_t)maxThreads * 256);
+
+    uint32_t* keys       = pool.mortonKeys.data();
+    uint32_t* keysTemp   = pool.mortonKeysTemp.data();
+    uint32_t* values     = pool.sortedIndices.data();
+    uint32_t* valuesTemp = pool.sortedIndicesTemp.data();
+    size_t*   histograms = pool.radixHistograms.data();
+
+    for (int shift = 0; shift < 32; shift += 8)
+    {
+        bool skipPass = false;
+
+        #pragma omp parallel num_threads(maxThreads)
+        {
+            int    thread     = omp_get_thread_num();
+            int    numThreads = omp_get_num_threads();
+            size_t first      = count * thread / numThreads;
+            size_t last       = count * (thread + 1) / numThreads;
+            size_t* histogram = histograms + (size_t)thread * 256;
+
+            std::fill(histogram, histogram + 256, 0);
+            for (size_t i = first; i < last; ++i)
+            {
+                histogram[(keys[i] >> shift) & 0xFF]++;
+            }
+
+            #pragma omp barrier
+
+            #pragma omp single
+            {
+                // Skip passes where every key has the same digit
+                size_t digit = (keys[0] >> shift) & 0xFF;
+                size_t sameDigit = 0;
+                for (int t = 0; t < numThreads; ++t)
+                {
+                    sameDigit += histograms[(size_t)t * 256 + digit];
+                }
+                skipPass = (sameDigit == count);
+
+                size_t offset = 0;
+                for (size_t b = 0; b < 256; ++b)
+                {
+                    for (int t = 0; t < numThreads; ++t)
+                    {
+                        size_t n = histograms[(size_t)t * 256 + b];
+                        histograms[(size_t)t * 256 + b] = offset;
+                        offset += n;
+                    }
+                }
+            }
+
+            if (!skipPass)
+            {
+                for (size_t i = first; i < last; ++i)
+                {
+                    size_t dst = histogram[(keys[i] >> shift) & 0xFF]++;
+                    keysTemp[dst]   = keys[i];
+                    valuesTemp[dst] = values[i];
+                }
+            }
+        }
+
+        if (!skipPass)
+        {
+            std::swap(keys, keysTemp);
+            std::swap(values, valuesTemp);
+        }
+    }
+
+    // An odd number of passes leaves the result in the temp buffers
+    if (keys != pool.mortonKeys.data())
+    {
+        pool.mortonKeys.swap(pool.mortonKeysTemp);
+        pool.sortedIndices.swap(pool.sortedIndicesTemp);
+    }
+#else
+    RadixSortMortonKeys(pool, count);
+#endif
+}
+
+
+/**
+  * @brief  Emit the subtree for a contiguous range of sorted Morton keys
+  * @param  node      Node covering the range
+  * @param  first     First sorted index in range
+  * @param  last      One past the last sorted index in range
+  * @param  level     Tree depth of node
+  * @param  particles Reference to particle data (SoA)
+  * @param  pool      Node pool
+  * @param  deferred  When set, subtrees at PARALLEL_SPLIT_LEVEL are queued here instead of built
+  * @retval None
+  */
+static void BuildMortonRange(QuadtreeNode* node, size_t first, size_t last, int level, const ParticleData& particles, QuadtreeNodePool& pool, std::vector<MortonTask>* deferred)
+{
+    const uint32_t* keys    = pool.mortonKeys.data();
+    const uint32_t* indices = pool.sortedIndices.data();
+    size_t count = last - first;
+
+    if (deferred && level == PARALLEL_SPLIT_LEVEL)
+    {
+        deferred->push_back({ node, first, last });
+        return;
+    }
+
+    if (count <= BUCKET_CAPACITY)
+    {
+        // Leaf — keep ascending particle order to match recursive insertion
+        for (size_t k = 0; k < count; ++k)
+        {
+            size_t idx = indices[first + k];
+            size_t pos = k;
+            while (pos > 0 && node->cold->particleIndices[pos - 1] > idx)
+            {
+                node->cold->particleIndices[pos] = node->cold->particleIndices[pos - 1];
+                --pos;
+            }
+            node->cold->particleIndices[pos] = (uint32_t)idx;
+        }
+        node->cold->particleCount = (uint32_t)count;
+        return;
+    }
+
+    if (level >= MORTON_BITS)
+    {
+        // Keys cannot separate these particles any further
+        for (size_t k = first; k < last; ++k)
+        {
+            node->Insert(indices[k], particles, pool);
+        }
+        return;
+    }
+
+    node->Subdivide(pool);
+
+    // Morton digit at this level: bit 1 = upper half (y), bit 0 = right half (x)
+    // Children are stored nw, ne, sw, se, so digit d is child d ^ 2
+    int shift = 2 * (MORTON_BITS - 1 - level);
+
+    size_t begin = first;
+    for (uint32_t digit = 0; digit < 4; ++digit)
+    {
+        // Keys in this range share their prefix, so the digit is sorted too
+        size_t end = std::partition_point(keys + begin, keys + last,
+            [shift, digit](uint32_t key) { return ((key >> shift) & 0x3) <= digit; }) - keys;
+
+        if (end > begin)
+        {
+            BuildMortonRange(&node->children[digit ^ 2], begin, end, level + 1, particles, pool, deferred);
+        }
+        begin = end;
+    }
+}
+
+
+/**
+  * @brief  Gather the nodes at PARALLEL_SPLIT_LEVEL (and any shallower leaves)
+  * @param  node    Current node
+  * @param  level   Tree depth of node
+  * @param  roots   Output list of subtree roots
+  * @retval None
+  */
+static void CollectSubtreeRoots(QuadtreeNode* node, int level, std::vector<QuadtreeNode*>& roots)
+{
+    if (level == PARALLEL_SPLIT_LEVEL || !node->children)
+    {
+        roots.push_back(node);
+        return;
+    }
+
+    for (int c = 0; c < 4; ++c)
+    {
+        CollectSubtreeRoots(&node->children[c], level + 1, roots);
+    }
+}
+
+
+/**
+  * @brief  Combine mass for the nodes above the subtree roots
+  * @param  node    Current node
+  * @param  level   Tree depth of node
+  * @retval None
+  */
+static void CombineTopLevelMass(QuadtreeNode* node, int level)
+{
+    if (level == PARALLEL_SPLIT_LEVEL || !node->children)
+        return;
+
+    for (int c = 0; c < 4; ++c)
+    {
+        CombineTopLevelMass(&node->children[c], level + 1);
+    }
+
+    node->CombineChildMass();
+}
+
+
+/**
+  * @brief  Record the leaf holding each particle in the subtree
+  * @param  node            Current node
+  * @param  particleLeaves  Leaf pointer per particle index
+  * @retval None
+  */
+static void RecordLeaves(QuadtreeNode* node, std::vector<QuadtreeNode*>& particleLeaves)
+{
+    if (!node->children)
+    {
+        for (const QuadtreeNode* bucket = node; bucket; bucket = bucket->cold->overflow)
+        {
+            for (size_t k = 0; k < bucket->cold->particleCount; ++k)
+            {
+                particleLeaves[bucket->cold->particleIndices[k]] = node;
+            }
+        }
+        return;
+    }
+
+    for (int c = 0; c < 4; ++c)
+    {
+        RecordLeaves(&node->children[c], particleLeaves);
+    }
+}
+
+
+/**
+  * @brief  Rewrite the particle indices stored in every leaf bucket
+  * @param  node        Current node
+  * @param  newIndexOf  Old-to-new index map
+  * @retval None
+  */
+static void RemapLeafIndices(QuadtreeNode* node, const std::vector<uint32_t>& newIndexOf)
+{
+    if (!node->children)
+    {
+        for (QuadtreeNode* bucket = node; bucket; bucket = bucket->cold->overflow)
+        {
+            for (size_t k = 0; k < bucket->cold->particleCount; ++k)
+            {
+                bucket->cold->particleIndices[k] = newIndexOf[bucket->cold->particleIndices[k]];
+            }
+        }
+        return;
+    }
+
+    for (int c = 0; c < 4; ++c)
+    {
+        RemapLeafIndices(&node->children[c], newIndexOf);
+    }
+}
+
+
+/**
+  * @brief  Insert a particle like QuadtreeNode::Insert, keeping particleLeaves up to date
+  * @param  node            Node to insert from (must contain the particle)
+  * @param  particleIndex   Index of particle in ParticleData
+  * @param  particles       Reference to particle data (SoA)
+  * @param  pool            Node pool for allocating child nodes
+  * @param  particleLeaves  Leaf pointer per particle index
+  * @retval None
+  */
+static void InsertTracked(QuadtreeNode* node, size_t particleIndex, const ParticleData& particles, QuadtreeNodePool& pool, std::vector<QuadtreeNode*>& particleLeaves)
+{
+    double px = particles.positions[particleIndex].x;
+    double py = particles.positions[particleIndex].y;
+
+    // Walk down to the leaf containing the particle
+    while (node->children)
+    {
+        int c = 0;
+        while (c < 4 && !node->children[c].Contains(px, py))
+            ++c;
+
+        if (c == 4)
+        {
+            particleLeaves[particleIndex] = nullptr;
+            return;
+        }
+        node = &node->children[c];
+    }
+
+    if (node->cold->particleCount < BUCKET_CAPACITY)
+    {
+        node->cold->particleIndices[node->cold->particleCount++] = (uint32_t)particleIndex;
+        particleLeaves[particleIndex] = node;
+        return;
+    }
+
+    // Same limit as QuadtreeNode::Insert (the head leaf is recorded, the particle may sit in an overflow bucket)
+    if (node->halfSize < MIN_NODE_HALF_SIZE)
+    {
+        node->InsertOverflow(particleIndex, pool);
+        particleLeaves[particleIndex] = node;
+        return;
+    }
+
+    // Bucket is full — subdivide and redistribute existing particles
+    node->Subdivide(pool);
+
+    size_t count = node->cold->particleCount;
+    node->cold->particleCount = 0;
+
+    for (size_t k = 0; k < count; ++k)
+    {
+        InsertTracked(node, node->cold->particleIndices[k], particles, pool, particleLeaves);
+    }
+
+    InsertTracked(node, particleIndex, particles, pool, particleLeaves);
+}
+
+
+/**
+  * @brief  Walk the tree once for a group and record what every member interacts with
+  * @param  node      Current node
+  * @param  xMin      Group bounding box
+  * @param  yMin
+  * @param  xMax
+  * @param  yMax
+  * @param  test      Opening criterion
+  * @param  lastAcceleration Smallest acceleration magnitude of the group's particles at the previous step
+  * @param  particles Reference to particle data (SoA)
+  * @param  precision Mixed fills the float offset arrays (relative to origin) instead of the double positions
+  * @param  origin    Reference point of the float offsets
+  * @param  list      Interaction list to append to
+  * @retval None
+  */
+static void BuildInteractionList(const QuadtreeNode* node, double xMin, double yMin, double xMax, double yMax, const OpeningTest& test, double lastAcceleration, const ParticleData& particles, ForcePrecision precision, const glm::dvec2& origin, InteractionList& list)
+{
+    if (!node || node->totalMass <= 0.0)
+        return;
+
+    // Leaves are always evaluated directly, as in ComputeForceBarnesHut
+    if (!node->children)
+    {
+        for (const QuadtreeNode* bucket = node; bucket; bucket = bucket->cold->overflow)
+        {
+            for (size_t k = 0; k < bucket->cold->particleCount; ++k)
+            {
+                size_t idx = bucket->cold->particleIndices[k];
+                if (precision == ForcePrecision::Mixed)
+                {
+                    list.bodyOffsetX.push_back((float)(particles.positions[idx].x - origin.x));
+                    list.bodyOffsetY.push_back((float)(particles.positions[idx].y - origin.y));
+                    list.bodyGm.push_back((float)(GRAVITATIONAL_CONSTANT * particles.masses[idx]));
+                }
+                else
+                {
+                    list.bodyX.push_back(particles.positions[idx].x);
+                    list.bodyY.push_back(particles.positions[idx].y);
+                    list.bodyMass.push_back(particles.masses[idx]);
+                }
+                list.bodyIndex.push_back(idx);
+            }
+        }
+        return;
+    }
+
+    // Distance from the center of mass to the nearest point of the group's box
+    double dx = std::max(0.0, std::max(xMin - node->centerOfMass.x, node->centerOfMass.x - xMax));
+    double dy = std::max(0.0, std::max(yMin - node->centerOfMass.y, node->centerOfMass.y - yMax));
+    double minDist = std::sqrt(dx * dx + dy * dy);
+
+    if (AcceptNode(test, xMin, yMin, xMax, yMax, minDist, node->centerOfMass, glm::dvec2(node->centerX, node->centerY),
+                   node->halfSize, node->totalMass, node->cold->quadrupole, lastAcceleration))
+    {
+        if (precision == ForcePrecision::Mixed)
+        {
+            list.nodeOffsetX.push_back((float)(node->centerOfMass.x - origin.x));
+            list.nodeOffsetY.push_back((float)(node->centerOfMass.y - origin.y));
+            list.nodeGm.push_back((float)(GRAVITATIONAL_CONSTANT * node->totalMass));
+        }
+        else
+        {
+            list.nodeX.push_back(node->centerOfMass.x);
+            list.nodeY.push_back(node->centerOfMass.y);
+            list.nodeMass.push_back(node->totalMass);
+        }
+        list.nodeQxx.push_back(node->cold->quadrupole[0]);
+        list.nodeQxy.push_back(node->cold->quadrupole[1]);
+        list.nodeQyy.push_back(node->cold->quadrupole[2]);
+        return;
+    }
+
+    for (int c = 0; c < 4; ++c)
+    {
+        BuildInteractionList(&node->children[c], xMin, yMin, xMax, yMax, test, lastAcceleration, particles, precision, origin, list);
+    }
+}
+
+
+/**
+  * @brief  Acceleration from the particles of one leaf (the target itself contributes nothing)
+  * @param  px        Target position
+  * @param  py
+  * @param  x         Leaf particle positions and masses (SoA)
+  * @param  y
+  * @param  mass
+  * @param  count     Number of leaf particles (more than BUCKET_CAPACITY for a leaf with overflow buckets)
+  * @param  centerX   Geometric center of the leaf, reference point for ForcePrecision::Mixed
+  * @param  centerY
+  * @param  precision Arithmetic of the pair terms
+  * @retval glm::dvec2
+  */
+static glm::dvec2 LeafAcceleration(double px, double py, const double* x, const double* y, const double* mass, size_t count, double centerX, double centerY, ForcePrecision precision)
+{
+    if (precision == ForcePrecision::Double)
+        return AccumulateAccelerationSimd(px, py, x, y, mass, count);
+
+    // Bucket padded with massless entries to whole float vectors, one bucket at a time
+    constexpr size_t padded = (BUCKET_CAPACITY + FORCE_SIMD_WIDTH_MIXED - 1) / FORCE_SIMD_WIDTH_MIXED * FORCE_SIMD_WIDTH_MIXED;
+    glm::dvec2 acceleration(0.0);
+
+    for (size_t first = 0; first < count; first += BUCKET_CAPACITY)
+    {
+        size_t chunk = std::min(count - first, BUCKET_CAPACITY);
+        float offsetX[padded] = {};
+        float offsetY[padded] = {};
+        float gm[padded]      = {};
+
+        for (size_t k = 0; k < chunk; ++k)
+        {
+            offsetX[k] = (float)(x[first + k] - centerX);
+            offsetY[k] = (float)(y[first + k] - centerY);
+            gm[k]      = (float)(GRAVITATIONAL_CONSTANT * mass[first + k]);
+        }
+
+        size_t used = (chunk + FORCE_SIMD_WIDTH_MIXED - 1) / FORCE_SIMD_WIDTH_MIXED * FORCE_SIMD_WIDTH_MIXED;
+        acceleration += AccumulateAccelerationMixed((float)(px - centerX), (float)(py - centerY), offsetX, offsetY, gm, used);
+    }
+
+    return acceleration;
+}
+
+
+/**
+  * @brief  Multipole acceptance test for one node seen from a target box (a point for single particles)
+  * @param  test             Criterion and parameters
+  * @param  xMin             Target box
+  * @param  yMin
+  * @param  xMax
+  * @param  yMax
+  * @param  dist             Distance from the node's center of mass to the nearest point of the target
+  * @param  centerOfMass     Node center of mass
+  * @param  center           Node geometric center
+  * @param  halfSize         Node half-size
+  * @param  totalMass        Node mass
+  * @param  quadrupole       Node quadrupole (its trace is the second moment sum m |x - com|^2)
+  * @param  lastAcceleration Target acceleration magnitude at the previous step (RelativeForce only)
+  * @retval bool             True if the node may be replaced by its multipole
+  * @note   SalmonWarren accepts beyond bmax/2 + sqrt(bmax^2/4 + sqrt(3 B2 / errorBound)), with bmax
+  *         the distance from the center of mass to the farthest corner of the box. RelativeForce
+  *         (Gadget) accepts when G M / d^2 (size / d)^2 <= tolerance * |a_old| and the target lies
+  *         outside the box grown by 20%. Both fall back to Geometric until their inputs exist
+  *         (before Prepare, or while a particle has no previous acceleration).
+  */
+static bool AcceptNode(const OpeningTest& test, double xMin, double yMin, double xMax, double yMax, double dist, const glm::dvec2& centerOfMass, const glm::dvec2& center, double halfSize, double totalMass, const double quadrupole[3], double lastAcceleration)
+{
+    double size = halfSize * 2.0;
+
+    switch (test.criterion)
+    {
+        case OpeningCriterion::MinDistance:
+        {
+            // Gap between the node's box and the target box
+            double gapX = std::max(0.0, std::max(xMin - (center.x + halfSize), (center.x - halfSize) - xMax));
+            double gapY = std::max(0.0, std::max(yMin - (center.y + halfSize), (center.y - halfSize) - yMax));
+            return size < test.theta * std::sqrt(gapX * gapX + gapY * gapY);
+        }
+
+        case OpeningCriterion::SalmonWarren:
+        {
+            if (test.errorBound <= 0.0)
+                break;
+
+            double bx = halfSize + std::abs(centerOfMass.x - center.x);
+            double by = halfSize + std::abs(centerOfMass.y - center.y);
+            double bmax2 = bx * bx + by * by;
+            double secondMoment = quadrupole[0] + quadrupole[2];
+            double critical = 0.5 * std::sqrt(bmax2) + std::sqrt(0.25 * bmax2 + std::sqrt(3.0 * secondMoment / test.errorBound));
+            return dist > critical;
+        }
+
+        case OpeningCriterion::RelativeForce:
+        {
+            if (lastAcceleration <= 0.0)
+                break;
+
+            double reach = halfSize * 1.2;
+            if (xMax > center.x - reach && xMin < center.x + reach &&
+                yMax > center.y - reach && yMin < center.y + reach)
+                return false;
+
+            double dist2 = dist * dist;
+            return GRAVITATIONAL_CONSTANT * totalMass * size * size <= test.tolerance * lastAcceleration * dist2 * dist2;
+        }
+
+        default:
+            break;
+    }
+
+    return size / dist < test.theta;
+}
+
+
+/**
+  * @brief  Append a subtree to the flattened tree in depth-first order
+  * @param  node      Current (non-empty) node
+  * @param  depth     Tree depth of node
+  * @param  particles Reference to particle data (SoA)
+  * @param  tree      Output
+  * @retval bool      False if the subtree is deeper than FLAT_TREE_MAX_DEPTH
+  */
+static bool FlattenSubtree(const QuadtreeNode* node, int depth, const ParticleData& particles, FlatQuadtree& tree)
+{
+    if (depth >= FLAT_TREE_MAX_DEPTH)
+        return false;
+
+    size_t index = tree.nodes.size();
+    bool isLeaf = !node->children;
+    size_t bodyCount = 0;
+
+    for (const QuadtreeNode* bucket = node; isLeaf && bucket; bucket = bucket->cold->overflow)
+    {
+        bodyCount += bucket->cold->particleCount;
+    }
+
+    if (bodyCount > UINT16_MAX)
+        return false;
+
+    FlatQuadtreeNode flat;
+    flat.centerOfMass = node->centerOfMass;
+    flat.totalMass    = node->totalMass;
+    flat.halfSize     = node->halfSize;
+    flat.skip         = 0;
+    flat.firstBody    = (uint32_t)tree.bodyIndex.size();
+    flat.bodyCount    = (uint16_t)bodyCount;
+    flat.depth        = (uint16_t)depth;
+    flat.pad          = 0;
+    tree.nodes.push_back(flat);
+    tree.quadrupoles.insert(tree.quadrupoles.end(), node->cold->quadrupole, node->cold->quadrupole + 3);
+    tree.centers.push_back(glm::dvec2(node->centerX, node->centerY));
+
+    if (isLeaf)
+    {
+        // Leaf particles are copied next to each other, in bucket order (overflow buckets follow)
+        for (const QuadtreeNode* bucket = node; bucket; bucket = bucket->cold->overflow)
+        {
+            for (size_t k = 0; k < bucket->cold->particleCount; ++k)
+            {
+                uint32_t idx = bucket->cold->particleIndices[k];
+                tree.bodyX.push_back(particles.positions[idx].x);
+                tree.bodyY.push_back(particles.positions[idx].y);
+                tree.bodyMass.push_back(particles.masses[idx]);
+                tree.bodyIndex.push_back(idx);
+            }
+        }
+    }
+    else
+    {
+        // Empty children contribute nothing to the recursive walk, so they are left out
+        for (int c = 0; c < 4; ++c)
+        {
+            const QuadtreeNode* child = &node->children[c];
+            if (child->totalMass > 0.0 && !FlattenSubtree(child, depth + 1, particles, tree))
+                return false;
+        }
+    }
+
+    tree.nodes[index].skip = (uint32_t)tree.nodes.size();
+    return true;
+}
 
 
 
@@ -17,8 +17,16 @@
 #include "PCH.hpp"
 
 #include "Simulation.hpp"
+#include "BlockTimeStep.hpp"
+#include "CollisionGrid.hpp"
+#include "DirectSum.hpp"
+#include "Fmm.hpp"
+#include "ForceAudit.hpp"
+#include "Accretion.hpp"
 #include "Particle.hpp"
 #include "Quadtree.hpp"
+#include "SweptCollision.hpp"
+#include "TreePm.hpp"
 #include "VectorMath.hpp"
 
 /* Global variables --------------------------------------------------------- */
@@ -28,6 +36,8 @@
 /* Private variables -------------------------------------------------------- */
 /* Private function prototypes ---------------------------------------------- */
 
+static void ClampToViewport(glm::dvec2& position, glm::dvec2& velocity);
+
 
 
 /******************************************************************************/
@@ -56,7 +66,51 @@ Simulation::Simulation(Engine* engine, SimulationTemplate simulationTemplate)
     this->simulationTime      = 0.0;
     this->timeStep            = TIME_STEP;
     this->totalMass           = 0.0;
-    this->nodePool             = new QuadtreeNodePool();
+    this->treeBuildMode       = TreeBuildMode::Morton;
+    this->forceWalkMode       = ForceWalkMode::PerParticle;
+    this->integrator          = Integrator::SymplecticEuler;
+    this->collisionBroadphase = CollisionBroadphase::Grid;
+    this->multipoleOrder      = MultipoleOrder::Monopole;
+    this->forcePrecision      = ForcePrecision::Double;
+    this->gravitySolver       = GravitySolver::BarnesHut;
+    this->fmmOrder            = FMM_DEFAULT_ORDER;
+    this->treePmMeshSize      = TREEPM_DEFAULT_MESH;
+    this->openingCriterion    = OpeningCriterion::Geometric;
+    this->theta               = THETA;
+    this->forceTolerance      = FORCE_TOLERANCE;
+    this->averageInteractions = 0.0;
+    this->isPersistentTree    = false;
+    this->isDirectSummation   = false;
+    this->isBlockTimeStep     = false;
+    this->isParallelCollisions = false;
+    this->isAccelerationCurrent = false;
+    this->isOpenDomain        = !ENABLE_BOUNDING_BOX;
+    this->outlierPolicy       = OutlierPolicy::Track;
+    this->reorderInterval     = REORDER_INTERVAL;
+    this->framesSinceReorder  = 0;
+    this->forceAuditInterval  = 0;
+    this->framesSinceAudit    = 0;
+    this->conservationInterval    = 0;
+    this->framesSinceConservation = 0;
+    this->conservation            = ConservationReport();
+    this->nodePool            = new QuadtreeNodePool();
+    this->persistentTree      = new PersistentQuadtree();
+    this->fmmSolver           = new FmmSolver();
+    this->treePmSolver        = new TreePmSolver();
+    this->directSolver        = new DirectSolver();
+    this->forceAudit          = new ForceAudit();
+    this->blockStepper        = new BlockTimeStepper();
+    this->collisionGrid       = new CollisionGrid();
+    this->contacts            = new ContactBuffer();
+    this->contactCount        = 0;
+    this->neighborListSkin    = 0.0;
+    this->isSweptCollision    = false;
+    this->sweptSpeedThreshold = SWEPT_SPEED_THRESHOLD;
+    this->sweptSolver         = new SweptCollisionSolver();
+    this->isMergeMode         = false;
+    this->mergeMassRatio      = MERGE_MASS_RATIO;
+    this->mergeRelativeSpeed  = MERGE_RELATIVE_SPEED;
+    this->accretionSolver     = new AccretionSolver();
 }
 
 
@@ -67,6 +121,16 @@ Simulation::Simulation(Engine* engine, SimulationTemplate simulationTemplate)
 Simulation::~Simulation()
 {
     delete this->nodePool;
+    delete this->persistentTree;
+    delete this->fmmSolver;
+    delete this->treePmSolver;
+    delete this->directSolver;
+    delete this->forceAudit;
+    delete this->blockStepper;
+    delete this->collisionGrid;
+    delete this->contacts;
+    delete this->sweptSolver;
+    delete this->accretionSolver;
 }
 
 
@@ -165,6 +229,7 @@ void Simulation::AddParticle(glm::dvec2 position)
 
     if (this->GetParticleCount() < this->GetMaxParticleCount())
     {
+        this->isAccelerationCurrent = false;
         this->particleData->AddParticle(
             this->newParticleMass,
             glm::dvec2(x, y),
@@ -200,6 +265,7 @@ void Simulation::AddParticles(glm::dvec2 position)
 
         if (this->GetParticleCount() < this->GetMaxParticleCount())
         {
+            this->isAccelerationCurrent = false;
             this->particleData->AddParticle(
                 this->newParticleMass,
                 particlePos,
@@ -217,6 +283,7 @@ void Simulation::AddParticles(glm::dvec2 position)
   */
 void Simulation::RemoveAllParticles()
 {
+    this->isAccelerationCurrent = false;
     this->particleData->Clear();
 }
 
@@ -239,6 +306,7 @@ void Simulation::RemoveParticle(glm::dvec2 position)
 
         if (distance < (this->particleBrushSize * PARTICLE_RADIUS / 2))
         {
+            this->isAccelerationCurrent = false;
             this->particleData->RemoveParticle(i);
         }
     }
@@ -254,6 +322,8 @@ void Simulation::Update()
     this->simulationTime += this->GetTimeStep();
 
     this->UpdateParticles();
+
+    this->UpdateConservationReport();
 }
 
 
@@ -267,111 +337,40 @@ void Simulation::UpdateParticles()
     this->totalMass = 0;
 
     ParticleData& particles = *particleData;
-    size_t numParticles = particles.Size();
-
-    if (numParticles == 0) return;
-
-    // Use fixed bounding box since ENABLE_BOUNDING_BOX clamps particles to viewport [-1, 1]
-    // No need to scan particles - simpler and faster
-    double centerX = 0.0;
-    double centerY = 0.0;
-    double halfSize = 1.0;
 
-    // Reset pool and build quadtree (O(1) reset, no heap alloc per node)
-    nodePool->Reset();
-    QuadtreeNode* root = nodePool->Allocate(centerX, centerY, halfSize + 1e-3);
-    for (size_t i = 0; i < numParticles; ++i)
+    // Coalesce touching bodies first, so the whole frame runs on the smaller N
+    if (this->isMergeMode && this->accretionSolver->Merge(particles, this->mergeMassRatio, this->mergeRelativeSpeed) > 0)
     {
-        root->Insert(i, particles, *nodePool);
+        this->isAccelerationCurrent = false;
     }
 
-    root->ComputeMassDistribution(particles);
+    size_t numParticles = particles.Size();
 
-    // Update center of mass for color visualization
-    Particle::SetCenterOfMass(root->centerOfMass);
+    if (numParticles == 0) return;
 
-    // Parallel force computation using OpenMP
-    // Compute forces using Barnes-Hut, accumulate in each particle
-    #pragma omp parallel for schedule(dynamic, 64) if(numParticles > 1000)
-    for (int i = 0; i < (int)numParticles; ++i)
+    // Audit frames count here, not per force pass (Yoshida computes gravity three times a frame)
+    if (this->forceAuditInterval > 0 && this->framesSinceAudit < this->forceAuditInterval)
     {
-        // Reset acceleration for this time step
-        particles.accelerations[i] = glm::dvec2(0.0);
-
-        glm::dvec2 bhForce = ComputeForceBarnesHut(i, particles, root, THETA);
-        // a = F / m
-        particles.accelerations[i] = bhForce / particles.masses[i];
+        ++this->framesSinceAudit;
     }
 
-    // Pre-allocate reusable vector for collision detection (optimization)
-    std::vector<size_t> neighborsReusable;
-    neighborsReusable.reserve(32);
-
-    // Handle bounding box constraints and collision detection
-    for (size_t i = 0; i < numParticles; i++)
+    if (this->isBlockTimeStep)
     {
-        // Bounding box to keep particles in view
-        if (ENABLE_BOUNDING_BOX)
-        {
-            glm::dvec2& position = particles.positions[i];
-            glm::dvec2& velocity = particles.velocities[i];
-
-            for (int axis = 0; axis < 2; axis++)
-            {
-                if (std::abs(position[axis]) > 1.0)
-                {
-                    // Clamp position
-                    position[axis] = glm::sign(position[axis]) * 1.0;
-                    // Invert (dampen) velocity along that axis
-                    velocity[axis] *= -0.9;
-                }
-            }
-        }
-
-        const glm::dvec2& posI = particles.positions[i];
-
-        // Query a bounding box that roughly covers possible collisions.
-        double range = 2.0 * PARTICLE_RADIUS;
-        double xMin = posI.x - range;
-        double xMax = posI.x + range;
-        double yMin = posI.y - range;
-        double yMax = posI.y + range;
-
-        neighborsReusable.clear();
-        root->QueryRange(xMin, yMin, xMax, yMax, neighborsReusable);
-
-        // Check collisions only with these neighbors
-        for (size_t j : neighborsReusable)
-        {
-            if (j == i)
-                continue; // skip self
-
-            glm::dvec2 direction = particles.positions[j] - particles.positions[i];
-            double distance = glm::length(direction);
-            if (distance < 2.0 * PARTICLE_RADIUS)
-            {
-                glm::dvec2 collisionNormal = glm::normalize(direction);
-                glm::dvec2 relativeVelocity = particles.velocities[j] - particles.velocities[i];
-                double separatingVelocity = glm::dot(relativeVelocity, collisionNormal);
+        this->UpdateParticlesBlockStep();
+        return;
+    }
 
-                if (separatingVelocity < 0)
-                {
-                    double impulse = -(1 + COLLISION_DAMPING) * separatingVelocity /
-                        ((1 / particles.masses[i]) + (1 / particles.masses[j]));
+    if (this->integrator != Integrator::SymplecticEuler)
+    {
+        this->UpdateParticlesSplit();
+        return;
+    }
 
-                    particles.velocities[i] -= (impulse / particles.masses[i]) * collisionNormal * REPULSION_FACTOR;
-                    particles.velocities[j] += (impulse / particles.masses[j]) * collisionNormal * REPULSION_FACTOR;
+    QuadtreeNode* root = this->PrepareQuadtree(true);
 
-                    // Separate overlapping particles
-                    double overlap = 2 * PARTICLE_RADIUS - distance;
-                    glm::dvec2 separationVector = overlap * 0.5 * collisionNormal;
+    this->ComputeGravity(root, nullptr, nullptr);
 
-                    particles.positions[i] -= separationVector;
-                    particles.positions[j] += separationVector;
-                }
-            }
-        }
-    }
+    this->ResolveCollisions(root, nullptr, nullptr);
 
     // PHASE 2: Batch update velocities and positions using SIMD (after collisions resolved)
     // Process particles in groups of 4 using AVX2 SIMD
@@ -409,6 +408,140 @@ void Simulation::UpdateParticles()
         }
     }
 
+    // Fast movers may have passed through someone during the drift
+    if (this->isSweptCollision)
+    {
+        this->sweptSolver->Resolve(particles, this->GetTimeStep(), this->sweptSpeedThreshold);
+    }
+
+    // Forces were taken before the drift
+    this->isAccelerationCurrent = false;
+    this->totalMass = root->totalMass;
+}
+
+
+/**
+  * @brief  Advance one frame with hierarchical block timesteps
+  * @param  None
+  * @retval None
+  * @note   The frame is split into ticks of timeStep / 2^BLOCK_MAX_LEVEL. On each tick the tree is
+  *         rebuilt with everyone's current position, but only the particles starting a step get new
+  *         forces, collision checks and a kick; then everyone drifts to the next tick.
+  */
+void Simulation::UpdateParticlesBlockStep()
+{
+    ParticleData& particles = *particleData;
+    size_t numParticles = particles.Size();
+    QuadtreeNode* root = nullptr;
+    bool isFirstTick = true;
+
+    this->blockStepper->BeginFrame(particles, this->GetTimeStep());
+
+    while (!this->blockStepper->IsFrameDone())
+    {
+        // Reorder only between frames, so the reorder interval still counts frames
+        root = this->PrepareQuadtree(isFirstTick);
+
+        // Tick 0 is aligned with every level, so every frame starts with a full evaluation
+        size_t numActive = this->blockStepper->CollectActive(particles);
+        bool isFull = (numActive == numParticles);
+        const std::vector<uint32_t>* active = isFull ? nullptr : &this->blockStepper->GetActiveParticles();
+        const uint8_t* activeMask = isFull ? nullptr : this->blockStepper->GetActiveMask();
+
+        this->ComputeGravity(root, active, activeMask);
+        this->ResolveCollisions(root, active, activeMask);
+        this->blockStepper->Kick(particles);
+        this->blockStepper->Drift(particles);
+
+        if (ENABLE_BOUNDING_BOX && !this->isOpenDomain)
+        {
+            for (size_t i = 0; i < numParticles; ++i)
+            {
+                ClampToViewport(particles.positions[i], particles.velocities[i]);
+            }
+        }
+
+        isFirstTick = false;
+    }
+
+    for (size_t i = 0; i < numParticles; ++i)
+    {
+        particles.UpdateColor(i);
+    }
+
+    this->isAccelerationCurrent = false;
+    this->totalMass = root->totalMass;
+}
+
+
+/**
+  * @brief  Advance one frame with a kick-drift-kick integrator (leapfrog or 4th-order Yoshida)
+  * @param  None
+  * @retval None
+  * @note   The opening kick reuses the forces from the end of the last frame, so leapfrog costs
+  *         one force evaluation per frame and Yoshida three. Collisions are resolved once at the
+  *         end of the frame; their impulses (and the walls) are not symplectic. A frame that
+  *         resolved any contact leaves its forces stale, so the next one re-evaluates them.
+  */
+void Simulation::UpdateParticlesSplit()
+{
+    ParticleData& particles = *particleData;
+    size_t numParticles = particles.Size();
+    double dt = this->GetTimeStep();
+    QuadtreeNode* root = nullptr;
+    bool allowReorder = true;
+
+    // Leapfrog is one kick-drift-kick step, Yoshida three of w1, w0, w1 times the step
+    const double leapfrogWeights[] = { 1.0 };
+    const double yoshidaWeights[]  = { YOSHIDA_W1, YOSHIDA_W0, YOSHIDA_W1 };
+    bool isYoshida = (this->integrator == Integrator::Yoshida4);
+    const double* weights = isYoshida ? yoshidaWeights : leapfrogWeights;
+    int numWeights = isYoshida ? 3 : 1;
+
+    // Particles were added or removed, or the last frame used another integrator
+    if (!this->isAccelerationCurrent)
+    {
+        root = this->PrepareQuadtree(true);
+        this->ComputeGravity(root, nullptr, nullptr);
+        allowReorder = false;
+    }
+
+    // Closing and opening half kicks of consecutive substeps share their forces, so they are merged
+    double kick = 0.5 * weights[0] * dt;
+
+    for (int k = 0; k < numWeights; ++k)
+    {
+        ScaledAddSimd(particles.velocities.data(), particles.accelerations.data(), kick, numParticles);
+        ScaledAddSimd(particles.positions.data(), particles.velocities.data(), weights[k] * dt, numParticles);
+
+        if (ENABLE_BOUNDING_BOX && !this->isOpenDomain)
+        {
+            for (size_t i = 0; i < numParticles; ++i)
+            {
+                ClampToViewport(particles.positions[i], particles.velocities[i]);
+            }
+        }
+
+        root = this->PrepareQuadtree(allowReorder);
+        this->ComputeGravity(root, nullptr, nullptr);
+        allowReorder = false;
+
+        kick = 0.5 * (weights[k] + ((k + 1 < numWeights) ? weights[k + 1] : 0.0)) * dt;
+    }
+
+    ScaledAddSimd(particles.velocities.data(), particles.accelerations.data(), kick, numParticles);
+
+    this->ResolveCollisions(root, nullptr, nullptr);
+
+    for (size_t i = 0; i < numParticles; ++i)
+    {
+        particles.velocities[i] *= DAMPING_FACTOR;
+        particles.ages[i] += dt;
+        particles.UpdateColor(i);
+    }
+
+    // Contacts push particles apart after the last force evaluation, so those forces are stale
+    this->isAccelerationCurrent = (this->contactCount == 0);
     this->totalMass = root->totalMass;
 }
 
@@ -513,110 +646,1415 @@ SimulationTemplate Simulation::GetSimulationTemplate() const
 
 
 /**
-  * @brief  Get pointer to particle data (SoA)
+  * @brief  Get algorithm used to build the quadtree each step
   * @param  None
-  * @retval ParticleData*
+  * @retval TreeBuildMode
   */
-ParticleData* Simulation::GetParticleData() const
+TreeBuildMode Simulation::GetTreeBuildMode() const
 {
-    return this->particleData;
+    return this->treeBuildMode;
 }
 
 
 /**
-  * @brief  Get pointer to engine
+  * @brief  Get how the Barnes-Hut tree is walked for forces
   * @param  None
-  * @retval Engine*
+  * @retval ForceWalkMode
   */
-Engine* Simulation::GetEngine() const
+ForceWalkMode Simulation::GetForceWalkMode() const
 {
-    return this->engine;
+    return this->forceWalkMode;
 }
 
 
 /**
-  * @brief  Set maximum number of particles that can be present in the simulation
-  * @param  count
-  * @retval None
+  * @brief  Get the time integrator used with a shared time step
+  * @param  None
+  * @retval Integrator
   */
-void Simulation::SetMaxParticleCount(size_t count)
+Integrator Simulation::GetIntegrator() const
 {
-    this->maxParticleCount = count;
+    return this->integrator;
 }
 
 
 /**
-  * @brief  Set mass that will be applied to new particles
-  * @param  mass
-  * @retval None
+  * @brief  Get how collision candidates are found
+  * @param  None
+  * @retval CollisionBroadphase
   */
-void Simulation::SetNewParticleMass(double mass)
+CollisionBroadphase Simulation::GetCollisionBroadphase() const
 {
-    this->newParticleMass = mass;
+    return this->collisionBroadphase;
 }
 
 
 /**
-  * @brief  Set velocity that will be applied to new particles
-  * @param  velocity
-  * @retval None
+  * @brief  Check whether collisions are resolved in parallel over colored grid blocks
+  * @param  None
+  * @retval bool
   */
-void Simulation::SetNewParticleVelocity(glm::vec2 velocity)
+bool Simulation::IsParallelCollisionsEnabled() const
 {
-    this->newParticleVelocity = velocity;
+    return this->isParallelCollisions;
 }
 
 
 /**
-  * @brief  Bind particle data that will be used in the simulation
-  * @param  particleData*
-  * @retval None
+  * @brief  Get the number of touching pairs found by the last collision pass
+  * @param  None
+  * @retval size_t
   */
-void Simulation::SetParticleData(ParticleData* particleData)
+size_t Simulation::GetContactCount() const
 {
-    this->particleData = particleData;
+    return this->contactCount;
 }
 
 
 /**
-  * @brief  Set particle brush size used to add/remove particles
-  * @param  size
-  * @retval None
+  * @brief  Get the Verlet list skin (reach beyond contact distance)
+  * @param  None
+  * @retval double 0 when Verlet lists are off
   */
-void Simulation::SetParticleBrushSize(int size)
+double Simulation::GetNeighborListSkin() const
 {
-    this->particleBrushSize = glm::clamp(size, 1, 150);
+    return this->neighborListSkin;
 }
 
 
 /**
-  * @brief  Set template that is used when the simulation is initiated or restarted
-  * @param  simulationTemplate
-  * @retval None
+  * @brief  Get how often the Verlet lists were rebuilt since they were enabled
+  * @param  None
+  * @retval double Collision passes per rebuild (0 before the first pass)
   */
-void Simulation::SetSimulationTemplate(SimulationTemplate simulationTemplate)
+double Simulation::GetNeighborListStepsPerRebuild() const
 {
-    this->simulationTemplate = simulationTemplate;
+    size_t rebuilds = this->collisionGrid->GetVerletRebuildCount();
+    if (rebuilds == 0)
+        return 0.0;
+
+    return (double)this->collisionGrid->GetVerletStepCount() / (double)rebuilds;
 }
 
 
 /**
-  * @brief  Set simulation time step to increase/decrease simulation speed
-  * @param  timeStep
-  * @retval None
+  * @brief  Get the average Verlet list length
+  * @param  None
+  * @retval double Candidates per particle (each pair counts for both particles)
   */
-void Simulation::SetTimeStep(double timeStep)
+double Simulation::GetNeighborListLength() const
 {
-    this->timeStep = timeStep;
+    if (this->particleData == nullptr || this->particleData->Size() == 0)
+        return 0.0;
+
+    return 2.0 * (double)this->collisionGrid->GetCandidateCount() / (double)this->particleData->Size();
+}
+
+
+/**
+  * @brief  Check whether fast movers get swept (continuous) collisions
+  * @param  None
+  * @retval bool
+  */
+bool Simulation::IsSweptCollisionEnabled() const
+{
+    return this->isSweptCollision;
 }
 
 
+/**
+  * @brief  Get the speed above which particles are swept
+  * @param  None
+  * @retval double Particle radii per step
+  */
+double Simulation::GetSweptSpeedThreshold() const
+{
+    return this->sweptSpeedThreshold;
+}
 
-/******************************************************************************/
-/******************************************************************************/
-/* Private Functions                                                          */
-/******************************************************************************/
-/******************************************************************************/
+
+/**
+  * @brief  Get the number of particles swept in the last step
+  * @param  None
+  * @retval size_t
+  */
+size_t Simulation::GetSweptParticleCount() const
+{
+    return this->sweptSolver->GetFastCount();
+}
+
+
+/**
+  * @brief  Get the number of swept impacts resolved in the last step
+  * @param  None
+  * @retval size_t
+  */
+size_t Simulation::GetSweptHitCount() const
+{
+    return this->sweptSolver->GetHitCount();
+}
+
+
+/**
+  * @brief  Check whether touching particles merge instead of bouncing
+  * @param  None
+  * @retval bool
+  */
+bool Simulation::IsMergeModeEnabled() const
+{
+    return this->isMergeMode;
+}
+
+
+/**
+  * @brief  Get the mass ratio at or above which touching particles merge
+  * @param  None
+  * @retval double Heavier / lighter mass (0 when disabled)
+  */
+double Simulation::GetMergeMassRatio() const
+{
+    return this->mergeMassRatio;
+}
+
+
+/**
+  * @brief  Get the relative speed below which touching particles merge
+  * @param  None
+  * @retval double Units per second (0 when disabled)
+  */
+double Simulation::GetMergeRelativeSpeed() const
+{
+    return this->mergeRelativeSpeed;
+}
+
+
+/**
+  * @brief  Get the number of particles absorbed at the start of the last frame
+  * @param  None
+  * @retval size_t
+  */
+size_t Simulation::GetMergeCount() const
+{
+    return this->accretionSolver->GetMergeCount();
+}
+
+
+/**
+  * @brief  Get the number of particles absorbed since the simulation started
+  * @param  None
+  * @retval size_t
+  */
+size_t Simulation::GetTotalMergeCount() const
+{
+    return this->accretionSolver->GetTotalMergeCount();
+}
+
+
+/**
+  * @brief  Get far-field expansion used for accepted tree nodes
+  * @param  None
+  * @retval MultipoleOrder
+  */
+MultipoleOrder Simulation::GetMultipoleOrder() const
+{
+    return this->multipoleOrder;
+}
+
+
+/**
+  * @brief  Get arithmetic precision of the Barnes-Hut force kernels
+  * @param  None
+  * @retval ForcePrecision
+  */
+ForcePrecision Simulation::GetForcePrecision() const
+{
+    return this->forcePrecision;
+}
+
+
+/**
+  * @brief  Get algorithm used for gravity
+  * @param  None
+  * @retval GravitySolver
+  */
+GravitySolver Simulation::GetGravitySolver() const
+{
+    return this->gravitySolver;
+}
+
+
+/**
+  * @brief  Get FMM expansion order
+  * @param  None
+  * @retval int
+  */
+int Simulation::GetFmmOrder() const
+{
+    return this->fmmOrder;
+}
+
+
+/**
+  * @brief  Get TreePM mesh cells per side
+  * @param  None
+  * @retval int
+  */
+int Simulation::GetTreePmMeshSize() const
+{
+    return this->treePmMeshSize;
+}
+
+
+/**
+  * @brief  Get multipole acceptance criterion used by the Barnes-Hut walks
+  * @param  None
+  * @retval OpeningCriterion
+  */
+OpeningCriterion Simulation::GetOpeningCriterion() const
+{
+    return this->openingCriterion;
+}
+
+
+/**
+  * @brief  Get Barnes-Hut opening angle (Geometric / MinDistance criteria)
+  * @param  None
+  * @retval double
+  */
+double Simulation::GetTheta() const
+{
+    return this->theta;
+}
+
+
+/**
+  * @brief  Get allowed force error fraction (SalmonWarren / RelativeForce criteria)
+  * @param  None
+  * @retval double
+  */
+double Simulation::GetForceTolerance() const
+{
+    return this->forceTolerance;
+}
+
+
+/**
+  * @brief  Get average number of node and particle interactions per particle in the last step
+  * @param  None
+  * @retval double   0 when the last step used the FMM solver
+  */
+double Simulation::GetAverageInteractions() const
+{
+    return this->averageInteractions;
+}
+
+
+/**
+  * @brief  Get number of frames between force accuracy audits
+  * @param  None
+  * @retval size_t   0 when auditing is disabled
+  */
+size_t Simulation::GetForceAuditInterval() const
+{
+    return this->forceAuditInterval;
+}
+
+
+/**
+  * @brief  Get the result of the latest force accuracy audit
+  * @param  None
+  * @retval const ForceAuditReport&
+  */
+const ForceAuditReport& Simulation::GetForceAuditReport() const
+{
+    return this->forceAudit->GetReport();
+}
+
+
+/**
+  * @brief  Get the number of frames between energy and angular momentum drift reports
+  * @param  None
+  * @retval size_t 0 when reports are off
+  */
+size_t Simulation::GetConservationInterval() const
+{
+    return this->conservationInterval;
+}
+
+
+/**
+  * @brief  Get the latest energy and angular momentum drift report
+  * @param  None
+  * @retval const ConservationReport&
+  */
+const ConservationReport& Simulation::GetConservationReport() const
+{
+    return this->conservation;
+}
+
+
+/**
+  * @brief  Check whether the last step used all-pairs summation (particle count at or below DIRECT_SUM_MAX_PARTICLES)
+  * @param  None
+  * @retval bool
+  */
+bool Simulation::IsDirectSummationActive() const
+{
+    return this->isDirectSummation;
+}
+
+
+/**
+  * @brief  Check whether particles step on individual power-of-two timestep levels
+  * @param  None
+  * @retval bool
+  */
+bool Simulation::IsBlockTimeStepEnabled() const
+{
+    return this->isBlockTimeStep;
+}
+
+
+/**
+  * @brief  Get the number of particle force evaluations in the last frame
+  * @param  None
+  * @retval size_t One per particle with a shared step, more with block timesteps
+  */
+size_t Simulation::GetForceEvaluations() const
+{
+    return this->isBlockTimeStep ? this->blockStepper->GetForceEvaluations() : this->GetParticleCount();
+}
+
+
+/**
+  * @brief  Get the finest block timestep level used in the last frame
+  * @param  None
+  * @retval int The finest step was timeStep / 2^level (0 with a shared step)
+  */
+int Simulation::GetDeepestTimeLevel() const
+{
+    return this->isBlockTimeStep ? this->blockStepper->GetDeepestLevel() : 0;
+}
+
+
+/**
+  * @brief  Force evaluations a shared step at the finest level would have needed, per evaluation done
+  * @param  None
+  * @retval double Saving factor of the block timesteps (1 with a shared step)
+  */
+double Simulation::GetBlockStepSaving() const
+{
+    return this->isBlockTimeStep ? this->blockStepper->GetSharedStepRatio() : 1.0;
+}
+
+
+/**
+  * @brief  Check whether the quadtree is kept and refit between steps
+  * @param  None
+  * @retval bool
+  */
+bool Simulation::IsPersistentTreeEnabled() const
+{
+    return this->isPersistentTree;
+}
+
+
+/**
+  * @brief  Get number of full quadtree rebuilds done by the persistent tree
+  * @param  None
+  * @retval size_t
+  */
+size_t Simulation::GetTreeRebuildCount() const
+{
+    return this->persistentTree->rebuildCount;
+}
+
+
+/**
+  * @brief  Get number of steps where the persistent tree was refit instead of rebuilt
+  * @param  None
+  * @retval size_t
+  */
+size_t Simulation::GetTreeRefitCount() const
+{
+    return this->persistentTree->refitCount;
+}
+
+
+/**
+  * @brief  Get number of quadtree nodes in use this step (rounded up to whole pool slices)
+  * @param  None
+  * @retval size_t
+  */
+size_t Simulation::GetTreeNodeCount() const
+{
+    return this->nodePool->nextIndex;
+}
+
+
+/**
+  * @brief  Get the most quadtree nodes in use at once since the simulation started
+  * @param  None
+  * @retval size_t
+  */
+size_t Simulation::GetTreeNodeHighWaterMark() const
+{
+    return this->nodePool->HighWaterMark();
+}
+
+
+/**
+  * @brief  Get memory held by the quadtree node arena
+  * @param  None
+  * @retval size_t Bytes
+  */
+size_t Simulation::GetTreeNodeMemory() const
+{
+    return this->nodePool->Capacity() * (sizeof(QuadtreeNode) + sizeof(QuadtreeNodeCold));
+}
+
+
+/**
+  * @brief  Check whether the quadtree root is sized from the particles each step
+  * @param  None
+  * @retval bool
+  */
+bool Simulation::IsOpenDomainEnabled() const
+{
+    return this->isOpenDomain;
+}
+
+
+/**
+  * @brief  Get how far outliers are handled in the open domain
+  * @param  None
+  * @retval OutlierPolicy
+  */
+OutlierPolicy Simulation::GetOutlierPolicy() const
+{
+    return this->outlierPolicy;
+}
+
+
+/**
+  * @brief  Get number of particles left outside the quadtree this step
+  * @param  None
+  * @retval size_t
+  */
+size_t Simulation::GetOutlierCount() const
+{
+    return this->isOpenDomain ? this->nodePool->domain.outliers.size() : 0;
+}
+
+
+/**
+  * @brief  Get number of frames between particle reorders
+  * @param  None
+  * @retval size_t (0 when reordering is disabled)
+  */
+size_t Simulation::GetReorderInterval() const
+{
+    return this->reorderInterval;
+}
+
+
+/**
+  * @brief  Get pointer to particle data (SoA)
+  * @param  None
+  * @retval ParticleData*
+  */
+ParticleData* Simulation::GetParticleData() const
+{
+    return this->particleData;
+}
+
+
+/**
+  * @brief  Get pointer to engine
+  * @param  None
+  * @retval Engine*
+  */
+Engine* Simulation::GetEngine() const
+{
+    return this->engine;
+}
+
+
+/**
+  * @brief  Set maximum number of particles that can be present in the simulation
+  * @param  count     Capacity (the engine resizes its GPU buffers to match on the next frame)
+  * @retval None
+  * @note   If the particle arrays cannot grow, the previous capacity is kept.
+  */
+void Simulation::SetMaxParticleCount(size_t count)
+{
+    // Never below the particles already present; arrays grow now instead of while painting
+    size_t present = this->particleData ? this->particleData->Size() : 0;
+    size_t capacity = std::min(std::max(count, present), PARTICLE_CAPACITY_LIMIT);
+
+    if (this->particleData)
+    {
+        try
+        {
+            this->particleData->Reserve(capacity);
+        }
+        catch (const std::bad_alloc&)
+        {
+            LOG_ERROR("Out of memory reserving %zu particles, capacity stays at %zu", capacity, this->maxParticleCount);
+            return;
+        }
+    }
+
+    this->maxParticleCount = capacity;
+}
+
+
+/**
+  * @brief  Set mass that will be applied to new particles
+  * @param  mass
+  * @retval None
+  */
+void Simulation::SetNewParticleMass(double mass)
+{
+    this->newParticleMass = mass;
+}
+
+
+/**
+  * @brief  Set velocity that will be applied to new particles
+  * @param  velocity
+  * @retval None
+  */
+void Simulation::SetNewParticleVelocity(glm::vec2 velocity)
+{
+    this->newParticleVelocity = velocity;
+}
+
+
+/**
+  * @brief  Bind particle data that will be used in the simulation
+  * @param  particleData*
+  * @retval None
+  */
+void Simulation::SetParticleData(ParticleData* particleData)
+{
+    this->particleData = particleData;
+}
+
+
+/**
+  * @brief  Set particle brush size used to add/remove particles
+  * @param  size
+  * @retval None
+  */
+void Simulation::SetParticleBrushSize(int size)
+{
+    this->particleBrushSize = glm::clamp(size, 1, 150);
+}
+
+
+/**
+  * @brief  Set template that is used when the simulation is initiated or restarted
+  * @param  simulationTemplate
+  * @retval None
+  */
+void Simulation::SetSimulationTemplate(SimulationTemplate simulationTemplate)
+{
+    this->simulationTemplate = simulationTemplate;
+}
+
+
+/**
+  * @brief  Set simulation time step to increase/decrease simulation speed
+  * @param  timeStep
+  * @retval None
+  */
+void Simulation::SetTimeStep(double timeStep)
+{
+    this->timeStep = timeStep;
+}
+
+
+/**
+  * @brief  Set algorithm used to build the quadtree each step
+  * @param  mode
+  * @retval None
+  */
+void Simulation::SetTreeBuildMode(TreeBuildMode mode)
+{
+    this->treeBuildMode = mode;
+}
+
+
+/**
+  * @brief  Set how the Barnes-Hut tree is walked for forces
+  * @param  mode
+  * @retval None
+  * @note   PerParticle is the default. Grouped is faster but opens nodes against the group's
+  *         box rather than each particle, so its forces are not bit-identical to PerParticle
+  */
+void Simulation::SetForceWalkMode(ForceWalkMode mode)
+{
+    this->forceWalkMode = mode;
+}
+
+
+/**
+  * @brief  Set the time integrator used with a shared time step
+  * @param  integrator
+  * @retval None
+  * @note   Block timesteps keep their own kick and drift. Starts a new drift baseline.
+  */
+void Simulation::SetIntegrator(Integrator integrator)
+{
+    this->integrator = integrator;
+    this->isAccelerationCurrent = false;
+    this->conservation.particles = 0;
+}
+
+
+/**
+  * @brief  Set how collision candidates are found
+  * @param  broadphase
+  * @retval None
+  */
+void Simulation::SetCollisionBroadphase(CollisionBroadphase broadphase)
+{
+    this->collisionBroadphase = broadphase;
+}
+
+
+/**
+  * @brief  Enable or disable parallel collision resolution over colored grid blocks
+  * @param  enabled
+  * @retval None
+  * @note   Needs the cell list, so it uses the grid whatever the broadphase setting. Off by
+  *         default: pairs are taken in a different order than the serial loop, so stacking
+  *         ends up close to, but not the same as, the serial result.
+  */
+void Simulation::SetParallelCollisionsEnabled(bool enabled)
+{
+    this->isParallelCollisions = enabled;
+}
+
+
+/**
+  * @brief  Set the Verlet list skin
+  * @param  skin Reach beyond contact distance, 0 to find contacts from scratch every step
+  * @retval None
+  * @note   Verlet lists supply the contacts of every full step, serial or parallel resolve.
+  */
+void Simulation::SetNeighborListSkin(double skin)
+{
+    this->neighborListSkin = std::max(skin, 0.0);
+    this->collisionGrid->ResetVerletStatistics();
+}
+
+
+/**
+  * @brief  Enable or disable swept (continuous) collisions for fast movers
+  * @param  enabled
+  * @retval None
+  * @note   Runs after the drift of the symplectic Euler step, the only one that drifts on
+  *         the end-of-step velocities (leapfrog, Yoshida and block steps are not swept).
+  */
+void Simulation::SetSweptCollisionEnabled(bool enabled)
+{
+    this->isSweptCollision = enabled;
+}
+
+
+/**
+  * @brief  Set the speed above which particles are swept
+  * @param  threshold Particle radii per step
+  * @retval None
+  */
+void Simulation::SetSweptSpeedThreshold(double threshold)
+{
+    this->sweptSpeedThreshold = std::max(threshold, 0.0);
+}
+
+
+/**
+  * @brief  Merge touching particles instead of bouncing them
+  * @param  enabled
+  * @retval None
+  * @note   Merges run at the start of every frame, for every integrator. Mass and momentum
+  *         are conserved; kinetic energy of the relative motion is lost.
+  */
+void Simulation::SetMergeModeEnabled(bool enabled)
+{
+    this->isMergeMode = enabled;
+}
+
+
+/**
+  * @brief  Set the mass ratio at or above which touching particles merge
+  * @param  ratio Heavier / lighter mass (0 disables the test)
+  * @retval None
+  */
+void Simulation::SetMergeMassRatio(double ratio)
+{
+    this->mergeMassRatio = std::max(ratio, 0.0);
+}
+
+
+/**
+  * @brief  Set the relative speed below which touching particles merge
+  * @param  speed Units per second (0 disables the test)
+  * @retval None
+  */
+void Simulation::SetMergeRelativeSpeed(double speed)
+{
+    this->mergeRelativeSpeed = std::max(speed, 0.0);
+}
+
+
+/**
+  * @brief  Set far-field expansion used for accepted tree nodes
+  * @param  order
+  * @retval None
+  */
+void Simulation::SetMultipoleOrder(MultipoleOrder order)
+{
+    this->multipoleOrder = order;
+}
+
+
+/**
+  * @brief  Set arithmetic precision of the Barnes-Hut force kernels (positions and velocities stay double)
+  * @param  precision
+  * @retval None
+  */
+void Simulation::SetForcePrecision(ForcePrecision precision)
+{
+    this->forcePrecision = precision;
+}
+
+
+/**
+  * @brief  Set algorithm used for gravity
+  * @param  solver
+  * @retval None
+  */
+void Simulation::SetGravitySolver(GravitySolver solver)
+{
+    this->gravitySolver = solver;
+}
+
+
+/**
+  * @brief  Set FMM expansion order
+  * @param  order   Clamped to [1, FMM_MAX_ORDER]
+  * @retval None
+  */
+void Simulation::SetFmmOrder(int order)
+{
+    this->fmmOrder = std::max(1, std::min(order, FMM_MAX_ORDER));
+}
+
+
+/**
+  * @brief  Set TreePM mesh cells per side
+  * @param  meshSize Clamped to [TREEPM_MIN_MESH, TREEPM_MAX_MESH] (the solver rounds down to a power of two)
+  * @retval None
+  */
+void Simulation::SetTreePmMeshSize(int meshSize)
+{
+    this->treePmMeshSize = std::max(TREEPM_MIN_MESH, std::min(meshSize, TREEPM_MAX_MESH));
+}
+
+
+/**
+  * @brief  Set multipole acceptance criterion used by the Barnes-Hut walks
+  * @param  criterion
+  * @retval None
+  */
+void Simulation::SetOpeningCriterion(OpeningCriterion criterion)
+{
+    this->openingCriterion = criterion;
+}
+
+
+/**
+  * @brief  Set Barnes-Hut opening angle (Geometric / MinDistance criteria)
+  * @param  theta   Clamped to at least 0.05
+  * @retval None
+  */
+void Simulation::SetTheta(double theta)
+{
+    this->theta = std::max(theta, 0.05);
+}
+
+
+/**
+  * @brief  Set allowed force error fraction (SalmonWarren / RelativeForce criteria)
+  * @param  tolerance   Clamped to [1e-6, 1]
+  * @retval None
+  */
+void Simulation::SetForceTolerance(double tolerance)
+{
+    this->forceTolerance = std::max(1e-6, std::min(tolerance, 1.0));
+}
+
+
+/**
+  * @brief  Set number of frames between force accuracy audits
+  * @param  interval  Frames between audits (0 disables auditing)
+  * @retval None
+  */
+void Simulation::SetForceAuditInterval(size_t interval)
+{
+    this->forceAuditInterval = interval;
+    this->framesSinceAudit   = (interval > 0) ? interval - 1 : 0;
+}
+
+
+/**
+  * @brief  Set the number of frames between energy and angular momentum drift reports
+  * @param  interval 0 turns reports off
+  * @retval None
+  * @note   The first report after enabling takes the baseline.
+  */
+void Simulation::SetConservationInterval(size_t interval)
+{
+    this->conservationInterval    = interval;
+    this->framesSinceConservation = (interval > 0) ? interval - 1 : 0;
+    this->conservation            = ConservationReport();
+}
+
+
+/**
+  * @brief  Step each particle on its own power-of-two fraction of the time step
+  * @param  enabled
+  * @retval None
+  * @note   Disabling puts every particle back on level 0.
+  */
+void Simulation::SetBlockTimeStepEnabled(bool enabled)
+{
+    this->isBlockTimeStep = enabled;
+
+    if (!enabled && this->particleData)
+    {
+        std::fill(this->particleData->timeLevels.begin(), this->particleData->timeLevels.end(), 0);
+    }
+}
+
+
+/**
+  * @brief  Keep the quadtree between steps and refit it instead of rebuilding
+  * @param  enabled
+  * @retval None
+  */
+void Simulation::SetPersistentTreeEnabled(bool enabled)
+{
+    this->isPersistentTree = enabled;
+    this->persistentTree->Invalidate();
+    this->persistentTree->rebuildCount = 0;
+    this->persistentTree->refitCount   = 0;
+}
+
+
+/**
+  * @brief  Set number of frames between particle reorders
+  * @param  interval  Frames between reorders (0 disables reordering)
+  * @retval None
+  */
+void Simulation::SetReorderInterval(size_t interval)
+{
+    this->reorderInterval    = interval;
+    this->framesSinceReorder = 0;
+}
+
+
+/**
+  * @brief  Size the quadtree root from the particles each step instead of the viewport
+  * @param  enabled   Also stops ENABLE_BOUNDING_BOX from clamping particles
+  * @retval None
+  */
+void Simulation::SetOpenDomainEnabled(bool enabled)
+{
+    this->isOpenDomain = enabled;
+    this->nodePool->domain.outliers.clear();
+    this->persistentTree->Invalidate();
+}
+
+
+/**
+  * @brief  Set how far outliers are handled in the open domain
+  * @param  policy
+  * @retval None
+  */
+void Simulation::SetOutlierPolicy(OutlierPolicy policy)
+{
+    this->outlierPolicy = policy;
+    this->persistentTree->Invalidate();
+}
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Private Functions                                                          */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  Periodically measure total energy and angular momentum against a baseline
+  * @param  None
+  * @retval None
+  * @note   A new baseline is taken whenever the particle count changes. Walls, collisions
+  *         and the tree's approximation all show up as drift, not just the integrator.
+  */
+void Simulation::UpdateConservationReport()
+{
+    if (this->conservationInterval == 0 || ++this->framesSinceConservation < this->conservationInterval)
+        return;
+
+    this->framesSinceConservation = 0;
+
+    ParticleData& particles = *particleData;
+    size_t numParticles = particles.Size();
+
+    if (numParticles == 0 || numParticles > CONSERVATION_MAX_COUNT)
+        return;
+
+    double energy          = ComputeTotalEnergy(particles);
+    double angularMomentum = ComputeTotalAngularMomentum(particles);
+    ConservationReport& report = this->conservation;
+
+    if (report.particles != numParticles)
+    {
+        report = ConservationReport();
+        report.particles              = numParticles;
+        report.initialEnergy          = energy;
+        report.initialAngularMomentum = angularMomentum;
+        report.startTime              = this->simulationTime;
+        return;
+    }
+
+    report.elapsed = this->simulationTime - report.startTime;
+    report.energyDrift = std::abs(energy - report.initialEnergy) / std::abs(report.initialEnergy);
+    report.angularMomentumDrift = std::abs(angularMomentum - report.initialAngularMomentum);
+    if (report.initialAngularMomentum != 0.0)
+        report.angularMomentumDrift /= std::abs(report.initialAngularMomentum);
+
+    LOG_INFO("Drift after %.3f s: energy %.3e, angular momentum %.3e", report.elapsed, report.energyDrift, report.angularMomentumDrift);
+}
+
+
+/**
+  * @brief  Size the root, reorder the particles if due, then build the tree and its mass distribution
+  * @param  allowReorder False to postpone a due reorder (block timestep substeps)
+  * @retval QuadtreeNode* Root node with mass distribution computed
+  */
+QuadtreeNode* Simulation::PrepareQuadtree(bool allowReorder)
+{
+    ParticleData& particles = *particleData;
+
+    // Boxed: ENABLE_BOUNDING_BOX clamps particles to the viewport [-1, 1], so the root is fixed
+    double centerX = 0.0;
+    double centerY = 0.0;
+    double halfSize = 1.0 + 1e-3;
+    DomainBounds& domain = nodePool->domain;
+
+    // Open domain: size the root from this step's particles
+    if (this->isOpenDomain)
+    {
+        ComputeDomainBounds(particles, this->outlierPolicy, domain);
+        centerX  = domain.centerX;
+        centerY  = domain.centerY;
+        halfSize = domain.halfSize;
+    }
+
+    // Periodically restore spatial locality of the particle arrays
+    if (allowReorder && this->reorderInterval > 0 && ++this->framesSinceReorder >= this->reorderInterval)
+    {
+        this->ReorderParticles(centerX, centerY, halfSize);
+        this->framesSinceReorder = 0;
+
+        // Outlier indices moved with the particles
+        if (this->isOpenDomain && !domain.outliers.empty())
+        {
+            ComputeDomainBounds(particles, this->outlierPolicy, domain);
+        }
+    }
+
+    QuadtreeNode* root = this->BuildQuadtree(centerX, centerY, halfSize);
+
+    // A refitted persistent tree keeps its older root, which may still contain some outliers
+    if (this->isOpenDomain && !domain.outliers.empty())
+    {
+        domain.outliers.erase(std::remove_if(domain.outliers.begin(), domain.outliers.end(),
+            [&](uint32_t i) { return root->Contains(particles.positions[i].x, particles.positions[i].y); }), domain.outliers.end());
+    }
+
+    if (this->treeBuildMode == TreeBuildMode::MortonParallel && particles.Size() > 1000)
+    {
+        ComputeMassDistributionParallel(root, particles, *nodePool);
+    }
+    else
+    {
+        root->ComputeMassDistribution(particles);
+    }
+
+    // Update center of mass for color visualization
+    Particle::SetCenterOfMass(root->centerOfMass);
+
+    return root;
+}
+
+
+/**
+  * @brief  Overwrite the accelerations of all (or the active) particles with the selected solver
+  * @param  root       Root node with mass distribution computed
+  * @param  active     Optional particles to update (block timesteps), nullptr for all
+  * @param  activeMask Per-particle flags matching active, nullptr for all
+  * @retval None
+  * @note   FMM and TreePM work on the whole tree at once and always update everyone. The force
+  *         audit only runs on full evaluations, since it compares every sampled particle.
+  */
+void Simulation::ComputeGravity(QuadtreeNode* root, const std::vector<uint32_t>* active, const uint8_t* activeMask)
+{
+    ParticleData& particles = *particleData;
+    size_t numParticles = particles.Size();
+    DomainBounds& domain = nodePool->domain;
+
+    int numTargets = active ? (int)active->size() : (int)numParticles;
+    if (numTargets == 0)
+        return;
+
+    // The walks read last step's accelerations (RelativeForce) before overwriting them
+    OpeningTest openingTest(this->openingCriterion, this->theta, this->forceTolerance);
+    openingTest.Prepare(root);
+    size_t interactions = 0;
+
+    std::chrono::high_resolution_clock::time_point forceStart = std::chrono::high_resolution_clock::now();
+
+    this->isDirectSummation = (numParticles <= DIRECT_SUM_MAX_PARTICLES);
+
+    if (this->isDirectSummation)
+    {
+        // Few particles (e.g. the orbit templates): exact all-pairs SIMD summation beats any tree walk
+        this->directSolver->ComputeAccelerations(particles, active);
+        interactions = (size_t)numTargets * (numParticles - 1);
+    }
+    else if (this->gravitySolver == GravitySolver::Fmm)
+    {
+        // Multipole/local expansions on the same tree, near field evaluated directly
+        this->fmmSolver->ComputeAccelerations(particles, root, *nodePool, this->fmmOrder);
+        numTargets = (int)numParticles;
+    }
+    else if (this->gravitySolver == GravitySolver::TreePm)
+    {
+        // FFT convolution on a mesh over the root for long range, tree walk cut off at a few cells for the rest
+        this->treePmSolver->ComputeAccelerations(particles, root, this->treePmMeshSize, this->theta, &interactions);
+        numTargets = (int)numParticles;
+    }
+    else if (this->forceWalkMode == ForceWalkMode::Grouped)
+    {
+        // One tree walk per group of nearby particles (parallel over groups)
+        ComputeAccelerationsGrouped(particles, root, openingTest, *nodePool, this->multipoleOrder, &interactions, this->forcePrecision, activeMask);
+    }
+    else if (this->forceWalkMode == ForceWalkMode::Stackless && nodePool->flatTree.Build(root, particles))
+    {
+        // Same result as the recursive walk, without recursion or a traversal stack
+        #pragma omp parallel for schedule(dynamic, 64) reduction(+:interactions) if(numTargets > 1000)
+        for (int k = 0; k < numTargets; ++k)
+        {
+            size_t i = active ? (*active)[k] : (size_t)k;
+            glm::dvec2 bhForce = ComputeForceBarnesHutStackless(i, particles, nodePool->flatTree, openingTest, this->multipoleOrder, &interactions, this->forcePrecision);
+            particles.accelerations[i] = bhForce / particles.masses[i];
+        }
+    }
+    else
+    {
+        // Parallel force computation using OpenMP
+        // Compute forces using Barnes-Hut, accumulate in each particle
+        #pragma omp parallel for schedule(dynamic, 64) reduction(+:interactions) if(numTargets > 1000)
+        for (int k = 0; k < numTargets; ++k)
+        {
+            size_t i = active ? (*active)[k] : (size_t)k;
+            glm::dvec2 bhForce = ComputeForceBarnesHut(i, particles, root, openingTest, this->multipoleOrder, &interactions, this->forcePrecision);
+            // a = F / m
+            particles.accelerations[i] = bhForce / particles.masses[i];
+        }
+    }
+
+    // Particles left outside the tree were skipped by the tree solvers (direct mode covers them)
+    if (this->isOpenDomain && !domain.outliers.empty() && !this->isDirectSummation)
+    {
+        this->ApplyOutlierGravity(root, openingTest, (numTargets == (int)numParticles) ? nullptr : activeMask);
+    }
+
+    // FMM interactions are cell pairs, not per particle, so they are not counted
+    this->averageInteractions = (double)interactions / (double)numTargets;
+
+    // Periodically check the solver against direct summation on a random sample (first full pass of a due frame)
+    if (!active && this->forceAuditInterval > 0 && this->framesSinceAudit >= this->forceAuditInterval)
+    {
+        std::chrono::duration<double, std::milli> forceTime = std::chrono::high_resolution_clock::now() - forceStart;
+        this->forceAudit->Run(particles, forceTime.count());
+        this->framesSinceAudit = 0;
+    }
+}
+
+
+/**
+  * @brief  Keep particles in the viewport, collect touching pairs once each and resolve them
+  * @param  root       Root node of the current tree (neighbor queries with CollisionBroadphase::Quadtree)
+  * @param  active     Optional particles to check (block timesteps), nullptr for all
+  * @param  activeMask Per-particle active flags matching active, nullptr for all
+  * @retval None
+  * @note   Parallel resolution and Verlet lists only handle full steps; block substeps keep
+  *         the serial loop. With Verlet lists on, full steps take their contacts from the
+  *         lists whatever the broadphase, and the serial resolve walks them in buffer order.
+  */
+void Simulation::ResolveCollisions(QuadtreeNode* root, const std::vector<uint32_t>* active, const uint8_t* activeMask)
+{
+    ParticleData& particles = *particleData;
+    size_t numTargets = active ? active->size() : particles.Size();
+    bool isGrid = (this->collisionBroadphase == CollisionBroadphase::Grid);
+    bool isVerlet = (this->neighborListSkin > 0.0);
+
+    if ((this->isParallelCollisions || isVerlet) && !active)
+    {
+        int numParticles = (int)particles.Size();
+
+        // Clamp everyone first, so the cells are built from positions inside the viewport
+        if (ENABLE_BOUNDING_BOX && !this->isOpenDomain)
+        {
+            #pragma omp parallel for schedule(static) if(numParticles > 10000)
+            for (int i = 0; i < numParticles; ++i)
+            {
+                ClampToViewport(particles.positions[i], particles.velocities[i]);
+            }
+        }
+
+        if (isVerlet)
+        {
+            this->contactCount = this->collisionGrid->UpdateVerletContacts(particles, this->neighborListSkin);
+        }
+        else
+        {
+            this->collisionGrid->Build(particles);
+            this->contactCount = this->collisionGrid->FindContacts(particles);
+        }
+
+        if (this->isParallelCollisions)
+        {
+            this->collisionGrid->ResolveContactsColored(particles);
+        }
+        else
+        {
+            this->collisionGrid->ResolveContacts(particles);
+        }
+        return;
+    }
+
+    // The grid covers every particle, including open-domain outliers the tree left out
+    if (isGrid)
+    {
+        this->collisionGrid->Build(particles);
+    }
+
+    // Pre-allocate reusable vector for collision detection (optimization)
+    std::vector<size_t> neighborsReusable;
+    neighborsReusable.reserve(32);
+
+    ContactBuffer& contacts = *this->contacts;
+    contacts.Clear();
+
+    // Handle bounding box constraints and contact generation
+    for (size_t k = 0; k < numTargets; k++)
+    {
+        size_t i = active ? (*active)[k] : k;
+
+        // Bounding box to keep particles in view
+        if (ENABLE_BOUNDING_BOX && !this->isOpenDomain)
+        {
+            ClampToViewport(particles.positions[i], particles.velocities[i]);
+        }
+
+        const glm::dvec2& posI = particles.positions[i];
+
+        neighborsReusable.clear();
+
+        if (isGrid)
+        {
+            // 3x3 cells of at least 2 * PARTICLE_RADIUS cover every possible contact
+            this->collisionGrid->QueryNeighbors(posI, neighborsReusable);
+        }
+        else
+        {
+            // Query a bounding box that roughly covers possible collisions.
+            double range = 2.0 * PARTICLE_RADIUS;
+            double xMin = posI.x - range;
+            double xMax = posI.x + range;
+            double yMin = posI.y - range;
+            double yMax = posI.y + range;
+
+            root->QueryRange(xMin, yMin, xMax, yMax, neighborsReusable);
+        }
+
+        // Keep each pair once: a pair of two targets is taken from its lower index
+        for (size_t j : neighborsReusable)
+        {
+            if (j == i || (j < i && (!activeMask || activeMask[j])))
+                continue;
+
+            glm::dvec2 d = particles.positions[j] - posI;
+            if (glm::dot(d, d) < 4.0 * PARTICLE_RADIUS * PARTICLE_RADIUS)
+            {
+                contacts.first.push_back((uint32_t)i);
+                contacts.second.push_back((uint32_t)j);
+            }
+        }
+    }
+
+    this->contactCount = contacts.first.size();
+
+    for (size_t c = 0; c < this->contactCount; ++c)
+    {
+        ResolveCollisionPair(particles, contacts.first[c], contacts.second[c]);
+    }
+}
+
+
+/**
+  * @brief  Build (or refit) the quadtree for the current particle positions
+  * @param  centerX
+  * @param  centerY
+  * @param  halfSize
+  * @retval QuadtreeNode* Root node (mass distribution not yet computed)
+  */
+QuadtreeNode* Simulation::BuildQuadtree(double centerX, double centerY, double halfSize)
+{
+    ParticleData& particles = *particleData;
+
+    // Persistent mode reuses last step's tree while few particles change leaf
+    if (this->isPersistentTree && this->persistentTree->Refit(particles, *nodePool))
+    {
+        return this->persistentTree->root;
+    }
+
+    // Reset pool and build quadtree (O(1) reset, no heap alloc per node)
+    nodePool->Reset();
+    QuadtreeNode* root = nullptr;
+
+    switch (this->treeBuildMode)
+    {
+        case TreeBuildMode::Recursive:      root = BuildQuadtreeRecursive(particles, *nodePool, centerX, centerY, halfSize); break;
+        case TreeBuildMode::Morton:         root = BuildQuadtreeMorton(particles, *nodePool, centerX, centerY, halfSize); break;
+        case TreeBuildMode::MortonParallel: root = BuildQuadtreeMortonParallel(particles, *nodePool, centerX, centerY, halfSize); break;
+    }
+
+    if (this->isPersistentTree)
+    {
+        this->persistentTree->Attach(root, particles, *nodePool);
+    }
+
+    return root;
+}
+
+
+/**
+  * @brief  Gravity to and from the open-domain outliers left outside the tree
+  * @param  root  Root of this step's tree
+  * @param  test  Opening test used by this step's walk
+  * @param  activeMask Optional per-particle flags (block timesteps); only flagged particles are updated
+  * @retval None
+  * @note   Track: each outlier gets the tree's pull from one Barnes-Hut walk (from far
+  *         away it accepts nodes near the root) and every particle, outliers included,
+  *         gets the outliers' pull by direct summation. At most OUTLIER_MAX_COUNT
+  *         outliers keep this O(N). Drop: outliers neither feel nor exert gravity.
+  */
+void Simulation::ApplyOutlierGravity(const QuadtreeNode* root, const OpeningTest& test, const uint8_t* activeMask)
+{
+    ParticleData& particles = *particleData;
+    const std::vector<uint32_t>& outliers = nodePool->domain.outliers;
+    int numParticles = (int)particles.Size();
+    size_t numOutliers = outliers.size();
+
+    // The tree solvers either skipped the outliers or walked them like everyone else
+    for (uint32_t o : outliers)
+    {
+        if (activeMask && !activeMask[o])
+            continue;
+
+        particles.accelerations[o] = (this->outlierPolicy == OutlierPolicy::Track)
+            ? ComputeForceBarnesHut(o, particles, root, test, this->multipoleOrder, nullptr, this->forcePrecision) / particles.masses[o]
+            : glm::dvec2(0.0);
+    }
+
+    if (this->outlierPolicy != OutlierPolicy::Track)
+        return;
+
+    // SoA copy for the SIMD kernel (an outlier's own entry contributes nothing to itself)
+    double x[OUTLIER_MAX_COUNT];
+    double y[OUTLIER_MAX_COUNT];
+    double mass[OUTLIER_MAX_COUNT];
+
+    for (size_t k = 0; k < numOutliers; ++k)
+    {
+        x[k]    = particles.positions[outliers[k]].x;
+        y[k]    = particles.positions[outliers[k]].y;
+        mass[k] = particles.masses[outliers[k]];
+    }
+
+    #pragma omp parallel for schedule(static) if(numParticles > 1000)
+    for (int i = 0; i < numParticles; ++i)
+    {
+        if (activeMask && !activeMask[i])
+            continue;
+
+        particles.accelerations[i] += AccumulateAccelerationSimd(particles.positions[i].x, particles.positions[i].y, x, y, mass, numOutliers);
+    }
+}
+
+
+/**
+  * @brief  Sort all particle arrays into Morton order so tree neighbours are memory neighbours
+  * @param  centerX
+  * @param  centerY
+  * @param  halfSize
+  * @retval None
+  */
+void Simulation::ReorderParticles(double centerX, double centerY, double halfSize)
+{
+    ParticleData& particles = *particleData;
+    size_t previousLayoutVersion = particles.layoutVersion;
+
+    // Leaves the Morton order in the pool's index buffer (no tree nodes are touched)
+    ComputeMortonOrder(particles, *nodePool, centerX, centerY, halfSize);
+
+    particles.Reorder(nodePool->sortedIndices);
+
+    // Anything else holding particle indices follows the permutation
+    this->persistentTree->Remap(nodePool->sortedIndices, previousLayoutVersion, particles);
+}
+
+
+/**
+  * @brief  Clamp a particle to the viewport [-1, 1], reflecting (and damping) its velocity
+  * @param  position
+  * @param  velocity
+  * @retval None
+  */
+static void ClampToViewport(glm::dvec2& position, glm::dvec2& velocity)
+{
+    for (int axis = 0; axis < 2; axis++)
+    {
+        if (std::abs(position[axis]) > 1.0)
+        {
+            // Clamp position
+            position[axis] = glm::sign(position[axis]) * 1.0;
+            // Invert (dampen) velocity along that axis
+            velocity[axis] *= -0.9;
+        }
+    }
+}
 
 
 
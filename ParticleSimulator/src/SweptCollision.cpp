@@ -0,0 +1,296 @@
+/**
+  ******************************************************************************
+  * @file    SweptCollision.cpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   Continuous (swept-sphere) collisions for fast movers
+  ******************************************************************************
+  * @attention
+  *
+  *
+  ******************************************************************************
+  */
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "SweptCollision.hpp"
+#include "Simulation.hpp"
+
+/* Global variables --------------------------------------------------------- */
+/* Private typedef ---------------------------------------------------------- */
+/* Private define ----------------------------------------------------------- */
+/* Private macro ------------------------------------------------------------ */
+/* Private variables -------------------------------------------------------- */
+/* Private function prototypes ---------------------------------------------- */
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Public Functions                                                           */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  SweptCollisionSolver constructor
+  * @retval None
+  */
+SweptCollisionSolver::SweptCollisionSolver()
+{
+    this->fastCount = 0;
+    this->hitCount  = 0;
+}
+
+
+/**
+  * @brief  Sweep the fast movers of the step that just drifted and resolve their impacts in time order
+  * @param  particles      Reference to particle data (SoA), after the drift
+  * @param  timeStep       Length of the step
+  * @param  speedThreshold Radii per step above which a particle is swept
+  * @retval size_t Impacts resolved
+  * @note   Each fast mover keeps its earliest impact against every particle whose path came
+  *         within contact distance of its own. The earliest of all is resolved first; then
+  *         the two particles involved, and every fast mover that was heading for one of them,
+  *         are swept again from that time. A fast mover takes at most SWEPT_MAX_IMPACTS
+  *         impacts per step. Ties go to the lower index, so the result is deterministic.
+  *         The cell list holds the end positions from before any impact; particles an impact
+  *         has moved since are tested from a separate list rather than through their cell.
+  */
+size_t SweptCollisionSolver::Resolve(ParticleData& particles, double timeStep, double speedThreshold)
+{
+    size_t numParticles = particles.Size();
+    double limit = speedThreshold * PARTICLE_RADIUS;
+    double maxDisplacement = 0.0;
+
+    this->fastParticles.clear();
+    this->fastCount = 0;
+    this->hitCount  = 0;
+
+    for (size_t i = 0; i < numParticles; ++i)
+    {
+        double displacement = glm::length(particles.velocities[i]) * timeStep;
+        if (displacement > limit)
+        {
+            this->fastParticles.push_back((uint32_t)i);
+            maxDisplacement = std::max(maxDisplacement, displacement);
+        }
+    }
+
+    this->fastCount = this->fastParticles.size();
+    if (this->fastCount == 0)
+        return 0;
+
+    // A particle's end point lies within its own displacement of anywhere on its path
+    double margin = 2.0 * PARTICLE_RADIUS + maxDisplacement;
+
+    this->grid.Build(particles);
+
+    this->movedParticles.clear();
+    this->movedMask.assign(numParticles, 0);
+
+    this->nextTimes.assign(this->fastCount, 0.0);
+    this->nextHits.assign(this->fastCount, SIZE_MAX);
+    this->impactCounts.assign(this->fastCount, 0);
+
+    for (size_t slot = 0; slot < this->fastCount; ++slot)
+    {
+        this->FindFirstImpact(particles, slot, 0.0, timeStep, margin);
+    }
+
+    while (true)
+    {
+        size_t first = SIZE_MAX;
+        for (size_t slot = 0; slot < this->fastCount; ++slot)
+        {
+            if (this->nextHits[slot] != SIZE_MAX && (first == SIZE_MAX || this->nextTimes[slot] < this->nextTimes[first]))
+                first = slot;
+        }
+
+        if (first == SIZE_MAX)
+            break;
+
+        size_t i = this->fastParticles[first];
+        size_t j = this->nextHits[first];
+        double time = this->nextTimes[first];
+
+        ResolveImpact(particles, i, j, time, timeStep);
+        this->hitCount++;
+
+        for (size_t moved : { i, j })
+        {
+            if (!this->movedMask[moved])
+            {
+                this->movedMask[moved] = 1;
+                this->movedParticles.push_back((uint32_t)moved);
+            }
+        }
+        this->impactCounts[first]++;
+
+        // Paths of i and j changed from this time on
+        for (size_t slot = 0; slot < this->fastCount; ++slot)
+        {
+            size_t particle = this->fastParticles[slot];
+            size_t target   = this->nextHits[slot];
+
+            if (particle == i || particle == j || target == i || target == j)
+                this->FindFirstImpact(particles, slot, time, timeStep, margin);
+        }
+    }
+
+    return this->hitCount;
+}
+
+
+/**
+  * @brief  Get the number of particles swept in the last step
+  * @retval size_t Fast movers
+  */
+size_t SweptCollisionSolver::GetFastCount() const
+{
+    return this->fastCount;
+}
+
+
+/**
+  * @brief  Get the number of impacts resolved in the last step
+  * @retval size_t Impacts
+  */
+size_t SweptCollisionSolver::GetHitCount() const
+{
+    return this->hitCount;
+}
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Private Functions                                                          */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  Earliest impact of a fast mover after a given time
+  * @param  particles Reference to particle data (SoA), after the drift
+  * @param  slot      Fast mover (index into fastParticles)
+  * @param  fromTime  Start of the sweep since the start of the step
+  * @param  timeStep  Length of the step
+  * @param  margin    Reach around the path (contact distance + largest displacement)
+  * @retval None
+  */
+void SweptCollisionSolver::FindFirstImpact(const ParticleData& particles, size_t slot, double fromTime, double timeStep, double margin)
+{
+    size_t i = this->fastParticles[slot];
+
+    this->nextTimes[slot] = timeStep;
+    this->nextHits[slot]  = SIZE_MAX;
+
+    if (this->impactCounts[slot] >= SWEPT_MAX_IMPACTS)
+        return;
+
+    // Rest of the path
+    glm::dvec2 end   = particles.positions[i];
+    glm::dvec2 start = end - particles.velocities[i] * (timeStep - fromTime);
+
+    this->candidates.clear();
+    this->grid.QueryRange(std::min(start.x, end.x) - margin, std::min(start.y, end.y) - margin,
+                          std::max(start.x, end.x) + margin, std::max(start.y, end.y) + margin, this->candidates);
+
+    // Particles moved by an impact are no longer where their cell says. Their new velocities can
+    // also carry them further than margin allows, so they are tested by their own path box instead
+    this->candidates.erase(std::remove_if(this->candidates.begin(), this->candidates.end(),
+                                          [this](size_t j) { return this->movedMask[j] != 0; }),
+                           this->candidates.end());
+
+    for (uint32_t moved : this->movedParticles)
+    {
+        glm::dvec2 movedEnd   = particles.positions[moved];
+        glm::dvec2 movedStart = movedEnd - particles.velocities[moved] * (timeStep - fromTime);
+
+        if (std::min(movedStart.x, movedEnd.x) <= std::max(start.x, end.x) + 2.0 * PARTICLE_RADIUS &&
+            std::max(movedStart.x, movedEnd.x) >= std::min(start.x, end.x) - 2.0 * PARTICLE_RADIUS &&
+            std::min(movedStart.y, movedEnd.y) <= std::max(start.y, end.y) + 2.0 * PARTICLE_RADIUS &&
+            std::max(movedStart.y, movedEnd.y) >= std::min(start.y, end.y) - 2.0 * PARTICLE_RADIUS)
+            this->candidates.push_back(moved);
+    }
+
+    for (size_t j : this->candidates)
+    {
+        if (j == i)
+            continue;
+
+        double time = TimeOfImpact(particles, i, j, fromTime, timeStep);
+        if (time >= 0.0 && (time < this->nextTimes[slot] || (time == this->nextTimes[slot] && j < this->nextHits[slot])))
+        {
+            this->nextTimes[slot] = time;
+            this->nextHits[slot]  = j;
+        }
+    }
+}
+
+
+/**
+  * @brief  First time after fromTime at which two particles touch, moving in straight lines
+  * @param  particles Reference to particle data (SoA), after the drift
+  * @param  i         First particle
+  * @param  j         Second particle
+  * @param  fromTime  Start of the sweep since the start of the step
+  * @param  timeStep  Length of the step
+  * @retval double Time since the start of the step, or -1 if they do not meet
+  * @note   Pairs already overlapping at fromTime are left to the discrete overlap test.
+  */
+double SweptCollisionSolver::TimeOfImpact(const ParticleData& particles, size_t i, size_t j, double fromTime, double timeStep)
+{
+    glm::dvec2 relativeVelocity = particles.velocities[j] - particles.velocities[i];
+    glm::dvec2 startOffset = (particles.positions[j] - particles.positions[i]) - relativeVelocity * (timeStep - fromTime);
+
+    // |startOffset + relativeVelocity t| = 2R
+    double a = glm::dot(relativeVelocity, relativeVelocity);
+    double b = glm::dot(startOffset, relativeVelocity);
+    double c = glm::dot(startOffset, startOffset) - 4.0 * PARTICLE_RADIUS * PARTICLE_RADIUS;
+
+    if (c <= 0.0 || b >= 0.0)
+        return -1.0;
+
+    double discriminant = b * b - a * c;
+    if (discriminant < 0.0)
+        return -1.0;
+
+    double time = fromTime + (-b - std::sqrt(discriminant)) / a;
+
+    return (time <= timeStep) ? time : -1.0;
+}
+
+
+/**
+  * @brief  Apply the collision impulse at the time of impact and finish the step on the new velocities
+  * @param  particles Reference to particle data (SoA), after the drift
+  * @param  i         First particle
+  * @param  j         Second particle
+  * @param  time      Time of impact since the start of the step
+  * @param  timeStep  Length of the step
+  * @retval None
+  * @note   Same impulse as ResolveCollisionPair (ApplyCollisionImpulse), without the overlap
+  *         push (they just touch).
+  */
+void SweptCollisionSolver::ResolveImpact(ParticleData& particles, size_t i, size_t j, double time, double timeStep)
+{
+    double remaining = timeStep - time;
+
+    // Positions at the impact
+    glm::dvec2 contactI = particles.positions[i] - particles.velocities[i] * remaining;
+    glm::dvec2 contactJ = particles.positions[j] - particles.velocities[j] * remaining;
+
+    ApplyCollisionImpulse(particles, i, j, glm::normalize(contactJ - contactI));
+
+    particles.positions[i] = contactI + particles.velocities[i] * remaining;
+    particles.positions[j] = contactJ + particles.velocities[j] * remaining;
+}
+
+
+
+/******************************** END OF FILE *********************************/
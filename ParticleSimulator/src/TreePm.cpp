@@ -0,0 +1,671 @@
+/**
+  ******************************************************************************
+  * @file    TreePm.cpp
+  * @author  Josh Haden
+  * @version V0.1.0
+  * @date    16 OCT 2026
+  * @brief   TreePM gravity (mesh long range, tree short range)
+  ******************************************************************************
+  * @attention
+  *
+  * The mesh spans the quadtree root plus at least one guard cell on each side,
+  * so every CIC/TSC stencil stays on the mesh. It sits in the corner of a grid twice its
+  * size, and the zero padding makes the FFT convolution non-periodic. The FFT
+  * is a plain radix-2 transform kept in this file, so there is no external
+  * dependency.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ----------------------------------------------------------------- */
+
+#include "PCH.hpp"
+
+#include "TreePm.hpp"
+#include "Simulation.hpp"
+#include "VectorMath.hpp"
+
+/* Global variables --------------------------------------------------------- */
+/* Private typedef ---------------------------------------------------------- */
+/* Private define ----------------------------------------------------------- */
+/* Private macro ------------------------------------------------------------ */
+/* Private variables -------------------------------------------------------- */
+/* Private function prototypes ---------------------------------------------- */
+
+static double ExactSplitFactor(double x);
+static int    StencilWeights(MeshAssignment assignment, double u, int meshSize, double* weights);
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Public Functions                                                           */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  TreePmSolver constructor
+  * @retval None
+  */
+TreePmSolver::TreePmSolver()
+{
+    this->assignment  = MeshAssignment::Tsc;
+    this->meshSize    = 0;
+    this->fftSize     = 0;
+    this->cellSize    = 0.0;
+    this->originX     = 0.0;
+    this->originY     = 0.0;
+    this->splitRadius = 0.0;
+
+    this->splitTableScale = 0.0;
+
+    // Sampled in (r / cutoff)^2; two zero entries past the cutoff absorb the clamped lookups
+    this->splitTable.assign(TREEPM_TABLE_SIZE + 2, 0.0);
+    for (size_t k = 0; k < TREEPM_TABLE_SIZE; ++k)
+    {
+        this->splitTable[k] = ExactSplitFactor(TREEPM_CUTOFF * std::sqrt((double)k / (double)TREEPM_TABLE_SIZE));
+    }
+}
+
+
+/**
+  * @brief  Overwrite every particle's acceleration with the TreePM gravity estimate
+  * @param  particles    Reference to particle data (SoA)
+  * @param  root         Root of a tree whose mass distribution has been computed
+  * @param  meshSize     Mesh cells per side (rounded down to a power of two in [TREEPM_MIN_MESH, TREEPM_MAX_MESH])
+  * @param  theta        Geometric opening angle of the short-range walk
+  * @param  interactions Optional counter of short-range pair and node terms (can be nullptr)
+  * @retval None
+  * @note   Particles outside the root (open-domain outliers) are left at zero; the simulation's
+  *         outlier pass replaces their acceleration.
+  */
+void TreePmSolver::ComputeAccelerations(ParticleData& particles, const QuadtreeNode* root, int meshSize, double theta, size_t* interactions)
+{
+    int numParticles = (int)particles.Size();
+
+    if (!root || root->totalMass <= 0.0)
+    {
+        #pragma omp parallel for if(numParticles > 1000)
+        for (int i = 0; i < numParticles; ++i)
+        {
+            particles.accelerations[i] = glm::dvec2(0.0);
+        }
+        return;
+    }
+
+    this->PrepareMesh(root, meshSize);
+    this->Deposit(particles, root);
+    this->SolveLongRange();
+    this->Interpolate(particles, root);
+
+    // Short range per group of nearby particles, one shared source list per group
+    this->groups.clear();
+    if (CollectForceGroups(root, this->groups) <= FORCE_GROUP_SIZE)
+    {
+        this->groups.push_back(root);
+    }
+
+    int    numGroups = (int)this->groups.size();
+    size_t count     = 0;
+
+    #pragma omp parallel reduction(+:count) if(numParticles > 1000)
+    {
+        std::vector<size_t> members;
+        std::vector<double> sourceX;
+        std::vector<double> sourceY;
+        std::vector<double> sourceMass;
+        members.reserve(FORCE_GROUP_SIZE);
+
+        #pragma omp for schedule(dynamic, 4)
+        for (int g = 0; g < numGroups; ++g)
+        {
+            members.clear();
+            CollectGroupMembers(this->groups[g], members);
+            if (members.empty())
+                continue;
+
+            double xMin = particles.positions[members[0]].x, xMax = xMin;
+            double yMin = particles.positions[members[0]].y, yMax = yMin;
+            for (size_t i : members)
+            {
+                xMin = std::min(xMin, particles.positions[i].x);
+                yMin = std::min(yMin, particles.positions[i].y);
+                xMax = std::max(xMax, particles.positions[i].x);
+                yMax = std::max(yMax, particles.positions[i].y);
+            }
+
+            sourceX.clear();
+            sourceY.clear();
+            sourceMass.clear();
+            this->BuildShortRangeList(root, xMin, yMin, xMax, yMax, theta, particles, sourceX, sourceY, sourceMass);
+
+            size_t numSources = sourceMass.size();
+
+            // The particle is in its own list; its zero offset contributes nothing
+            for (size_t i : members)
+            {
+                particles.accelerations[i] += AccumulateSplitAccelerationSimd(particles.positions[i].x, particles.positions[i].y,
+                    sourceX.data(), sourceY.data(), sourceMass.data(), numSources, this->splitTable.data(), this->splitTableScale, (int)TREEPM_TABLE_SIZE);
+                count += numSources - 1;
+            }
+        }
+    }
+
+    if (interactions)
+        *interactions += count;
+}
+
+
+/* Getters ------------------------------------------------------------------ */
+
+
+/**
+  * @brief  Mass deposit / force interpolation stencil
+  * @param  None
+  * @retval MeshAssignment
+  */
+MeshAssignment TreePmSolver::GetAssignment() const
+{
+    return this->assignment;
+}
+
+
+/* Setters ------------------------------------------------------------------ */
+
+
+/**
+  * @brief  Set the mass deposit / force interpolation stencil
+  * @param  assignment
+  * @retval None
+  */
+void TreePmSolver::SetAssignment(MeshAssignment assignment)
+{
+    this->assignment = assignment;
+}
+
+
+
+/******************************************************************************/
+/******************************************************************************/
+/* Private Functions                                                          */
+/******************************************************************************/
+/******************************************************************************/
+
+
+/**
+  * @brief  Fit the mesh to the root, rebuilding FFT tables and the kernel when the spacing changes
+  * @param  root
+  * @param  meshSize Requested cells per side
+  * @retval None
+  * @note   The kernel only depends on the spacing. An open-domain root that moves or shrinks
+  *         by less than half keeps the current spacing, so the kernel is not rebuilt every step.
+  */
+void TreePmSolver::PrepareMesh(const QuadtreeNode* root, int meshSize)
+{
+    int size = TREEPM_MIN_MESH;
+    while (size * 2 <= std::min(meshSize, TREEPM_MAX_MESH))
+        size *= 2;
+
+    // At least one guard cell on each side of the root
+    double cellSize = this->cellSize;
+    double fitted   = 2.0 * root->halfSize / (double)(size - 2);
+    if (size != this->meshSize || fitted > cellSize || fitted < 0.5 * cellSize)
+        cellSize = fitted;
+
+    this->originX = root->centerX - 0.5 * size * cellSize;
+    this->originY = root->centerY - 0.5 * size * cellSize;
+
+    if (size == this->meshSize && cellSize == this->cellSize)
+        return;
+
+    if (size != this->meshSize)
+    {
+        this->meshSize = size;
+        this->fftSize  = 2 * size;
+
+        size_t n = (size_t)this->fftSize;
+        int bits = 0;
+        while (((size_t)1 << bits) < n) ++bits;
+
+        this->bitReverse.resize(n);
+        for (size_t k = 0; k < n; ++k)
+        {
+            uint32_t reversed = 0;
+            for (int b = 0; b < bits; ++b)
+            {
+                reversed |= (uint32_t)((k >> b) & 1) << (bits - 1 - b);
+            }
+            this->bitReverse[k] = reversed;
+        }
+
+        this->twiddles.resize(n / 2);
+        for (size_t k = 0; k < n / 2; ++k)
+        {
+            double angle = -2.0 * MATH_PI_CONSTANT * (double)k / (double)n;
+            this->twiddles[k] = std::complex<double>(std::cos(angle), std::sin(angle));
+        }
+
+        this->grid.resize(n * n);
+        this->field.resize((size_t)size * size);
+    }
+
+    this->cellSize    = cellSize;
+    this->splitRadius = TREEPM_SPLIT_CELLS * cellSize;
+    this->splitTableScale = (double)TREEPM_TABLE_SIZE / (TREEPM_CUTOFF * TREEPM_CUTOFF * this->splitRadius * this->splitRadius);
+    this->BuildKernel();
+}
+
+
+/**
+  * @brief  Tabulate the long-range kernel on the padded grid and transform it
+  * @param  None
+  * @retval None
+  * @note   Cell (dx, dy) holds the acceleration at offset (dx, dy) cells from a unit mass,
+  *         x in the real part and y in the imaginary part. Both are real fields, so one
+  *         complex convolution yields both components.
+  */
+void TreePmSolver::BuildKernel()
+{
+    int n = this->fftSize;
+    int m = this->meshSize;
+
+    this->kernel.assign((size_t)n * n, std::complex<double>(0.0, 0.0));
+
+    #pragma omp parallel for
+    for (int iy = 0; iy < n; ++iy)
+    {
+        int dy = (iy < m) ? iy : iy - n;
+        if (dy == -m) continue;
+
+        for (int ix = 0; ix < n; ++ix)
+        {
+            int dx = (ix < m) ? ix : ix - n;
+            if (dx == -m || (dx == 0 && dy == 0)) continue;
+
+            double rx   = dx * this->cellSize;
+            double ry   = dy * this->cellSize;
+            double dist = std::sqrt(rx * rx + ry * ry);
+            double clamped = std::max(dist, MIN_INTERACTION_DISTANCE);
+
+            // Pulls towards the source, which sits at -r from the target
+            double f = (1.0 - ExactSplitFactor(dist / this->splitRadius)) / ((clamped * clamped + SOFTENING * SOFTENING) * dist);
+            this->kernel[(size_t)iy * n + ix] = std::complex<double>(-f * rx, -f * ry);
+        }
+    }
+
+    this->Fft2D(this->kernel, false, n);
+}
+
+
+/**
+  * @brief  Deposit particle masses onto the mesh (per-thread grids, then summed into the padded grid)
+  * @param  particles Reference to particle data (SoA)
+  * @param  root
+  * @retval None
+  */
+void TreePmSolver::Deposit(const ParticleData& particles, const QuadtreeNode* root)
+{
+    int    numParticles = (int)particles.Size();
+    int    m            = this->meshSize;
+    size_t cells        = (size_t)m * m;
+#ifdef _OPENMP
+    int    numThreads   = (numParticles > 1000) ? omp_get_max_threads() : 1;
+#else
+    int    numThreads   = 1;
+#endif
+    double invCell      = 1.0 / this->cellSize;
+    int    width        = (this->assignment == MeshAssignment::Cic) ? 2 : 3;
+
+    this->threadMass.assign(cells * numThreads, 0.0);
+
+    #pragma omp parallel num_threads(numThreads)
+    {
+#ifdef _OPENMP
+        double* mass = &this->threadMass[cells * omp_get_thread_num()];
+#else
+        double* mass = this->threadMass.data();
+#endif
+
+        #pragma omp for schedule(static)
+        for (int i = 0; i < numParticles; ++i)
+        {
+            const glm::dvec2& p = particles.positions[i];
+            if (!root->Contains(p.x, p.y))
+                continue;
+
+            double wx[3];
+            double wy[3];
+            int x0 = StencilWeights(this->assignment, (p.x - this->originX) * invCell - 0.5, m, wx);
+            int y0 = StencilWeights(this->assignment, (p.y - this->originY) * invCell - 0.5, m, wy);
+
+            for (int b = 0; b < width; ++b)
+            {
+                double* row = mass + (size_t)(y0 + b) * m + x0;
+                double  my  = particles.masses[i] * wy[b];
+                for (int a = 0; a < width; ++a)
+                {
+                    row[a] += my * wx[a];
+                }
+            }
+        }
+    }
+
+    int n = this->fftSize;
+
+    // Top half of the padded grid holds the mesh, the rest stays zero
+    #pragma omp parallel for
+    for (int iy = 0; iy < n; ++iy)
+    {
+        std::complex<double>* row = &this->grid[(size_t)iy * n];
+        std::fill(row, row + n, std::complex<double>(0.0, 0.0));
+
+        if (iy >= m) continue;
+
+        for (int ix = 0; ix < m; ++ix)
+        {
+            double sum = 0.0;
+            for (int t = 0; t < numThreads; ++t)
+            {
+                sum += this->threadMass[cells * t + (size_t)iy * m + ix];
+            }
+            row[ix] = std::complex<double>(sum, 0.0);
+        }
+    }
+}
+
+
+/**
+  * @brief  Convolve the mass grid with the kernel and store the long-range field per mesh cell
+  * @param  None
+  * @retval None
+  */
+void TreePmSolver::SolveLongRange()
+{
+    int    n     = this->fftSize;
+    int    m     = this->meshSize;
+    size_t total = (size_t)n * n;
+
+    // Only the first m rows carry mass
+    this->Fft2D(this->grid, false, m);
+
+    #pragma omp parallel for
+    for (int k = 0; k < (int)total; ++k)
+    {
+        const std::complex<double>& a = this->grid[k];
+        const std::complex<double>& b = this->kernel[k];
+        this->grid[k] = std::complex<double>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+    }
+
+    // Only the first m rows are read back
+    this->Fft2D(this->grid, true, m);
+
+    double scale = GRAVITATIONAL_CONSTANT / (double)total;
+
+    #pragma omp parallel for
+    for (int iy = 0; iy < m; ++iy)
+    {
+        for (int ix = 0; ix < m; ++ix)
+        {
+            const std::complex<double>& value = this->grid[(size_t)iy * n + ix];
+            this->field[(size_t)iy * m + ix] = glm::dvec2(value.real(), value.imag()) * scale;
+        }
+    }
+}
+
+
+/**
+  * @brief  Interpolate the long-range field to the particles (same stencil as the deposit)
+  * @param  particles Reference to particle data (SoA)
+  * @param  root
+  * @retval None
+  */
+void TreePmSolver::Interpolate(ParticleData& particles, const QuadtreeNode* root)
+{
+    int    numParticles = (int)particles.Size();
+    int    m            = this->meshSize;
+    double invCell      = 1.0 / this->cellSize;
+    int    width        = (this->assignment == MeshAssignment::Cic) ? 2 : 3;
+
+    #pragma omp parallel for schedule(static) if(numParticles > 1000)
+    for (int i = 0; i < numParticles; ++i)
+    {
+        const glm::dvec2& p = particles.positions[i];
+        glm::dvec2 acceleration(0.0);
+
+        if (root->Contains(p.x, p.y))
+        {
+            double wx[3];
+            double wy[3];
+            int x0 = StencilWeights(this->assignment, (p.x - this->originX) * invCell - 0.5, m, wx);
+            int y0 = StencilWeights(this->assignment, (p.y - this->originY) * invCell - 0.5, m, wy);
+
+            for (int b = 0; b < width; ++b)
+            {
+                const glm::dvec2* row = &this->field[(size_t)(y0 + b) * m + x0];
+                for (int a = 0; a < width; ++a)
+                {
+                    acceleration += (wx[a] * wy[b]) * row[a];
+                }
+            }
+        }
+
+        particles.accelerations[i] = acceleration;
+    }
+}
+
+
+/**
+  * @brief  Collect the short-range sources of a group: particles and accepted nodes within the cutoff
+  * @param  node       Current node
+  * @param  xMin       Group bounding box
+  * @param  yMin
+  * @param  xMax
+  * @param  yMax
+  * @param  theta      Geometric opening angle, measured from the node's center of mass to the group box
+  * @param  particles  Reference to particle data (SoA)
+  * @param  sourceX    Receives source positions and masses
+  * @param  sourceY
+  * @param  sourceMass
+  * @retval None
+  * @note   Monopole only, in double: the quadrupole and mixed-precision options do not apply here.
+  */
+void TreePmSolver::BuildShortRangeList(const QuadtreeNode* node, double xMin, double yMin, double xMax, double yMax, double theta, const ParticleData& particles,
+                                       std::vector<double>& sourceX, std::vector<double>& sourceY, std::vector<double>& sourceMass) const
+{
+    if (!node || node->totalMass <= 0.0)
+        return;
+
+    double cutoff = TREEPM_CUTOFF * this->splitRadius;
+
+    // Nothing in this node is within the cutoff of any member
+    double gapX = std::max(0.0, std::max(xMin - (node->centerX + node->halfSize), (node->centerX - node->halfSize) - xMax));
+    double gapY = std::max(0.0, std::max(yMin - (node->centerY + node->halfSize), (node->centerY - node->halfSize) - yMax));
+    if (gapX * gapX + gapY * gapY >= cutoff * cutoff)
+        return;
+
+    if (!node->children)
+    {
+        for (const QuadtreeNode* bucket = node; bucket; bucket = bucket->cold->overflow)
+        {
+            for (size_t k = 0; k < bucket->cold->particleCount; ++k)
+            {
+                size_t j = bucket->cold->particleIndices[k];
+                sourceX.push_back(particles.positions[j].x);
+                sourceY.push_back(particles.positions[j].y);
+                sourceMass.push_back(particles.masses[j]);
+            }
+        }
+        return;
+    }
+
+    double comGapX = std::max(0.0, std::max(xMin - node->centerOfMass.x, node->centerOfMass.x - xMax));
+    double comGapY = std::max(0.0, std::max(yMin - node->centerOfMass.y, node->centerOfMass.y - yMax));
+
+    if (node->halfSize * 2.0 < theta * std::sqrt(comGapX * comGapX + comGapY * comGapY))
+    {
+        sourceX.push_back(node->centerOfMass.x);
+        sourceY.push_back(node->centerOfMass.y);
+        sourceMass.push_back(node->totalMass);
+        return;
+    }
+
+    for (int c = 0; c < 4; ++c)
+    {
+        this->BuildShortRangeList(&node->children[c], xMin, yMin, xMax, yMax, theta, particles, sourceX, sourceY, sourceMass);
+    }
+}
+
+
+/**
+  * @brief  In-place radix-2 FFT of one contiguous line of fftSize values
+  * @param  data    Line to transform
+  * @param  inverse Use the conjugate twiddles (unscaled)
+  * @retval None
+  */
+void TreePmSolver::Fft(std::complex<double>* data, bool inverse) const
+{
+    size_t n    = (size_t)this->fftSize;
+    double sign = inverse ? -1.0 : 1.0;
+
+    for (size_t k = 0; k < n; ++k)
+    {
+        size_t r = this->bitReverse[k];
+        if (k < r) std::swap(data[k], data[r]);
+    }
+
+    for (size_t length = 2; length <= n; length <<= 1)
+    {
+        size_t half = length / 2;
+        size_t step = n / length;
+
+        for (size_t start = 0; start < n; start += length)
+        {
+            for (size_t k = 0; k < half; ++k)
+            {
+                // Written out to keep the complex product free of the compiler's NaN/inf checks
+                const std::complex<double>& w = this->twiddles[k * step];
+                double wr = w.real();
+                double wi = sign * w.imag();
+
+                std::complex<double>& a = data[start + k];
+                std::complex<double>& b = data[start + k + half];
+                double br = b.real() * wr - b.imag() * wi;
+                double bi = b.real() * wi + b.imag() * wr;
+
+                b = std::complex<double>(a.real() - br, a.imag() - bi);
+                a = std::complex<double>(a.real() + br, a.imag() + bi);
+            }
+        }
+    }
+}
+
+
+/**
+  * @brief  2D FFT of the padded grid (rows, then columns; columns, then rows for the inverse)
+  * @param  data       fftSize x fftSize grid, row-major
+  * @param  inverse
+  * @param  activeRows Rows that are non-zero on input (forward) or needed on output (inverse)
+  * @retval None
+  * @note   Columns are copied out TREEPM_FFT_COLUMN_BLOCK at a time, so each copy reads
+  *         whole cache lines instead of one value per row.
+  */
+void TreePmSolver::Fft2D(std::vector<std::complex<double>>& data, bool inverse, int activeRows)
+{
+    int n         = this->fftSize;
+    int numBlocks = n / TREEPM_FFT_COLUMN_BLOCK;
+
+    #pragma omp parallel
+    {
+        std::vector<std::complex<double>> columns((size_t)n * TREEPM_FFT_COLUMN_BLOCK);
+
+        if (!inverse)
+        {
+            #pragma omp for
+            for (int row = 0; row < activeRows; ++row)
+            {
+                this->Fft(&data[(size_t)row * n], false);
+            }
+        }
+
+        #pragma omp for
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            size_t first = (size_t)block * TREEPM_FFT_COLUMN_BLOCK;
+
+            for (int row = 0; row < n; ++row)
+            {
+                for (int c = 0; c < TREEPM_FFT_COLUMN_BLOCK; ++c)
+                {
+                    columns[(size_t)c * n + row] = data[(size_t)row * n + first + c];
+                }
+            }
+
+            for (int c = 0; c < TREEPM_FFT_COLUMN_BLOCK; ++c)
+            {
+                this->Fft(&columns[(size_t)c * n], inverse);
+            }
+
+            // The inverse only reads back the first activeRows rows
+            int rows = inverse ? activeRows : n;
+            for (int row = 0; row < rows; ++row)
+            {
+                for (int c = 0; c < TREEPM_FFT_COLUMN_BLOCK; ++c)
+                {
+                    data[(size_t)row * n + first + c] = columns[(size_t)c * n + row];
+                }
+            }
+        }
+
+        if (inverse)
+        {
+            #pragma omp for
+            for (int row = 0; row < activeRows; ++row)
+            {
+                this->Fft(&data[(size_t)row * n], true);
+            }
+        }
+    }
+}
+
+
+/**
+  * @brief  Gadget's short-range force factor erfc(x / 2) + x / sqrt(pi) exp(-x^2 / 4), x = r / rs
+  * @param  x
+  * @retval double
+  */
+static double ExactSplitFactor(double x)
+{
+    return std::erfc(0.5 * x) + x / std::sqrt(MATH_PI_CONSTANT) * std::exp(-0.25 * x * x);
+}
+
+
+/**
+  * @brief  Mesh weights along one axis
+  * @param  assignment
+  * @param  u          Position in cells, relative to the center of cell 0
+  * @param  meshSize
+  * @param  weights    Weights for cells first..first+2 (CIC only fills two)
+  * @retval int        First cell of the stencil
+  */
+static int StencilWeights(MeshAssignment assignment, double u, int meshSize, double* weights)
+{
+    if (assignment == MeshAssignment::Cic)
+    {
+        int first = std::max(0, std::min((int)std::floor(u), meshSize - 2));
+        double f  = std::max(0.0, std::min(u - first, 1.0));
+        weights[0] = 1.0 - f;
+        weights[1] = f;
+        weights[2] = 0.0;
+        return first;
+    }
+
+    int nearest = std::max(1, std::min((int)std::floor(u + 0.5), meshSize - 2));
+    double d    = std::max(-0.5, std::min(u - nearest, 0.5));
+    weights[0] = 0.5 * (0.5 - d) * (0.5 - d);
+    weights[1] = 0.75 - d * d;
+    weights[2] = 0.5 * (0.5 + d) * (0.5 + d);
+    return nearest - 1;
+}
+
+/******************************** END OF FILE *********************************/